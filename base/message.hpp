@@ -21,10 +21,26 @@ static const char* FlagName[] = {
   "kOthers"
 };
 
+/*
+ * Control traffic (progress reports, version updates, scheduling commands)
+ * has its own sending lane so that it never waits behind bulk traffic
+ * (shuffle data, migration, fetch replies).
+ * The order is only kept among the messages of the same class.
+ */
+enum class TrafficClass : char {
+  kControl,
+  kBulk
+};
+static const char* TrafficClassName[] = {
+  "kControl",
+  "kBulk"
+};
+
 struct Meta {
   int sender;
   int recver;
   Flag flag;
+  TrafficClass traffic_class = TrafficClass::kBulk;
 
   std::string DebugString() const {
     std::stringstream ss;
@@ -32,6 +48,7 @@ struct Meta {
     ss << "sender: " << sender;
     ss << ", recver: " << recver;
     ss << ", flag: " << FlagName[static_cast<int>(flag)];
+    ss << ", traffic_class: " << TrafficClassName[static_cast<int>(traffic_class)];
     ss << "}";
     return ss.str();
   }
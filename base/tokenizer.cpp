@@ -0,0 +1,250 @@
+#include "base/tokenizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+namespace {
+
+inline bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool IsDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+// skip the whitespace, return false if nothing is left
+inline bool SkipSpaces(const char **p, const char *end) {
+  while (*p != end && IsSpace(**p)) {
+    ++*p;
+  }
+  return *p != end;
+}
+
+// skip the leading zeros so that they do not count as significant digits,
+// return whether there are any
+inline bool SkipZeros(const char **p, const char *end) {
+  const char *start = *p;
+  while (*p != end && **p == '0') {
+    ++*p;
+  }
+  return *p != start;
+}
+
+// accumulate the digits at *p into *value, return the # digits, the digits
+// beyond 19 are counted but dropped, see ParseDouble
+inline int ParseDigits(const char **p, const char *end, uint64_t *value) {
+  const char *start = *p;
+  uint64_t x = *value;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (end - *p >= 8 && *p - start <= 11) {
+    uint64_t chunk;
+    memcpy(&chunk, *p, 8);
+    // all the 8 bytes are in ['0', '9']
+    if ((chunk & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL ||
+        ((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) !=
+            0x3030303030303030ULL) {
+      break;
+    }
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+    chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+    chunk = (chunk * 10000 + (chunk >> 32)) & 0x00000000FFFFFFFFULL;
+    x = x * 100000000ULL + chunk;
+    *p += 8;
+  }
+#endif
+  while (*p != end && IsDigit(**p)) {
+    if (*p - start < 19) {
+      x = x * 10 + (**p - '0');
+    }
+    ++*p;
+  }
+  *value = x;
+  return *p - start;
+}
+
+// a number ends at whitespace, or at ':' in libsvm
+inline bool IsDelimiter(const char *p, const char *end) {
+  return p == end || IsSpace(*p) || *p == ':';
+}
+
+std::string TokenAt(const char *p, const char *end) {
+  const char *q = p;
+  while (q != end && !IsSpace(*q)) {
+    ++q;
+  }
+  return std::string(p, q);
+}
+
+bool ParseInt64(boost::string_ref *s, long long *v) {
+  const char *p = s->data();
+  const char *end = p + s->size();
+  if (!SkipSpaces(&p, end)) {
+    *s = boost::string_ref();
+    return false;
+  }
+  const char *start = p;
+  bool negative = false;
+  if (*p == '-' || *p == '+') {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t x = 0;
+  const bool has_zeros = SkipZeros(&p, end);
+  int num_digits = ParseDigits(&p, end, &x);
+  CHECK((has_zeros || num_digits > 0) && num_digits <= 19 && IsDelimiter(p, end) &&
+        x <= static_cast<uint64_t>(std::numeric_limits<long long>::max()) + negative)
+      << "not an integer: " << TokenAt(start, end);
+  *v = negative ? static_cast<long long>(0 - x) : static_cast<long long>(x);
+  *s = boost::string_ref(p, end - p);
+  return true;
+}
+
+// the powers of 10 exact in double
+const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+bool ParseDouble(boost::string_ref *s, double *v) {
+  const char *p = s->data();
+  const char *end = p + s->size();
+  if (!SkipSpaces(&p, end)) {
+    *s = boost::string_ref();
+    return false;
+  }
+  const char *start = p;
+  bool negative = false;
+  if (*p == '-' || *p == '+') {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  // the significant integer digits
+  const bool has_zeros = SkipZeros(&p, end);
+  int num_int_digits = ParseDigits(&p, end, &mantissa);
+  int num_frac_digits = 0;
+  if (p != end && *p == '.') {
+    ++p;
+    const char *frac_start = p;
+    // continue the mantissa, only the first 19 significant digits are kept
+    int num_kept = std::min(num_int_digits, 19);
+    while (p != end && IsDigit(*p)) {
+      if (mantissa == 0 && *p == '0') {
+        ++num_frac_digits;
+      } else if (num_kept < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        ++num_kept;
+        ++num_frac_digits;
+      }
+      ++p;
+    }
+    CHECK(has_zeros || num_int_digits > 0 || p != frac_start)
+        << "not a number: " << TokenAt(start, end);
+  } else {
+    CHECK(has_zeros || num_int_digits > 0) << "not a number: " << TokenAt(start, end);
+  }
+  int exponent = 0;
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool exp_negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+      exp_negative = *p == '-';
+      ++p;
+    }
+    uint64_t e = 0;
+    const bool has_exp_zeros = SkipZeros(&p, end);
+    int num_exp_digits = ParseDigits(&p, end, &e);
+    CHECK((has_exp_zeros || num_exp_digits > 0) && num_exp_digits <= 5 && e < 100000)
+        << "not a number: " << TokenAt(start, end);
+    exponent = exp_negative ? -static_cast<int>(e) : static_cast<int>(e);
+  }
+  CHECK(IsDelimiter(p, end)) << "not a number: " << TokenAt(start, end);
+
+  // the integer digits dropped beyond 19 scale it up
+  exponent += std::max(num_int_digits - 19, 0) - num_frac_digits;
+  double x;
+  if (mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+    // exact operands, a correctly rounded result
+    x = exponent >= 0 ? mantissa * kPow10[exponent] : mantissa / kPow10[-exponent];
+  } else {
+    x = std::strtod(std::string(start, p).c_str(), nullptr);
+    negative = false;
+  }
+  *v = negative ? -x : x;
+  *s = boost::string_ref(p, end - p);
+  return true;
+}
+
+}  // namespace
+
+bool NextInt(boost::string_ref *s, long long *v) {
+  return ParseInt64(s, v);
+}
+
+bool NextInt(boost::string_ref *s, int *v) {
+  long long x;
+  if (!ParseInt64(s, &x)) {
+    return false;
+  }
+  CHECK(x >= std::numeric_limits<int>::min() && x <= std::numeric_limits<int>::max())
+      << "out of the range of int: " << x;
+  *v = x;
+  return true;
+}
+
+bool NextFloat(boost::string_ref *s, double *v) {
+  return ParseDouble(s, v);
+}
+
+bool NextFloat(boost::string_ref *s, float *v) {
+  double x;
+  if (!ParseDouble(s, &x)) {
+    return false;
+  }
+  *v = x;
+  return true;
+}
+
+size_t ParseInts(boost::string_ref s, std::vector<int> *v) {
+  size_t n = 0;
+  int x;
+  while (NextInt(&s, &x)) {
+    v->push_back(x);
+    n += 1;
+  }
+  return n;
+}
+
+size_t ParseFloats(boost::string_ref s, std::vector<float> *v) {
+  size_t n = 0;
+  float x;
+  while (NextFloat(&s, &x)) {
+    v->push_back(x);
+    n += 1;
+  }
+  return n;
+}
+
+float ParseLibsvm(boost::string_ref s, std::vector<std::pair<int, float>> *features) {
+  float label;
+  CHECK(NextFloat(&s, &label)) << "no label";
+  int idx;
+  float val;
+  while (NextInt(&s, &idx)) {
+    CHECK(!s.empty() && s[0] == ':') << "no value for feature " << idx;
+    s.remove_prefix(1);
+    CHECK(NextFloat(&s, &val)) << "no value for feature " << idx;
+    features->push_back(std::make_pair(idx, val));
+  }
+  return label;
+}
+
+} // namespace xyz
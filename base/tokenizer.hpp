@@ -0,0 +1,41 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "boost/utility/string_ref.hpp"
+
+namespace xyz {
+
+/*
+ * Parse the numbers separated by whitespace (' ', '\t', '\r', '\n') in a
+ * line without allocating, use it with a Context::load taking a
+ * boost::string_ref, e.g.
+ *
+ * Context::load(url, [](boost::string_ref line) {
+ *   Vertex v;
+ *   CHECK(NextInt(&line, &v.id));
+ *   ParseInts(line, &v.outlinks);
+ *   return v;
+ * });
+ *
+ * The digits are converted 8 at a time (SWAR) on little-endian machines.
+ * A malformed number fails a CHECK, as std::stoi would throw.
+ */
+
+// Skip the whitespace and parse the next number, *s is advanced past it,
+// return false if only whitespace is left.
+bool NextInt(boost::string_ref *s, int *v);
+bool NextInt(boost::string_ref *s, long long *v);
+bool NextFloat(boost::string_ref *s, float *v);
+bool NextFloat(boost::string_ref *s, double *v);
+
+// Append all the numbers in s to v, return the # numbers appended.
+size_t ParseInts(boost::string_ref s, std::vector<int> *v);
+size_t ParseFloats(boost::string_ref s, std::vector<float> *v);
+
+// Parse a libsvm line "label idx:val idx:val ...", the features are
+// appended to features as they are, return the label.
+float ParseLibsvm(boost::string_ref s, std::vector<std::pair<int, float>> *features);
+
+} // namespace xyz
@@ -0,0 +1,117 @@
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "boost/tokenizer.hpp"
+
+#include "base/color.hpp"
+#include "base/tokenizer.hpp"
+
+DEFINE_int32(num_lines, 1000000, "# lines of each input");
+DEFINE_int32(num_per_line, 20, "# numbers per line");
+DEFINE_int32(max_id, 100000000, "the ids are in [0, max_id)");
+
+using namespace xyz;
+
+namespace {
+
+template <typename F>
+long long TimeMs(F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+void Report(std::string name, long long boost_ms, long long ms, size_t bytes) {
+  LOG(INFO) << name << ": boost::tokenizer " << boost_ms << " ms, tokenizer " << ms
+            << " ms, " << GREEN(std::to_string(bytes / 1000 / std::max<long long>(ms, 1)) + " MB/s")
+            << ", speedup " << double(boost_ms) / std::max<long long>(ms, 1);
+}
+
+}  // namespace
+
+/*
+ * Compare the parsing in the examples (boost::tokenizer + std::stoi/stof)
+ * with base/tokenizer.hpp on generated adjacency lists ("id n id id ...")
+ * and libsvm lines ("label idx:val ...").
+ *
+ * ./TokenizerBenchMain --num_lines=1000000 --num_per_line=20
+ */
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> id_dist(0, FLAGS_max_id - 1);
+  std::uniform_real_distribution<float> val_dist(-1, 1);
+  std::vector<std::string> graph_lines, libsvm_lines;
+  size_t graph_bytes = 0, libsvm_bytes = 0;
+  for (int i = 0; i < FLAGS_num_lines; ++i) {
+    std::string line = std::to_string(id_dist(gen)) + " " + std::to_string(FLAGS_num_per_line);
+    std::string libsvm_line = std::to_string(i % 2);
+    for (int j = 0; j < FLAGS_num_per_line; ++j) {
+      line += " " + std::to_string(id_dist(gen));
+      libsvm_line += " " + std::to_string(id_dist(gen)) + ":" + std::to_string(val_dist(gen));
+    }
+    graph_bytes += line.size();
+    libsvm_bytes += libsvm_line.size();
+    graph_lines.push_back(std::move(line));
+    libsvm_lines.push_back(std::move(libsvm_line));
+  }
+
+  // the vectors are reused to time the parsing only
+  std::vector<int> ids;
+  long long boost_sum = 0, sum = 0;
+  auto boost_ms = TimeMs([&]() {
+    for (auto &s : graph_lines) {
+      ids.clear();
+      boost::char_separator<char> sep(" \t");
+      boost::tokenizer<boost::char_separator<char>> tok(s, sep);
+      for (auto it = tok.begin(); it != tok.end(); ++it) {
+        ids.push_back(std::stoi(*it));
+      }
+      boost_sum += ids.back();
+    }
+  });
+  auto ms = TimeMs([&]() {
+    for (auto &s : graph_lines) {
+      ids.clear();
+      ParseInts(s, &ids);
+      sum += ids.back();
+    }
+  });
+  CHECK_EQ(boost_sum, sum);
+  Report("ints", boost_ms, ms, graph_bytes);
+
+  std::vector<std::pair<int, float>> features;
+  double boost_fsum = 0, fsum = 0;
+  boost_ms = TimeMs([&]() {
+    for (auto &s : libsvm_lines) {
+      features.clear();
+      boost::char_separator<char> sep(" \t:");
+      boost::tokenizer<boost::char_separator<char>> tok(s, sep);
+      auto it = tok.begin();
+      float label = std::stof(*it++);
+      while (it != tok.end()) {
+        int idx = std::stoi(*it++);
+        features.push_back(std::make_pair(idx, std::stof(*it++)));
+      }
+      boost_fsum += label + features.back().second;
+    }
+  });
+  ms = TimeMs([&]() {
+    for (auto &s : libsvm_lines) {
+      features.clear();
+      float label = ParseLibsvm(s, &features);
+      fsum += label + features.back().second;
+    }
+  });
+  CHECK_EQ(boost_fsum, fsum);
+  Report("libsvm", boost_ms, ms, libsvm_bytes);
+  return 0;
+}
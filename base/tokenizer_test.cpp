@@ -0,0 +1,103 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "base/tokenizer.hpp"
+
+namespace xyz {
+namespace {
+
+class TestTokenizer : public testing::Test {};
+
+TEST_F(TestTokenizer, NextInt) {
+  boost::string_ref s(" 12\t-3  +45 123456789 2147483647 -2147483648\r\n");
+  std::vector<int> expected{12, -3, 45, 123456789, 2147483647, -2147483648};
+  int v;
+  for (int e : expected) {
+    ASSERT_TRUE(NextInt(&s, &v));
+    EXPECT_EQ(v, e);
+  }
+  EXPECT_FALSE(NextInt(&s, &v));
+  EXPECT_TRUE(s.empty());
+}
+
+TEST_F(TestTokenizer, NextInt64) {
+  // the 8-digit chunks
+  boost::string_ref s("1234567812345678 9223372036854775807 -9223372036854775808 0012345678");
+  long long v;
+  ASSERT_TRUE(NextInt(&s, &v));
+  EXPECT_EQ(v, 1234567812345678LL);
+  ASSERT_TRUE(NextInt(&s, &v));
+  EXPECT_EQ(v, 9223372036854775807LL);
+  ASSERT_TRUE(NextInt(&s, &v));
+  EXPECT_EQ(v, -9223372036854775807LL - 1);
+  ASSERT_TRUE(NextInt(&s, &v));
+  EXPECT_EQ(v, 12345678);
+  EXPECT_FALSE(NextInt(&s, &v));
+}
+
+TEST_F(TestTokenizer, NextIntZeroPadded) {
+  // the leading zeros are not significant digits
+  boost::string_ref s("0000000000000000000012345 -00000000009223372036854775808 000 -0");
+  long long v;
+  ASSERT_TRUE(NextInt(&s, &v));
+  EXPECT_EQ(v, 12345);
+  ASSERT_TRUE(NextInt(&s, &v));
+  EXPECT_EQ(v, -9223372036854775807LL - 1);
+  ASSERT_TRUE(NextInt(&s, &v));
+  EXPECT_EQ(v, 0);
+  ASSERT_TRUE(NextInt(&s, &v));
+  EXPECT_EQ(v, 0);
+  EXPECT_FALSE(NextInt(&s, &v));
+}
+
+TEST_F(TestTokenizer, ParseInts) {
+  std::vector<int> v{7};
+  EXPECT_EQ(ParseInts("1 2 3", &v), 3);
+  EXPECT_EQ(v, std::vector<int>({7, 1, 2, 3}));
+  EXPECT_EQ(ParseInts("   ", &v), 0);
+  EXPECT_EQ(ParseInts("", &v), 0);
+}
+
+TEST_F(TestTokenizer, NextFloat) {
+  const char* tokens[] = {"0", "1.5", "-0.25", "3.", ".5", "1e3", "-2.5E-3",
+      "123456.789", "0.000000000000000000001234", "12345678901234567890123",
+      "1e-30", "3.14159265358979323846"};
+  std::string line;
+  for (auto t : tokens) {
+    line += std::string(t) + " ";
+  }
+  boost::string_ref s(line);
+  double v;
+  for (auto t : tokens) {
+    ASSERT_TRUE(NextFloat(&s, &v));
+    EXPECT_DOUBLE_EQ(v, std::strtod(t, nullptr)) << t;
+  }
+  EXPECT_FALSE(NextFloat(&s, &v));
+
+  // zero padded, the same double as strtod
+  const char* padded[] = {"0001924.050869006751751", "-000585754364076150761",
+      "00000000000000000000001.5", "000.000123", "-00.0", "1e0005",
+      "0000000000000000000012345678901234567890123.25"};
+  for (auto t : padded) {
+    boost::string_ref ps(t);
+    ASSERT_TRUE(NextFloat(&ps, &v));
+    EXPECT_EQ(v, std::strtod(t, nullptr)) << t;
+  }
+
+  std::vector<float> floats;
+  EXPECT_EQ(ParseFloats("0.1 2 -3.5", &floats), 3);
+  EXPECT_EQ(floats, std::vector<float>({0.1f, 2.f, -3.5f}));
+}
+
+TEST_F(TestTokenizer, ParseLibsvm) {
+  std::vector<std::pair<int, float>> features;
+  EXPECT_EQ(ParseLibsvm("-1 3:0.5 10:2 123:-1e-2\n", &features), -1);
+  std::vector<std::pair<int, float>> expected{{3, 0.5f}, {10, 2.f}, {123, -0.01f}};
+  EXPECT_EQ(features, expected);
+  features.clear();
+  EXPECT_EQ(ParseLibsvm("0.5", &features), 0.5);
+  EXPECT_TRUE(features.empty());
+}
+
+}  // namespace
+}  // namespace xyz
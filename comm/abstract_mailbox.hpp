@@ -8,6 +8,9 @@ class AbstractMailbox {
 public:
   virtual ~AbstractMailbox() = default;
   virtual int Send(const Message &msg) = 0;
+  // Push the msg into the queue directly if the recver is in this process.
+  // Return false if it needs to be sent.
+  virtual bool TrySendLocal(Message *msg) { return false; }
 };
 
 } // namespace xyz
@@ -16,8 +16,15 @@ SArrayBinStream &operator>>(xyz::SArrayBinStream &stream, Control &ctrl) {
   return stream;
 }
 
-BasicMailbox::BasicMailbox(Node scheduler_node)
-    : scheduler_node_(scheduler_node) {}
+BasicMailbox::BasicMailbox(Node scheduler_node, int num_io_threads,
+                           int num_recv_sockets, bool separate_bulk_sockets,
+                           bool use_ipc)
+    : scheduler_node_(scheduler_node), num_io_threads_(num_io_threads),
+      num_recv_sockets_(num_recv_sockets),
+      num_lanes_(separate_bulk_sockets ? 2 : 1), use_ipc_(use_ipc) {
+  CHECK_GT(num_io_threads_, 0);
+  CHECK_GT(num_recv_sockets_, 0);
+}
 
 BasicMailbox::~BasicMailbox() {}
 
@@ -51,6 +58,7 @@ void BasicMailbox::Stop() {
   int ret = Send(exit);
   CHECK_NE(ret, -1);
   receiver_thread_.join();
+  StopDataReceivers();
   // close sockets
   CloseSockets();
   LOG(INFO) << my_node_.DebugString() << " is stopped";
@@ -60,17 +68,58 @@ void BasicMailbox::Stop() {
 
 // return # of bytes sended
 int BasicMailbox::Send(const Message &msg) {
-  std::lock_guard<std::mutex> lk(mu_);
-  // find the socket
   int recver_id = msg.meta.flag == Flag::kOthers ? GetNodeId(msg.meta.recver)
                                                  : msg.meta.recver; // TODO
+  return SendTo(recver_id, GetRecvSocketIdx(msg), msg);
+}
+
+bool BasicMailbox::TrySendLocal(Message *msg) {
+  if (!ready_.load() || msg->meta.flag != Flag::kOthers ||
+      GetNodeId(msg->meta.recver) != my_node_.id) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = queue_map_.find(msg->meta.recver);
+  if (it == queue_map_.end()) {
+    return false;
+  }
+  it->second->Push(std::move(*msg));
+  return true;
+}
+
+int BasicMailbox::GetRecvSocketIdx(const Message &msg) const {
+  // mailbox control messages always go to socket 0.
+  // Otherwise spread over the receive sockets and keep the order
+  // between one node and one queue.
+  if (num_recv_sockets_ == 1 || msg.meta.flag != Flag::kOthers) {
+    return 0;
+  }
+  int my_id = my_node_.id == Node::kEmpty ? 0 : my_node_.id;
+  return (my_id + msg.meta.recver) % num_recv_sockets_;
+}
+
+int BasicMailbox::GetLane(const Message &msg) const {
+  if (num_lanes_ == 1 || msg.meta.flag != Flag::kOthers ||
+      msg.meta.traffic_class == TrafficClass::kControl) {
+    return 0;
+  }
+  return 1;
+}
+
+int BasicMailbox::SendTo(int recver_id, int recv_socket_idx,
+                         const Message &msg) {
+  // find the socket
+  boost::shared_lock<boost::shared_mutex> map_lk(senders_mu_);
   auto it = senders_.find(recver_id);
   if (it == senders_.end()) {
     LOG(WARNING) << "there is no socket to node " << recver_id;
     LOG(INFO) << msg.DebugString();
     return -1;
   }
-  void *socket = it->second;
+  int socket_idx = GetLane(msg) * num_recv_sockets_ + recv_socket_idx;
+  CHECK_LT(socket_idx, it->second.size());
+  SenderSocket *sender = it->second[socket_idx].get();
+  std::lock_guard<std::mutex> socket_lk(sender->mu);
 
   // send meta
   int meta_size = sizeof(Meta);
@@ -78,55 +127,57 @@ int BasicMailbox::Send(const Message &msg) {
   int num_data = msg.data.size();
   if (num_data == 0)
     tag = 0;
-  char *meta_buf = new char[meta_size];
-  memcpy(meta_buf, &msg.meta, meta_size);
-  zmq_msg_t meta_msg;
-  zmq_msg_init_data(&meta_msg, meta_buf, meta_size, FreeData, NULL);
-  while (true) {
-    if (zmq_msg_send(&meta_msg, socket, tag) == meta_size)
-      break;
-    if (errno == EINTR)
-      continue;
+  SendSlot *meta_slot = slot_pool_.Get();
+  memcpy(meta_slot->meta, &msg.meta, meta_size);
+  if (SendFrame(sender->socket, meta_slot->meta, meta_size, meta_slot, tag) == -1) {
     LOG(WARNING) << "failed to send message to node [" << recver_id
                  << "] errno: " << errno << " " << zmq_strerror(errno);
     return -1;
   }
-  zmq_msg_close(&meta_msg);
   int send_bytes = meta_size;
 
-  // send data
+  // send data, the slot keeps the SArray buffer alive until zmq is done
   for (int i = 0; i < num_data; ++i) {
-    zmq_msg_t data_msg;
-    third_party::SArray<char> *data =
-        new third_party::SArray<char>(msg.data[i]);
-    int data_size = data->size();
-    zmq_msg_init_data(&data_msg, data->data(), data->size(), FreeData, data);
+    SendSlot *data_slot = slot_pool_.Get();
+    data_slot->ref = msg.data[i].ptr();
+    int data_size = msg.data[i].size();
     if (i == num_data - 1)
       tag = 0;
-    while (true) {
-      if (zmq_msg_send(&data_msg, socket, tag) == data_size)
-        break;
-      if (errno == EINTR)
-        continue;
+    if (SendFrame(sender->socket, msg.data[i].data(), data_size, data_slot, tag) == -1) {
       LOG(WARNING) << "failed to send message to node [" << recver_id
                    << "] errno: " << errno << " " << zmq_strerror(errno) << ". "
                    << i << "/" << num_data;
       return -1;
     }
-    zmq_msg_close(&data_msg);
     send_bytes += data_size;
   }
   return send_bytes;
 }
 
-int BasicMailbox::Recv(Message *msg) {
+int BasicMailbox::SendFrame(void *socket, void *data, int size, SendSlot *slot,
+                            int tag) {
+  zmq_msg_t zmsg;
+  zmq_msg_init_data(&zmsg, data, size, FreeSlot, slot);
+  while (true) {
+    if (zmq_msg_send(&zmsg, socket, tag) == size)
+      return size;
+    if (errno == EINTR)
+      continue;
+    // give the slot back
+    zmq_msg_close(&zmsg);
+    return -1;
+  }
+}
+
+int BasicMailbox::Recv(Message *msg, int recv_socket_idx) {
+  void *receiver = receivers_[recv_socket_idx];
   msg->data.clear();
   size_t recv_bytes = 0;
   for (int i = 0;; ++i) {
     zmq_msg_t *zmsg = new zmq_msg_t;
     CHECK(zmq_msg_init(zmsg) == 0) << zmq_strerror(errno);
     while (true) {
-      if (zmq_msg_recv(zmsg, receiver_, 0) != -1)
+      if (zmq_msg_recv(zmsg, receiver, 0) != -1)
         break;
       if (errno == EINTR)
         continue;
@@ -187,11 +238,67 @@ void BasicMailbox::Barrier() {
   }
 }
 
+void BasicMailbox::StartDataReceivers() {
+  for (int i = 1; i < num_recv_sockets_; ++i) {
+    data_receiver_threads_.push_back(
+        std::thread(&BasicMailbox::DataReceiving, this, i));
+  }
+}
+
+void BasicMailbox::DataReceiving(int recv_socket_idx) {
+  while (true) {
+    Message msg;
+    int recv_bytes = Recv(&msg, recv_socket_idx);
+    CHECK_NE(recv_bytes, -1);
+    if (msg.meta.flag == Flag::kMailboxControl) {
+      Control ctrl;
+      SArrayBinStream bin;
+      bin.FromMsg(msg);
+      bin >> ctrl;
+      CHECK(ctrl.flag == MailboxFlag::kExit)
+          << "only kExit is expected on receive socket " << recv_socket_idx;
+      break;
+    }
+    OnReceive(msg);
+    std::lock_guard<std::mutex> lk(mu_);
+    CHECK(queue_map_.find(msg.meta.recver) != queue_map_.end())
+        << msg.meta.recver;
+    queue_map_[msg.meta.recver]->Push(std::move(msg));
+  }
+}
+
+void BasicMailbox::StopDataReceivers() {
+  for (int i = 1; i < num_recv_sockets_; ++i) {
+    Message exit;
+    exit.meta.flag = Flag::kMailboxControl;
+    exit.meta.recver = my_node_.id;
+    Control ctrl;
+    ctrl.flag = MailboxFlag::kExit;
+    SArrayBinStream bin;
+    bin << ctrl;
+    exit.AddData(bin.ToSArray());
+    CHECK_NE(SendTo(my_node_.id, i, exit), -1);
+  }
+  for (auto &t : data_receiver_threads_) {
+    t.join();
+  }
+  data_receiver_threads_.clear();
+}
+
+void BasicMailbox::CreateContext() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (context_ == nullptr) {
+    context_ = zmq_ctx_new();
+    CHECK(context_ != NULL) << "create 0mq context failed";
+    zmq_ctx_set(context_, ZMQ_MAX_SOCKETS, 65536);
+    zmq_ctx_set(context_, ZMQ_IO_THREADS, num_io_threads_);
+  }
+}
+
 // For testing only
 void BasicMailbox::BindAndConnect() {
-  context_ = zmq_ctx_new();
-  CHECK(context_ != nullptr) << "create zmq context failed";
-  zmq_ctx_set(context_, ZMQ_MAX_SOCKETS, 65536);
+  CreateContext();
+  my_node_.hostname = scheduler_node_.hostname;
 
   Bind(scheduler_node_, 1);
   VLOG(2) << "Finished binding";
@@ -201,13 +308,24 @@ void BasicMailbox::BindAndConnect() {
 
 void BasicMailbox::CloseSockets() {
   int linger = 0;
-  int rc = zmq_setsockopt(receiver_, ZMQ_LINGER, &linger, sizeof(linger));
-  CHECK(rc == 0 || errno == ETERM);
-  CHECK_EQ(zmq_close(receiver_), 0);
-  for (auto &it : senders_) {
-    int rc = zmq_setsockopt(it.second, ZMQ_LINGER, &linger, sizeof(linger));
+  for (void *receiver : receivers_) {
+    int rc = zmq_setsockopt(receiver, ZMQ_LINGER, &linger, sizeof(linger));
     CHECK(rc == 0 || errno == ETERM);
-    CHECK_EQ(zmq_close(it.second), 0);
+    CHECK_EQ(zmq_close(receiver), 0);
+  }
+  receivers_.clear();
+  {
+    boost::unique_lock<boost::shared_mutex> lk(senders_mu_);
+    for (auto &it : senders_) {
+      for (auto &sender : it.second) {
+        std::lock_guard<std::mutex> socket_lk(sender->mu);
+        int rc = zmq_setsockopt(sender->socket, ZMQ_LINGER, &linger,
+                                sizeof(linger));
+        CHECK(rc == 0 || errno == ETERM);
+        CHECK_EQ(zmq_close(sender->socket), 0);
+      }
+    }
+    senders_.clear();
   }
   zmq_ctx_destroy(context_);
 }
@@ -215,21 +333,33 @@ void BasicMailbox::CloseSockets() {
 void BasicMailbox::Connect(const Node &node) {
   CHECK_NE(node.id, node.kEmpty);
   CHECK_NE(node.port, node.kEmpty);
-  auto it = senders_.find(node.id);
-  if (it != senders_.end()) {
-    zmq_close(it->second);
+  boost::unique_lock<boost::shared_mutex> lk(senders_mu_);
+  auto &sockets = senders_[node.id];
+  for (auto &sender : sockets) {
+    zmq_close(sender->socket);
   }
-  void *sender = zmq_socket(context_, ZMQ_DEALER);
-  CHECK(sender != nullptr) << zmq_strerror(errno);
-  if (my_node_.id != Node::kEmpty) {
-    std::string my_id = "node" + std::to_string(my_node_.id);
-    zmq_setsockopt(sender, ZMQ_IDENTITY, my_id.data(), my_id.size());
-  }
-  std::string addr = "tcp://" + node.hostname + ":" + std::to_string(node.port);
-  if (zmq_connect(sender, addr.c_str()) != 0) {
-    LOG(FATAL) << "connect to " + addr + " failed: " << zmq_strerror(errno);
+  sockets.resize(num_lanes_ * num_recv_sockets_);
+  for (int i = 0; i < sockets.size(); ++i) {
+    int lane = i / num_recv_sockets_;
+    void *sender = zmq_socket(context_, ZMQ_DEALER);
+    CHECK(sender != nullptr) << zmq_strerror(errno);
+    if (my_node_.id != Node::kEmpty) {
+      // the lanes connect to the same ROUTER and need different identities
+      std::string my_id = "node" + std::to_string(my_node_.id);
+      if (lane == 1) {
+        my_id += "-bulk";
+      }
+      zmq_setsockopt(sender, ZMQ_IDENTITY, my_id.data(), my_id.size());
+    }
+    std::string addr = GetAddress(node, i % num_recv_sockets_);
+    if (zmq_connect(sender, addr.c_str()) != 0) {
+      LOG(FATAL) << "connect to " + addr + " failed: " << zmq_strerror(errno);
+    }
+    if (!sockets[i]) {
+      sockets[i].reset(new SenderSocket);
+    }
+    sockets[i]->socket = sender;
   }
-  senders_[node.id] = sender;
 }
 
 const Node &BasicMailbox::my_node() const {
@@ -239,16 +369,55 @@ const Node &BasicMailbox::my_node() const {
 
 std::vector<Node> BasicMailbox::GetNodes() { return nodes_; }
 
+std::string BasicMailbox::GetAddress(const Node &node,
+                                     int recv_socket_idx) const {
+  int port = node.port + recv_socket_idx;
+  if (use_ipc_ && node.hostname == my_node_.hostname) {
+    return GetIpcAddress(port);
+  }
+  return "tcp://" + node.hostname + ":" + std::to_string(port);
+}
+
+// the tcp port is unique on a host, so is the ipc path derived from it
+std::string BasicMailbox::GetIpcAddress(int port) const {
+  return "ipc:///tmp/xyz-mailbox-" + std::to_string(port);
+}
+
 void BasicMailbox::Bind(const Node &node, int max_retry) {
-  receiver_ = zmq_socket(context_, ZMQ_ROUTER);
-  CHECK(receiver_ != nullptr) << "create receiver socket failed: "
-                              << zmq_strerror(errno);
-  std::string address = "tcp://*:" + std::to_string(node.port);
   for (int i = 0; i < max_retry; i++) {
-    if (zmq_bind(receiver_, address.c_str()) == 0)
-      break;
-    if (i == max_retry - 1)
-      LOG(FATAL) << "bind to " + address + " failed: " << zmq_strerror(errno);
+    if (TryBind(node))
+      return;
+  }
+  LOG(FATAL) << "bind to ports " << node.port << "-"
+             << node.port + num_recv_sockets_ - 1 << " failed";
+}
+
+// bind the receive sockets to node.port ... node.port + num_recv_sockets_ - 1,
+// none is left open if any of the ports is taken
+bool BasicMailbox::TryBind(const Node &node) {
+  receivers_.resize(num_recv_sockets_);
+  for (int k = 0; k < num_recv_sockets_; ++k) {
+    receivers_[k] = zmq_socket(context_, ZMQ_ROUTER);
+    CHECK(receivers_[k] != nullptr) << "create receiver socket failed: "
+                                    << zmq_strerror(errno);
+    std::vector<std::string> addresses{"tcp://*:" + std::to_string(node.port + k)};
+    if (use_ipc_) {
+      // also listen to the nodes on the same host
+      addresses.push_back(GetIpcAddress(node.port + k));
+    }
+    for (const auto &address : addresses) {
+      if (zmq_bind(receivers_[k], address.c_str()) != 0) {
+        LOG(INFO) << "bind to " + address + " failed: " << zmq_strerror(errno);
+        int linger = 0;
+        for (int j = 0; j <= k; ++j) {
+          zmq_setsockopt(receivers_[j], ZMQ_LINGER, &linger, sizeof(linger));
+          CHECK_EQ(zmq_close(receivers_[j]), 0);
+        }
+        receivers_.clear();
+        return false;
+      }
+    }
   }
+  return true;
 }
 } // namespace xyz
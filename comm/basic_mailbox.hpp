@@ -3,6 +3,8 @@
 #include <atomic>
 #include <future>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -15,8 +17,11 @@
 #include "base/third_party/network_utils.h"
 #include "base/threadsafe_queue.hpp"
 #include "comm/abstract_mailbox.hpp"
+#include "comm/send_slot_pool.hpp"
 #include "glog/logging.h"
 
+#include <boost/thread/shared_mutex.hpp>
+
 namespace xyz {
 
 enum class MailboxFlag : char { kExit, kBarrier, kRegister, kHeartbeat };
@@ -34,17 +39,27 @@ struct Control {
                                      Control &ctrl);
 };
 
-inline void FreeData(void *data, void *hint) {
-  if (hint == NULL) {
-    delete[] static_cast<char *>(data);
-  } else {
-    delete static_cast<third_party::SArray<char> *>(hint);
-  }
-}
+// a connected DEALER socket and the lock serializing sends on it
+struct SenderSocket {
+  void *socket = nullptr;
+  std::mutex mu;
+};
 
 class BasicMailbox : public AbstractMailbox {
 public:
-  BasicMailbox(Node scheduler_node);
+  /*
+   * num_io_threads: # of zmq io threads.
+   * num_recv_sockets: # of receive sockets (and receiving threads) per node,
+   * socket k listens on port + k. It must be the same on all nodes.
+   * separate_bulk_sockets: send the TrafficClass::kBulk messages through
+   * their own connections so that control messages never queue behind
+   * them in zmq.
+   * use_ipc: connect to the nodes on the same host through ipc:// instead
+   * of tcp://. It must be the same on all nodes.
+   */
+  BasicMailbox(Node scheduler_node, int num_io_threads = 1,
+               int num_recv_sockets = 1, bool separate_bulk_sockets = false,
+               bool use_ipc = false);
   ~BasicMailbox();
 
   void RegisterQueue(uint32_t queue_id, ThreadsafeQueue<Message> *const queue);
@@ -54,7 +69,8 @@ public:
 
   // return # of bytes sended
   virtual int Send(const Message &msg) override;
-  int Recv(Message *msg);
+  virtual bool TrySendLocal(Message *msg) override;
+  int Recv(Message *msg, int recv_socket_idx = 0);
   void Barrier();
 
   // For testing only
@@ -66,7 +82,18 @@ public:
   std::vector<Node> GetNodes();
 
 protected:
+  void CreateContext();
   void Bind(const Node &node, int max_retry);
+  bool TryBind(const Node &node);
+  // the address of the k-th receive socket of node, per peer transport
+  std::string GetAddress(const Node &node, int recv_socket_idx) const;
+  std::string GetIpcAddress(int port) const;
+  // send to the recv_socket_idx-th receive socket of node recver_id
+  int SendTo(int recver_id, int recv_socket_idx, const Message &msg);
+  // the receive socket the msg goes to
+  int GetRecvSocketIdx(const Message &msg) const;
+  // 0 for the control lane and 1 for the bulk lane
+  int GetLane(const Message &msg) const;
 
   // whether it is ready for sending
   std::atomic<bool> ready_{false};
@@ -79,6 +106,8 @@ protected:
   // node's address string (i.e. ip:port) -> node id
   // this map is updated when ip:port is received for the first time
   std::unordered_map<std::string, int> connected_nodes_;
+  // the scheduler's heartbeat thread erases the dead nodes from connected_nodes_
+  std::mutex connected_nodes_mu_;
   // maps the id of node which is added later to the id of node
   // which is with the same ip:port and added first
   std::unordered_map<int, int> shared_node_mapping_;
@@ -89,15 +118,38 @@ protected:
   virtual void HandleBarrierMsg() = 0;
   virtual void HandleRegisterMsg(Message *msg, Node &recovery_node) = 0;
 
-  // receiver
+  // receiver, receiver_thread_ handles receive socket 0 which
+  // carries all the mailbox control messages
   std::thread receiver_thread_;
   virtual void Receiving() = 0;
+  // the other receive sockets only carry kOthers messages
+  std::vector<std::thread> data_receiver_threads_;
+  void StartDataReceivers();
+  void DataReceiving(int recv_socket_idx);
+  void StopDataReceivers();
+  // called on each kOthers msg received from the other nodes
+  virtual void OnReceive(const Message &msg) {}
+
+  // send one frame backed by a pooled slot, return -1 on failure
+  int SendFrame(void *socket, void *data, int size, SendSlot *slot, int tag);
 
   // socket
+  const int num_io_threads_;
+  const int num_recv_sockets_;
+  const int num_lanes_;
+  const bool use_ipc_;
   void *context_ = nullptr;
-  std::unordered_map<uint32_t, void *> senders_;
-  void *receiver_ = nullptr;
+  // node id -> one socket per (lane, receive socket) of the node, indexed by
+  // lane * num_recv_sockets_ + recv_socket_idx. senders_mu_ guards the map
+  // itself and each SenderSocket::mu serializes the sends to one socket
+  std::unordered_map<uint32_t, std::vector<std::unique_ptr<SenderSocket>>>
+      senders_;
+  boost::shared_mutex senders_mu_;
+  std::vector<void *> receivers_;
+  // guards queue_map_ and context_
   std::mutex mu_;
+  // slots backing the meta and data frames in flight
+  SendSlotPool slot_pool_;
 
   // heartbeat
   std::thread heartbeat_thread_;
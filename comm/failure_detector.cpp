@@ -0,0 +1,93 @@
+#include "comm/failure_detector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace xyz {
+
+double PhiAccrualFailureDetector::SteadyClock() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void PhiAccrualFailureDetector::History::Add(double interval, int max_samples) {
+  intervals.push_back(interval);
+  sum += interval;
+  squared_sum += interval * interval;
+  while (intervals.size() > max_samples) {
+    sum -= intervals.front();
+    squared_sum -= intervals.front() * intervals.front();
+    intervals.pop_front();
+  }
+}
+
+void PhiAccrualFailureDetector::Heartbeat(int node_id) {
+  const double now = clock_();
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = histories_.find(node_id);
+  if (it == histories_.end()) {
+    // mean first_interval and std dev first_interval / 4 to start with
+    History h;
+    h.Add(config_.first_interval * 0.75, config_.max_samples);
+    h.Add(config_.first_interval * 1.25, config_.max_samples);
+    h.last = now;
+    histories_[node_id] = h;
+    return;
+  }
+  it->second.Add(std::max(now - it->second.last, 0.0), config_.max_samples);
+  it->second.last = now;
+}
+
+void PhiAccrualFailureDetector::Arrive(int node_id) {
+  const double now = clock_();
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = histories_.find(node_id);
+  if (it != histories_.end()) {
+    it->second.last = std::max(it->second.last, now);
+  }
+}
+
+void PhiAccrualFailureDetector::Remove(int node_id) {
+  std::lock_guard<std::mutex> lk(mu_);
+  histories_.erase(node_id);
+}
+
+double PhiAccrualFailureDetector::Phi(int node_id) {
+  const double now = clock_();
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = histories_.find(node_id);
+  return it == histories_.end() ? 0 : Phi(it->second, now);
+}
+
+std::set<int> PhiAccrualFailureDetector::GetDeadNodes() {
+  const double now = clock_();
+  std::set<int> dead_nodes;
+  std::lock_guard<std::mutex> lk(mu_);
+  for (auto &kv : histories_) {
+    if (Phi(kv.second, now) >= config_.threshold) {
+      dead_nodes.insert(kv.first);
+    }
+  }
+  return dead_nodes;
+}
+
+// -log10(1 - F(t)) with the logistic approximation of the normal cdf F,
+// the two branches avoid the cancellation in 1 - F(t) when t is large
+double PhiAccrualFailureDetector::Phi(const History &h, double now) const {
+  const int n = h.intervals.size();
+  const double mean = h.sum / n + config_.acceptable_pause;
+  const double variance = std::max(h.squared_sum / n - (h.sum / n) * (h.sum / n), 0.0);
+  const double std_dev = std::max(std::sqrt(variance), config_.min_std_dev);
+  const double t = std::max(now - h.last, 0.0);
+  const double y = (t - mean) / std_dev;
+  const double e = std::exp(-y * (1.5976 + 0.070566 * y * y));
+  if (t > mean) {
+    return -std::log10(e / (1.0 + e));
+  } else {
+    return -std::log10(1.0 - 1.0 / (1.0 + e));
+  }
+}
+
+}  // namespace xyz
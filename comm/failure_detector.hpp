@@ -0,0 +1,80 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace xyz {
+
+/*
+ * Phi accrual failure detector on the heartbeats of the workers.
+ *
+ * Instead of a fixed timeout, each node keeps the last inter-arrival
+ * times of its heartbeats and phi = -log10(P(the next one comes later
+ * than now)) under a normal distribution fit to them. A node is dead once
+ * phi reaches the threshold, e.g. 8 means a 1e-8 chance of a false
+ * positive. A node with jittery heartbeats gets more slack and a regular
+ * one is detected sooner. The defaults are conservative: with the 1s
+ * heartbeats of the workers, a node is dead after about 6.5s of silence
+ * (the fixed timeout was 3s), a false positive hands the id of a live
+ * node to a restarting one.
+ *
+ * Any other message from a node (Arrive) shows it is alive: it resets the
+ * time since the last arrival but adds no sample, the samples are the
+ * intervals of the heartbeats only.
+ *
+ * Thread-safe, the clock returns seconds and can be faked in tests.
+ */
+class PhiAccrualFailureDetector {
+ public:
+  using Clock = std::function<double()>;
+  struct Config {
+    double threshold = 8;
+    int max_samples = 200;
+    // the std dev is at least this, the heartbeats of an idle cluster are
+    // too regular
+    double min_std_dev = 0.5;
+    // the pause tolerated on top of the intervals, e.g. a long task
+    // blocking the heartbeats
+    double acceptable_pause = 3;
+    // the expected interval before the first samples
+    double first_interval = 1;
+  };
+
+  static double SteadyClock();
+
+  PhiAccrualFailureDetector() : clock_(SteadyClock) {}
+  explicit PhiAccrualFailureDetector(Config config, Clock clock = SteadyClock)
+      : config_(config), clock_(clock) {}
+
+  // a heartbeat, the node is added if it is not tracked
+  void Heartbeat(int node_id);
+  // other traffic from the node, ignored if the node is not tracked
+  void Arrive(int node_id);
+  void Remove(int node_id);
+
+  // 0 if the node is not tracked
+  double Phi(int node_id);
+  bool IsAvailable(int node_id) { return Phi(node_id) < config_.threshold; }
+  // the tracked nodes with phi >= threshold
+  std::set<int> GetDeadNodes();
+
+ private:
+  struct History {
+    double last = 0;
+    std::deque<double> intervals;
+    double sum = 0;
+    double squared_sum = 0;
+    void Add(double interval, int max_samples);
+  };
+  double Phi(const History& h, double now) const;
+
+  const Config config_ = Config();
+  Clock clock_;
+  std::mutex mu_;
+  std::map<int, History> histories_;
+};
+
+}  // namespace xyz
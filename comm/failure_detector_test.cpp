@@ -0,0 +1,119 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "comm/failure_detector.hpp"
+
+namespace xyz {
+namespace {
+
+class TestFailureDetector : public testing::Test {};
+
+// a heartbeat every interval seconds from now on
+void Beat(PhiAccrualFailureDetector &detector, double &now, int node_id,
+          int times, double interval) {
+  for (int i = 0; i < times; ++i) {
+    now += interval;
+    detector.Heartbeat(node_id);
+  }
+}
+
+// the detector is strict without the defaults' slack
+PhiAccrualFailureDetector::Config StrictConfig() {
+  PhiAccrualFailureDetector::Config config;
+  config.min_std_dev = 0.1;
+  config.acceptable_pause = 0;
+  return config;
+}
+
+TEST_F(TestFailureDetector, Regular) {
+  double now = 0;
+  PhiAccrualFailureDetector detector(StrictConfig(), [&now]() { return now; });
+  EXPECT_EQ(detector.Phi(1), 0);
+  detector.Heartbeat(1);
+  Beat(detector, now, 1, 20, 1);
+  now += 1;
+  EXPECT_LT(detector.Phi(1), 1);
+  EXPECT_TRUE(detector.IsAvailable(1));
+  // 1 second late with regular heartbeats
+  now += 1;
+  EXPECT_FALSE(detector.IsAvailable(1));
+  EXPECT_EQ(detector.GetDeadNodes(), std::set<int>({1}));
+  // a heartbeat brings it back
+  detector.Heartbeat(1);
+  EXPECT_TRUE(detector.IsAvailable(1));
+}
+
+TEST_F(TestFailureDetector, Default) {
+  double now = 0;
+  PhiAccrualFailureDetector detector(PhiAccrualFailureDetector::Config(),
+                                     [&now]() { return now; });
+  detector.Heartbeat(1);
+  Beat(detector, now, 1, 20, 1);
+  // a few missed heartbeats are tolerated
+  now += 5;
+  EXPECT_TRUE(detector.IsAvailable(1));
+  now += 2;
+  EXPECT_FALSE(detector.IsAvailable(1));
+}
+
+TEST_F(TestFailureDetector, Jitter) {
+  double now = 0;
+  PhiAccrualFailureDetector detector(StrictConfig(), [&now]() { return now; });
+  detector.Heartbeat(1);
+  detector.Heartbeat(2);
+  for (int i = 0; i < 20; ++i) {
+    // node 1 beats every 1s, node 2 every 0.5s or 1.5s
+    now += 0.5;
+    detector.Heartbeat(2);
+    now += 0.5;
+    detector.Heartbeat(1);
+    now += 1;
+    detector.Heartbeat(1);
+    detector.Heartbeat(2);
+  }
+  now += 2;
+  // the same silence is fatal for the regular node only
+  EXPECT_FALSE(detector.IsAvailable(1));
+  EXPECT_TRUE(detector.IsAvailable(2));
+  EXPECT_GT(detector.Phi(1), detector.Phi(2));
+}
+
+TEST_F(TestFailureDetector, AcceptablePause) {
+  double now = 0;
+  PhiAccrualFailureDetector::Config config = StrictConfig();
+  config.acceptable_pause = 3;
+  PhiAccrualFailureDetector detector(config, [&now]() { return now; });
+  detector.Heartbeat(1);
+  Beat(detector, now, 1, 20, 1);
+  // a 3s pause, e.g. a long task blocking the heartbeats
+  now += 3.5;
+  EXPECT_TRUE(detector.IsAvailable(1));
+  now += 2;
+  EXPECT_FALSE(detector.IsAvailable(1));
+}
+
+TEST_F(TestFailureDetector, Arrive) {
+  double now = 0;
+  PhiAccrualFailureDetector detector(PhiAccrualFailureDetector::Config(),
+                                     [&now]() { return now; });
+  // not tracked
+  detector.Arrive(1);
+  EXPECT_TRUE(detector.GetDeadNodes().empty());
+  detector.Heartbeat(1);
+  Beat(detector, now, 1, 20, 1);
+  // the heartbeats are replaced by other traffic
+  for (int i = 0; i < 10; ++i) {
+    now += 0.8;
+    detector.Arrive(1);
+  }
+  now += 5;
+  EXPECT_TRUE(detector.IsAvailable(1));
+  now += 3;
+  EXPECT_FALSE(detector.IsAvailable(1));
+  detector.Remove(1);
+  EXPECT_EQ(detector.Phi(1), 0);
+  EXPECT_TRUE(detector.GetDeadNodes().empty());
+}
+
+} // namespace
+} // namespace xyz
@@ -0,0 +1,74 @@
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "base/color.hpp"
+#include "comm/worker_mailbox.hpp"
+
+DEFINE_int32(port, 32150, "The port to bind");
+DEFINE_int32(num_msgs, 1000000, "# messages per sender thread");
+DEFINE_int32(msg_size, 16, "The payload size of each message in bytes");
+DEFINE_int32(num_senders, 1, "# sender threads");
+
+using namespace xyz;
+
+/*
+ * Measure the throughput of BasicMailbox::Send for small control messages.
+ * The mailbox binds and connects to itself (see BindAndConnect), the sender
+ * threads send to node 0 and one thread receives.
+ *
+ * ./MailboxBenchMain --num_msgs=1000000 --msg_size=16 --num_senders=2
+ */
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  Node node{0, "localhost", FLAGS_port, false};
+  WorkerMailbox mailbox(node);
+  mailbox.BindAndConnect();
+
+  const long long total = static_cast<long long>(FLAGS_num_msgs) * FLAGS_num_senders;
+  std::thread receiver([&mailbox, total]() {
+    Message msg;
+    for (long long i = 0; i < total; ++i) {
+      CHECK_NE(mailbox.Recv(&msg), -1);
+    }
+  });
+
+  third_party::SArray<char> payload(FLAGS_msg_size, 'a');
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> senders;
+  for (int t = 0; t < FLAGS_num_senders; ++t) {
+    senders.push_back(std::thread([&mailbox, &payload]() {
+      Message msg;
+      msg.meta.sender = 0;
+      msg.meta.recver = 0;
+      msg.meta.flag = Flag::kOthers;
+      msg.AddData(payload);
+      for (int i = 0; i < FLAGS_num_msgs; ++i) {
+        CHECK_NE(mailbox.Send(msg), -1);
+      }
+    }));
+  }
+  for (auto &t : senders) {
+    t.join();
+  }
+  auto send_end = std::chrono::steady_clock::now();
+  receiver.join();
+  auto end = std::chrono::steady_clock::now();
+
+  auto send_ms = std::chrono::duration_cast<std::chrono::milliseconds>(send_end - start).count();
+  auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+  LOG(INFO) << "sent " << total << " messages of " << FLAGS_msg_size
+            << " bytes with " << FLAGS_num_senders << " threads";
+  LOG(INFO) << "send: " << send_ms << " ms, "
+            << GREEN(std::to_string(total * 1000 / std::max<long long>(send_ms, 1)) + " msgs/s");
+  LOG(INFO) << "send + recv: " << total_ms << " ms, "
+            << GREEN(std::to_string(total * 1000 / std::max<long long>(total_ms, 1)) + " msgs/s");
+
+  mailbox.CloseSockets();
+  return 0;
+}
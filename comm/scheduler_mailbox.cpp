@@ -1,24 +1,27 @@
 #include "comm/scheduler_mailbox.hpp"
 #include "base/color.hpp"
+#include "core/queue_node_map.hpp"
 
 #include <sstream>
 
 namespace xyz {
 
-SchedulerMailbox::SchedulerMailbox(Node scheduler_node, int num_workers)
-    : BasicMailbox(scheduler_node), num_workers_(num_workers) {}
+SchedulerMailbox::SchedulerMailbox(Node scheduler_node, int num_workers,
+                                   int num_io_threads, int num_recv_sockets,
+                                   bool separate_bulk_sockets, bool use_ipc,
+                                   PhiAccrualFailureDetector::Config detector_config,
+                                   int heartbeat_check_interval)
+    : BasicMailbox(scheduler_node, num_io_threads, num_recv_sockets,
+                   separate_bulk_sockets, use_ipc),
+      failure_detector_(detector_config),
+      heartbeat_check_interval_(heartbeat_check_interval),
+      num_workers_(num_workers) {}
 
 SchedulerMailbox::~SchedulerMailbox() {}
 
 void SchedulerMailbox::Start() {
   // start zmq
-  mu_.lock();
-  if (context_ == nullptr) {
-    context_ = zmq_ctx_new();
-    CHECK(context_ != NULL) << "create 0mq context failed";
-    zmq_ctx_set(context_, ZMQ_MAX_SOCKETS, 65536);
-  }
-  mu_.unlock();
+  CreateContext();
 
   my_node_ = scheduler_node_;
 
@@ -31,15 +34,16 @@ void SchedulerMailbox::Start() {
 
   // start receiving
   receiver_thread_ = std::thread(&SchedulerMailbox::Receiving, this);
+  StartDataReceivers();
 
   // wait until ready
   while (!ready_.load()) {
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 
-  // Check the heartbeats of workers and find out dead nodes
-  heartbeat_thread_ =
-      std::thread(&SchedulerMailbox::CheckHeartbeat, this, kHeartbeatTimeout);
+  // Check the heartbeats of workers and find out dead nodes, the dead
+  // nodes are also looked up when a node registers to reuse their ids
+  heartbeat_thread_ = std::thread(&SchedulerMailbox::CheckHeartbeat, this);
 
   start_time_ = time(NULL);
   VLOG(2) << my_node_.DebugString() << " started";
@@ -69,26 +73,29 @@ void SchedulerMailbox::HandleBarrierMsg() {
 
 void SchedulerMailbox::HandleRegisterMsg(Message *msg, Node &recovery_node) {
   // reference:
-  auto deadnodes_set = GetDeadNodes(kHeartbeatTimeout);
+  auto deadnodes_set = GetDeadNodes();
   UpdateID(msg, deadnodes_set, recovery_node);
 
   if (nodes_.size() == num_workers_) {
     LOG(INFO) << num_workers_ << " nodes registered at scheduler.";
     // assign node id (dummy ranking, id from 1 to num_workers_)
     int id = 0;
-    for (auto &node : nodes_) {
-      id++;
-      std::string node_host_ip =
-          node.hostname + ":" + std::to_string(node.port);
-      if (connected_nodes_.find(node_host_ip) == connected_nodes_.end()) {
-        CHECK_EQ(node.id, Node::kEmpty);
-        node.id = id;
-        Connect(node);
-        UpdateHeartbeat(node.id);
-        connected_nodes_[node_host_ip] = id;
-      } else {
-        shared_node_mapping_[id] = connected_nodes_[node_host_ip];
-        node.id = connected_nodes_[node_host_ip];
+    {
+      std::lock_guard<std::mutex> lk(connected_nodes_mu_);
+      for (auto &node : nodes_) {
+        id++;
+        std::string node_host_ip =
+            node.hostname + ":" + std::to_string(node.port);
+        if (connected_nodes_.find(node_host_ip) == connected_nodes_.end()) {
+          CHECK_EQ(node.id, Node::kEmpty);
+          node.id = id;
+          Connect(node);
+          UpdateHeartbeat(node.id);
+          connected_nodes_[node_host_ip] = id;
+        } else {
+          shared_node_mapping_[id] = connected_nodes_[node_host_ip];
+          node.id = connected_nodes_[node_host_ip];
+        }
       }
     }
     // put nodes into msg
@@ -114,7 +121,7 @@ void SchedulerMailbox::HandleRegisterMsg(Message *msg, Node &recovery_node) {
 
   else if (recovery_node.is_recovery) {
     VLOG(1) << "recovery_node.is_recovery == true";
-    auto deadnodes_set = GetDeadNodes(kHeartbeatTimeout);
+    auto deadnodes_set = GetDeadNodes();
     // send back the recovery node
     Connect(recovery_node);
     UpdateHeartbeat(recovery_node.id);
@@ -178,36 +185,28 @@ void SchedulerMailbox::UpdateID(Message *msg,
   }
 }
 
-std::set<int> SchedulerMailbox::GetDeadNodes(int timeout) {
+std::set<int> SchedulerMailbox::GetDeadNodes() {
   std::set<int> dead_nodes;
-  if (!ready_ || timeout == 0)
+  if (!ready_)
     return dead_nodes;
 
-  time_t curr_time = time(NULL);
-  const auto nodes = GetNodeIDs();
-  {
-    std::lock_guard<std::mutex> lk(heartbeat_mu_);
-    for (int r : nodes) {
-      auto it = heartbeats_.find(r);
-      if ((it == heartbeats_.end() || it->second + timeout < curr_time) &&
-          start_time_ + timeout < curr_time) {
-        dead_nodes.insert(r);
-      }
+  // the nodes are tracked since they register
+  const auto suspects = failure_detector_.GetDeadNodes();
+  for (int r : GetNodeIDs()) {
+    if (suspects.find(r) != suspects.end()) {
+      dead_nodes.insert(r);
     }
   }
   return dead_nodes;
 }
 
-void SchedulerMailbox::CheckHeartbeat(int time_out) {
-  while (ready_.load() && kHeartbeatCheckInterval > 0) {
-    // For experiences
-    break;
-    
-    std::this_thread::sleep_for(std::chrono::seconds(kHeartbeatCheckInterval));
+void SchedulerMailbox::CheckHeartbeat() {
+  while (ready_.load() && heartbeat_check_interval_ > 0) {
+    std::this_thread::sleep_for(std::chrono::seconds(heartbeat_check_interval_));
     if (!ready_.load())
       break;
 
-    std::set<int> deadnodes = GetDeadNodes(time_out);
+    std::set<int> deadnodes = GetDeadNodes();
     if (!deadnodes.empty()) {
       // TODO: start a new worker node
       std::stringstream ss;
@@ -216,6 +215,7 @@ void SchedulerMailbox::CheckHeartbeat(int time_out) {
       }
       LOG(INFO) << RED("Detected " + std::to_string(deadnodes.size()) + " deadnode, ids: " + ss.str());
       Message msg;
+      msg.meta.sender = my_node_.id;
       msg.meta.recver = 0;
       msg.meta.flag = Flag::kOthers;
       SArrayBinStream ctrl_bin, bin;
@@ -226,6 +226,7 @@ void SchedulerMailbox::CheckHeartbeat(int time_out) {
       Send(msg);
       
       // Delete the deadnode from connected_nodes_ and its heartbeat info
+      std::lock_guard<std::mutex> lk(connected_nodes_mu_);
       for (auto node_id : deadnodes) {
         for (auto it = connected_nodes_.begin(); it != connected_nodes_.end(); ++it) {
           if (it->second == node_id) { 
@@ -233,7 +234,7 @@ void SchedulerMailbox::CheckHeartbeat(int time_out) {
             break; 
           }
         }
-        heartbeats_.erase(node_id);
+        failure_detector_.Remove(node_id);
       }
 
     }
@@ -242,12 +243,16 @@ void SchedulerMailbox::CheckHeartbeat(int time_out) {
 }
 
 void SchedulerMailbox::UpdateHeartbeat(int node_id) {
-  time_t t = time(NULL);
-  std::lock_guard<std::mutex> lk(heartbeat_mu_);
-  heartbeats_[node_id] = t;
+  failure_detector_.Heartbeat(node_id);
+}
+
+void SchedulerMailbox::OnReceive(const Message &msg) {
+  // the sender of a kOthers msg is a queue id
+  failure_detector_.Arrive(GetNodeId(msg.meta.sender));
 }
 
 const std::vector<int> SchedulerMailbox::GetNodeIDs() {
+  std::lock_guard<std::mutex> lk(connected_nodes_mu_);
   std::vector<int> temp;
   for (auto it : connected_nodes_) {
     temp.push_back(it.second);
@@ -282,6 +287,7 @@ void SchedulerMailbox::Receiving() {
         UpdateHeartbeat(msg.meta.sender);
       }
     } else {
+      OnReceive(msg);
       CHECK(queue_map_.find(msg.meta.recver) != queue_map_.end())
           << msg.meta.recver;
       queue_map_[msg.meta.recver]->Push(std::move(msg));
@@ -1,25 +1,33 @@
 #pragma once
 
 #include "comm/basic_mailbox.hpp"
+#include "comm/failure_detector.hpp"
 #include "core/scheduler/control.hpp"
 
 namespace xyz {
 
 class SchedulerMailbox : public BasicMailbox {
 public:
-  SchedulerMailbox(Node scheduler_node, int num_workers);
+  // heartbeat_check_interval: seconds between the checks for dead nodes,
+  // <=0 to only check them when a node registers
+  SchedulerMailbox(Node scheduler_node, int num_workers,
+                   int num_io_threads = 1, int num_recv_sockets = 1,
+                   bool separate_bulk_sockets = false, bool use_ipc = false,
+                   PhiAccrualFailureDetector::Config detector_config =
+                       PhiAccrualFailureDetector::Config(),
+                   int heartbeat_check_interval = 0);
   ~SchedulerMailbox();
   virtual void Start() override;
 
 private:
-  std::mutex heartbeat_mu_;
-  std::unordered_map<int, time_t> heartbeats_; // heartbeats from workers
+  // heartbeats from workers, other msgs from them count as heartbeats too
+  PhiAccrualFailureDetector failure_detector_;
   // in seconds
-  const int kHeartbeatTimeout = 3;
-  const int kHeartbeatCheckInterval = 1;
-  std::set<int> GetDeadNodes(int timeout = 60);
-  void CheckHeartbeat(int time_out);
+  const int heartbeat_check_interval_;
+  std::set<int> GetDeadNodes();
+  void CheckHeartbeat();
   void UpdateHeartbeat(int node_id);
+  virtual void OnReceive(const Message &msg) override;
 
   virtual void HandleBarrierMsg() override;
   virtual void HandleRegisterMsg(Message *msg, Node &recovery_node) override;
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/message.hpp"
+
+namespace xyz {
+
+class SendSlotPool;
+
+/*
+ * A SendSlot backs one outgoing zmq frame. It either carries a copy of
+ * the Meta or keeps a reference to the SArray buffer being sent, and is
+ * handed back to its pool by zmq (through FreeSlot) once the frame has
+ * left the socket.
+ */
+struct SendSlot {
+  char meta[sizeof(Meta)];
+  std::shared_ptr<char> ref;
+  SendSlotPool *pool = nullptr;
+};
+
+/*
+ * Free list of SendSlots so that the send path does not hit the allocator
+ * for every frame. Slots are returned from the zmq io thread, so the pool
+ * is thread-safe.
+ */
+class SendSlotPool {
+public:
+  explicit SendSlotPool(size_t max_free_slots = kDefaultMaxFreeSlots)
+      : max_free_slots_(max_free_slots) {}
+  ~SendSlotPool() {
+    for (auto *slot : free_slots_) {
+      delete slot;
+    }
+  }
+  SendSlotPool(const SendSlotPool &) = delete;
+  SendSlotPool &operator=(const SendSlotPool &) = delete;
+
+  SendSlot *Get() {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (!free_slots_.empty()) {
+        SendSlot *slot = free_slots_.back();
+        free_slots_.pop_back();
+        return slot;
+      }
+    }
+    SendSlot *slot = new SendSlot;
+    slot->pool = this;
+    return slot;
+  }
+
+  void Put(SendSlot *slot) {
+    // drop the reference before taking the lock
+    slot->ref.reset();
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (free_slots_.size() < max_free_slots_) {
+        free_slots_.push_back(slot);
+        return;
+      }
+    }
+    delete slot;
+  }
+
+  size_t NumFreeSlots() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return free_slots_.size();
+  }
+
+  static const size_t kDefaultMaxFreeSlots = 4096;
+
+private:
+  const size_t max_free_slots_;
+  std::mutex mu_;
+  std::vector<SendSlot *> free_slots_;
+};
+
+// zmq free callback, hint is the SendSlot backing the frame
+inline void FreeSlot(void *data, void *hint) {
+  SendSlot *slot = static_cast<SendSlot *>(hint);
+  slot->pool->Put(slot);
+}
+
+} // namespace xyz
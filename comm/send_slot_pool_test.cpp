@@ -0,0 +1,45 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "comm/send_slot_pool.hpp"
+
+namespace xyz {
+namespace {
+
+class TestSendSlotPool : public testing::Test {};
+
+TEST_F(TestSendSlotPool, GetPut) {
+  SendSlotPool pool;
+  SendSlot *slot = pool.Get();
+  EXPECT_EQ(slot->pool, &pool);
+  EXPECT_EQ(pool.NumFreeSlots(), 0);
+  pool.Put(slot);
+  EXPECT_EQ(pool.NumFreeSlots(), 1);
+  // reuse the slot
+  EXPECT_EQ(pool.Get(), slot);
+  EXPECT_EQ(pool.NumFreeSlots(), 0);
+  pool.Put(slot);
+}
+
+TEST_F(TestSendSlotPool, MaxFreeSlots) {
+  SendSlotPool pool(1);
+  SendSlot *s1 = pool.Get();
+  SendSlot *s2 = pool.Get();
+  pool.Put(s1);
+  pool.Put(s2);
+  EXPECT_EQ(pool.NumFreeSlots(), 1);
+}
+
+TEST_F(TestSendSlotPool, FreeSlotReleasesRef) {
+  SendSlotPool pool;
+  third_party::SArray<char> data(8, 'a');
+  SendSlot *slot = pool.Get();
+  slot->ref = data.ptr();
+  EXPECT_EQ(data.ptr().use_count(), 2);
+  FreeSlot(data.data(), slot);
+  EXPECT_EQ(data.ptr().use_count(), 1);
+  EXPECT_EQ(pool.NumFreeSlots(), 1);
+}
+
+} // namespace
+} // namespace xyz
@@ -1,8 +1,41 @@
 #include "comm/sender.hpp"
 
+#include "core/queue_node_map.hpp"
+
 namespace xyz {
 
-void Sender::Send(Message msg) { GetWorkQueue()->Push(std::move(msg)); }
+Sender::Sender(int qid, AbstractMailbox *mailbox, int num_threads)
+    : Actor(qid), mailbox_(mailbox) {
+  CHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i) {
+    shards_.emplace_back(new Shard(qid, mailbox));
+  }
+  Start();
+}
+
+Sender::~Sender() {
+  shards_.clear();
+  Stop();
+}
+
+int Sender::GetShardId(const Message &msg) const {
+  int recver_id = msg.meta.flag == Flag::kOthers ? GetNodeId(msg.meta.recver)
+                                                 : msg.meta.recver;
+  return recver_id % shards_.size();
+}
+
+void Sender::Send(Message msg) {
+  // skip zmq and the receiver thread for the local queues
+  if (mailbox_->TrySendLocal(&msg)) {
+    return;
+  }
+  if (msg.meta.flag != Flag::kOthers ||
+      msg.meta.traffic_class == TrafficClass::kControl) {
+    GetWorkQueue()->Push(std::move(msg));
+  } else {
+    shards_[GetShardId(msg)]->GetWorkQueue()->Push(std::move(msg));
+  }
+}
 
 void Sender::Process(Message msg) { mailbox_->Send(msg); }
 
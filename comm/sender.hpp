@@ -1,23 +1,49 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "base/actor.hpp"
 #include "comm/abstract_mailbox.hpp"
 #include "comm/abstract_sender.hpp"
 
 namespace xyz {
 
+/*
+ * Sender has one sending thread for control traffic and num_threads
+ * sending threads for bulk traffic, see TrafficClass.
+ * The bulk destinations are sharded across the threads by node id, so the
+ * messages to one node keep their order while a large payload to one node
+ * does not block the others.
+ */
 class Sender : public AbstractSender, public Actor {
 public:
-  Sender(int qid, AbstractMailbox *mailbox) : Actor(qid), mailbox_(mailbox) {
-    Start();
-  }
-  ~Sender() { Stop(); }
+  Sender(int qid, AbstractMailbox *mailbox, int num_threads = 1);
+  ~Sender();
 
   virtual void Send(Message msg) override;
   virtual void Process(Message msg) override;
 
+  int GetNumBulkThreads() const { return shards_.size(); }
+
 private:
+  // the bulk sending threads, the thread of this actor sends control traffic
+  class Shard : public Actor {
+  public:
+    Shard(int qid, AbstractMailbox *mailbox) : Actor(qid), mailbox_(mailbox) {
+      Start();
+    }
+    ~Shard() { Stop(); }
+    virtual void Process(Message msg) override { mailbox_->Send(msg); }
+
+  private:
+    AbstractMailbox *mailbox_;
+  };
+
+  int GetShardId(const Message &msg) const;
+
   AbstractMailbox *mailbox_;
+  std::vector<std::unique_ptr<Shard>> shards_;
 };
 
 } // namespace xyz
@@ -0,0 +1,103 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+#include "comm/sender.hpp"
+#include "core/queue_node_map.hpp"
+
+namespace xyz {
+namespace {
+
+class TestSender : public testing::Test {};
+
+// record the order of the messages to each node
+struct FakeMailbox : public AbstractMailbox {
+  virtual int Send(const Message &msg) override {
+    std::lock_guard<std::mutex> lk(mu);
+    recved[GetNodeId(msg.meta.recver)].push_back(msg.meta.sender);
+    return 0;
+  }
+  std::mutex mu;
+  std::map<int, std::vector<int>> recved;
+};
+
+// block the bulk messages until Release()
+struct BlockingMailbox : public AbstractMailbox {
+  virtual int Send(const Message &msg) override {
+    std::unique_lock<std::mutex> lk(mu);
+    if (msg.meta.traffic_class == TrafficClass::kBulk) {
+      cond.wait(lk, [this] { return released; });
+      num_bulk += 1;
+    } else {
+      num_control += 1;
+    }
+    cond.notify_all();
+    return 0;
+  }
+  void Release() {
+    std::lock_guard<std::mutex> lk(mu);
+    released = true;
+    cond.notify_all();
+  }
+  std::mutex mu;
+  std::condition_variable cond;
+  bool released = false;
+  int num_bulk = 0;
+  int num_control = 0;
+};
+
+Message MakeMsg(int sender, int node, TrafficClass traffic_class) {
+  Message msg;
+  msg.meta.sender = sender;
+  msg.meta.recver = GetControllerActorQid(node);
+  msg.meta.flag = Flag::kOthers;
+  msg.meta.traffic_class = traffic_class;
+  return msg;
+}
+
+TEST_F(TestSender, Construct) {
+  FakeMailbox mailbox;
+  Sender sender(-1, &mailbox, 4);
+  EXPECT_EQ(sender.GetNumBulkThreads(), 4);
+}
+
+TEST_F(TestSender, SendSharded) {
+  FakeMailbox mailbox;
+  const int num_nodes = 5;
+  const int num_msgs = 100;
+  {
+    Sender sender(-1, &mailbox, 3);
+    for (int i = 0; i < num_msgs; ++i) {
+      for (int n = 0; n < num_nodes; ++n) {
+        sender.Send(MakeMsg(i, n, TrafficClass::kBulk));
+      }
+    }
+  }  // wait until all the messages are sent
+  ASSERT_EQ(mailbox.recved.size(), num_nodes);
+  for (auto &kv : mailbox.recved) {
+    ASSERT_EQ(kv.second.size(), num_msgs);
+    for (int i = 0; i < num_msgs; ++i) {
+      EXPECT_EQ(kv.second[i], i);
+    }
+  }
+}
+
+TEST_F(TestSender, ControlNotBehindBulk) {
+  BlockingMailbox mailbox;
+  Sender sender(-1, &mailbox, 1);
+  sender.Send(MakeMsg(0, 1, TrafficClass::kBulk));
+  sender.Send(MakeMsg(1, 1, TrafficClass::kControl));
+  {
+    // the control message goes through while the bulk one is blocked
+    std::unique_lock<std::mutex> lk(mailbox.mu);
+    mailbox.cond.wait(lk, [&mailbox] { return mailbox.num_control == 1; });
+    EXPECT_EQ(mailbox.num_bulk, 0);
+  }
+  mailbox.Release();
+}
+
+} // namespace
+} // namespace xyz
@@ -1,32 +1,29 @@
 #include "comm/worker_mailbox.hpp"
+#include "comm/failure_detector.hpp"
+#include "core/queue_node_map.hpp"
 
 // only work in our cluster: proj99 and w1-w20, hardcode the ib interface!!!
 // #define USE_IB
 
 namespace xyz {
 
-WorkerMailbox::WorkerMailbox(Node scheduler_node)
-    : BasicMailbox(scheduler_node) {}
+WorkerMailbox::WorkerMailbox(Node scheduler_node, int num_io_threads,
+                             int num_recv_sockets, bool separate_bulk_sockets,
+                             bool use_ipc)
+    : BasicMailbox(scheduler_node, num_io_threads, num_recv_sockets,
+                   separate_bulk_sockets, use_ipc) {}
 
 WorkerMailbox::~WorkerMailbox() {}
 
 void WorkerMailbox::Start() {
   // start zmq
-  mu_.lock();
-  if (context_ == nullptr) {
-    context_ = zmq_ctx_new();
-    CHECK(context_ != NULL) << "create 0mq context failed";
-    zmq_ctx_set(context_, ZMQ_MAX_SOCKETS, 65536);
-  }
-  mu_.unlock();
+  CreateContext();
 
   std::string interface;
   std::string ip;
   third_party::GetAvailableInterfaceAndIP(&interface, &ip);
   CHECK(!interface.empty()) << "failed to get the interface";
-  int port = third_party::GetAvailablePort();
   CHECK(!ip.empty()) << "failed to get ip";
-  CHECK(port) << "failed to get a port";
 #ifdef USE_IB
   // TODO: 172.16.104.1 -> 172.16.105.1
   // my_node_.hostname = "172.16.105.1";
@@ -34,12 +31,21 @@ void WorkerMailbox::Start() {
   ip[idx-1] = '5';
 #endif
   my_node_.hostname = ip;
-  my_node_.port = port;
   // cannot determine my id now, the scheduler will assign it later
   my_node_.id = Node::kEmpty;
 
-  // bind
-  Bind(my_node_, 40);
+  // bind, the receive sockets take the ports from a free one on, pick
+  // another one if any of them is taken
+  const int kMaxRetry = 40;
+  for (int i = 0; i < kMaxRetry; ++i) {
+    int port = third_party::GetAvailablePort();
+    CHECK(port) << "failed to get a port";
+    my_node_.port = port;
+    if (TryBind(my_node_)) {
+      break;
+    }
+    CHECK_LT(i, kMaxRetry - 1) << "failed to bind " << num_recv_sockets_ << " ports";
+  }
   LOG(INFO) << "Bind to " << my_node_.DebugString();
 
   // connect to scheduler
@@ -47,6 +53,7 @@ void WorkerMailbox::Start() {
 
   // start receiving
   receiver_thread_ = std::thread(&WorkerMailbox::Receiving, this);
+  StartDataReceivers();
 
   // let the scheduler know myself
   Message msg;
@@ -79,6 +86,11 @@ void WorkerMailbox::Heartbeat() {
     std::this_thread::sleep_for(std::chrono::seconds(kHeartbeatReportInterval));
     if (!ready_.load())
       break;
+    // piggybacked on the recent traffic to the scheduler
+    if (PhiAccrualFailureDetector::SteadyClock() -
+            last_scheduler_send_.load() < kHeartbeatReportInterval) {
+      continue;
+    }
     Message msg;
     msg.meta.sender = my_node_.id;
     msg.meta.recver = scheduler_node_.id;
@@ -94,6 +106,15 @@ void WorkerMailbox::Heartbeat() {
 
 void WorkerMailbox::StopHeartbeat() { heartbeat_thread_.join(); }
 
+int WorkerMailbox::Send(const Message &msg) {
+  int bytes = BasicMailbox::Send(msg);
+  if (msg.meta.flag == Flag::kOthers &&
+      GetNodeId(msg.meta.recver) == scheduler_node_.id) {
+    last_scheduler_send_ = PhiAccrualFailureDetector::SteadyClock();
+  }
+  return bytes;
+}
+
 void WorkerMailbox::HandleBarrierMsg() { barrier_finish_ = true; }
 
 void WorkerMailbox::HandleRegisterMsg(Message *msg, Node &recovery_node) {
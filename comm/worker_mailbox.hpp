@@ -6,15 +6,21 @@ namespace xyz {
 
 class WorkerMailbox : public BasicMailbox {
 public:
-  WorkerMailbox(Node scheduler_node);
+  WorkerMailbox(Node scheduler_node, int num_io_threads = 1,
+                int num_recv_sockets = 1, bool separate_bulk_sockets = false,
+                bool use_ipc = false);
   ~WorkerMailbox();
 
   virtual void Start() override;
   // Just for test
   virtual void StopHeartbeat();
+  virtual int Send(const Message &msg) override;
 
 private:
   const int kHeartbeatReportInterval = 1;
+  // the last time a kOthers msg is sent to the scheduler, in seconds, it
+  // counts as a heartbeat
+  std::atomic<double> last_scheduler_send_{0};
   virtual void Heartbeat();
   virtual void HandleBarrierMsg() override;
   virtual void HandleRegisterMsg(Message *msg, Node &recovery_node) override;
@@ -3,6 +3,7 @@
 
 #include "comm/scheduler_mailbox.hpp"
 #include "comm/worker_mailbox.hpp"
+#include "core/queue_node_map.hpp"
 
 namespace xyz {
 namespace {
@@ -14,6 +15,43 @@ TEST_F(TestWorkerMailbox, Construct) {
   WorkerMailbox mailbox(node);
 }
 
+class LocalMailbox : public WorkerMailbox {
+public:
+  LocalMailbox(Node scheduler_node, Node my_node)
+      : WorkerMailbox(scheduler_node) {
+    my_node_ = my_node;
+    ready_ = true;
+  }
+};
+
+TEST_F(TestWorkerMailbox, TrySendLocal) {
+  Node scheduler_node{0, "localhost", 32145, false};
+  Node my_node{1, "localhost", 32146, false};
+  LocalMailbox mailbox(scheduler_node, my_node);
+  ThreadsafeQueue<Message> queue;
+  mailbox.RegisterQueue(GetControllerActorQid(1), &queue);
+
+  Message msg;
+  msg.meta.sender = GetWorkerQid(1);
+  msg.meta.recver = GetControllerActorQid(1);
+  msg.meta.flag = Flag::kOthers;
+  EXPECT_TRUE(mailbox.TrySendLocal(&msg));
+  EXPECT_EQ(queue.Size(), 1);
+
+  // remote node
+  msg.meta.recver = GetControllerActorQid(2);
+  EXPECT_FALSE(mailbox.TrySendLocal(&msg));
+  // no such queue
+  msg.meta.recver = GetFetcherQid(1);
+  EXPECT_FALSE(mailbox.TrySendLocal(&msg));
+  // mailbox control message
+  msg.meta.recver = GetControllerActorQid(1);
+  msg.meta.flag = Flag::kMailboxControl;
+  EXPECT_FALSE(mailbox.TrySendLocal(&msg));
+  EXPECT_EQ(queue.Size(), 1);
+  mailbox.DeregisterQueue(GetControllerActorQid(1));
+}
+
 TEST_F(TestWorkerMailbox, BindAndConnect) {
   Node node{0, "localhost", 32145, false};
   WorkerMailbox mailbox(node);
@@ -21,5 +59,30 @@ TEST_F(TestWorkerMailbox, BindAndConnect) {
   mailbox.CloseSockets();
 }
 
+TEST_F(TestWorkerMailbox, SendRecvIpc) {
+  Node node{0, "localhost", 32147, false};
+  WorkerMailbox mailbox(node, 1, 1, false, true);
+  mailbox.BindAndConnect();
+
+  Message msg;
+  msg.meta.sender = 0;
+  msg.meta.recver = 0;
+  msg.meta.flag = Flag::kOthers;
+  SArrayBinStream bin;
+  bin << std::string("hello");
+  msg.AddData(bin.ToSArray());
+  EXPECT_GT(mailbox.Send(msg), 0);
+
+  Message recv_msg;
+  EXPECT_GT(mailbox.Recv(&recv_msg), 0);
+  ASSERT_EQ(recv_msg.data.size(), 1);
+  SArrayBinStream recv_bin;
+  recv_bin.FromSArray(recv_msg.data[0]);
+  std::string s;
+  recv_bin >> s;
+  EXPECT_EQ(s, "hello");
+  mailbox.CloseSockets();
+}
+
 } // namespace
 } // namespace xyz
@@ -0,0 +1,60 @@
+#include "core/cache/fetch_server.hpp"
+
+#include <limits>
+#include <sstream>
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+void FetchServer::Process(Message msg) {
+  CHECK_EQ(msg.data.size(), 3);
+  int depth = GetWorkQueue()->Size();
+  if (depth > max_queue_depth_.load()) {
+    max_queue_depth_.store(depth);
+  }
+
+  SArrayBinStream ctrl_bin, ctrl2_bin, bin;
+  ctrl_bin.FromSArray(msg.data[0]);
+  ctrl2_bin.FromSArray(msg.data[1]);
+  bin.FromSArray(msg.data[2]);
+  ControllerFlag flag;
+  ctrl_bin >> flag;
+  CHECK(flag == ControllerFlag::kFetchRequest);
+  FetchMeta meta;
+  ctrl2_bin >> meta;
+  CHECK_EQ(meta.version, -1) << "only fetch objs: " << meta.DebugString();
+  CHECK(partition_manager_->Has(meta.collection_id, meta.partition_id))
+      << "cid: " << meta.collection_id << ", pid: " << meta.partition_id;
+
+  auto part = partition_manager_->Get(meta.collection_id, meta.partition_id);
+  auto& func = function_store_->GetGetter(meta.collection_id);
+  SArrayBinStream reply_bin = func(bin, part);
+
+  // the collection is immutable, any version is fine
+  meta.version = std::numeric_limits<int>::max();
+  Message reply_msg;
+  reply_msg.meta.sender = Qid();
+  reply_msg.meta.recver = msg.meta.sender;
+  reply_msg.meta.flag = Flag::kOthers;
+  SArrayBinStream ctrl_reply_bin, ctrl2_reply_bin;
+  ctrl_reply_bin << FetcherFlag::kFetchObjsReply;
+  ctrl2_reply_bin << meta;
+  reply_msg.AddData(ctrl_reply_bin.ToSArray());
+  reply_msg.AddData(ctrl2_reply_bin.ToSArray());
+  reply_msg.AddData(reply_bin.ToSArray());
+  num_served_ += 1;
+  sender_->Send(std::move(reply_msg));
+}
+
+std::string FetchServer::DebugString() {
+  std::stringstream ss;
+  ss << "{ qid: " << Qid();
+  ss << ", queue depth: " << GetQueueDepth();
+  ss << ", max queue depth: " << GetMaxQueueDepth();
+  ss << ", served: " << GetNumServed();
+  ss << " }";
+  return ss.str();
+}
+
+}  // namespace xyz
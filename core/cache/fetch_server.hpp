@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "base/actor.hpp"
+#include "base/sarray_binstream.hpp"
+#include "comm/abstract_sender.hpp"
+#include "core/partition/partition_manager.hpp"
+#include "core/plan/function_store.hpp"
+#include "core/scheduler/control.hpp"
+
+namespace xyz {
+
+/*
+ * Serve the fetch-object requests of the collections that are immutable
+ * in the requesting plan (e.g. the with collection of a mapwithupdate
+ * that is not updated), without going through the Controller actor.
+ *
+ * Nothing of the plan is needed to serve them: the objects are read from
+ * the partition with the getter and sent back to the Fetcher directly.
+ * Each node runs several FetchServers, a request goes to the shard of
+ * its partition id (see Fetcher::FetchObjs).
+ */
+class FetchServer : public Actor {
+ public:
+  FetchServer(int qid, std::shared_ptr<FunctionStore> function_store,
+          std::shared_ptr<PartitionManager> partition_manager,
+          std::shared_ptr<AbstractSender> sender)
+      : Actor(qid), function_store_(function_store),
+        partition_manager_(partition_manager), sender_(sender) {
+    Start();
+  }
+  virtual ~FetchServer() {
+    Stop();
+  }
+
+  virtual void Process(Message msg) override;
+
+  int GetQueueDepth() { return GetWorkQueue()->Size(); }
+  int GetMaxQueueDepth() const { return max_queue_depth_.load(); }
+  int GetNumServed() const { return num_served_.load(); }
+  std::string DebugString();
+
+ private:
+  std::shared_ptr<FunctionStore> function_store_;
+  std::shared_ptr<PartitionManager> partition_manager_;
+  std::shared_ptr<AbstractSender> sender_;
+
+  std::atomic<int> max_queue_depth_{0};
+  std::atomic<int> num_served_{0};
+};
+
+}  // namespace xyz
@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "glog/logging.h"
+
+#include "core/cache/fetch_server.hpp"
+
+#include "comm/simple_sender.hpp"
+#include "core/partition/seq_partition.hpp"
+
+namespace xyz {
+namespace {
+
+class TestFetchServer : public testing::Test {};
+
+TEST_F(TestFetchServer, FetchObjs) {
+  const int qid = 4;
+  auto partition_manager = std::make_shared<PartitionManager>();
+  auto function_store = std::make_shared<FunctionStore>();
+  auto sender = std::make_shared<SimpleSender>();
+  auto part = std::make_shared<SeqPartition<int>>();
+  part->Add(10);
+  part->Add(20);
+  partition_manager->Insert(0, 1, std::move(part));
+  // reply the # keys and the # objs of the partition
+  function_store->AddGetter(0, [](SArrayBinStream bin, std::shared_ptr<AbstractPartition> p) {
+    std::vector<int> keys;
+    bin >> keys;
+    SArrayBinStream reply_bin;
+    reply_bin << static_cast<int>(keys.size()) << static_cast<int>(p->GetSize());
+    return reply_bin;
+  });
+  FetchServer fetch_server(qid, function_store, partition_manager, sender);
+
+  Message msg;
+  msg.meta.sender = 2;
+  msg.meta.recver = qid;
+  msg.meta.flag = Flag::kOthers;
+  SArrayBinStream ctrl_bin, ctrl2_bin, bin;
+  ctrl_bin << ControllerFlag::kFetchRequest;
+  FetchMeta meta;
+  meta.plan_id = 0;
+  meta.upstream_part_id = 3;
+  meta.collection_id = 0;
+  meta.partition_id = 1;
+  meta.version = -1;
+  ctrl2_bin << meta;
+  bin << std::vector<int>{10, 20, 30};
+  msg.AddData(ctrl_bin.ToSArray());
+  msg.AddData(ctrl2_bin.ToSArray());
+  msg.AddData(bin.ToSArray());
+  fetch_server.GetWorkQueue()->Push(msg);
+
+  Message reply = sender->Get();
+  EXPECT_EQ(reply.meta.sender, qid);
+  EXPECT_EQ(reply.meta.recver, 2);
+  ASSERT_EQ(reply.data.size(), 3);
+  SArrayBinStream reply_ctrl_bin, reply_ctrl2_bin, reply_bin;
+  reply_ctrl_bin.FromSArray(reply.data[0]);
+  reply_ctrl2_bin.FromSArray(reply.data[1]);
+  reply_bin.FromSArray(reply.data[2]);
+  FetcherFlag flag;
+  reply_ctrl_bin >> flag;
+  EXPECT_EQ(flag, FetcherFlag::kFetchObjsReply);
+  FetchMeta reply_meta;
+  reply_ctrl2_bin >> reply_meta;
+  EXPECT_EQ(reply_meta.upstream_part_id, 3);
+  EXPECT_EQ(reply_meta.partition_id, 1);
+  int num_keys, num_objs;
+  reply_bin >> num_keys >> num_objs;
+  EXPECT_EQ(num_keys, 3);
+  EXPECT_EQ(num_objs, 2);
+  EXPECT_EQ(fetch_server.GetNumServed(), 1);
+  partition_manager->Remove(0, 1);
+}
+
+}  // namespace
+}  // namespace xyz
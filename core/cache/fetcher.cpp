@@ -225,21 +225,49 @@ void Fetcher::FetchObjsReply(Message msg) {
   cv_.notify_all();
 }
 
+void Fetcher::SetNumFetchServers(int num_fetch_servers) {
+  CHECK_GE(num_fetch_servers, 0);
+  CHECK_LE(num_fetch_servers, kMaxFetchServers);
+  std::unique_lock<std::mutex> lk(m_);
+  num_fetch_servers_ = num_fetch_servers;
+}
+
+void Fetcher::AddDirectFetch(int plan_id, int collection_id) {
+  std::unique_lock<std::mutex> lk(m_);
+  direct_fetches_.insert({plan_id, collection_id});
+}
+
+void Fetcher::RemoveDirectFetch(int plan_id, int collection_id) {
+  std::unique_lock<std::mutex> lk(m_);
+  direct_fetches_.erase({plan_id, collection_id});
+}
+
 void Fetcher::FetchObjs(int plan_id, int upstream_part_id, int collection_id, 
         const std::map<int, SArrayBinStream>& part_to_keys,
         std::vector<SArrayBinStream>* const rets) {
 
+  bool direct = false;
+  int num_fetch_servers = 0;
   {
     std::unique_lock<std::mutex> lk(m_);
     // 0. register rets
     recv_binstream_[upstream_part_id] = rets;
+    num_fetch_servers = num_fetch_servers_;
+    direct = num_fetch_servers > 0
+        && direct_fetches_.find({plan_id, collection_id}) != direct_fetches_.end();
   }
       
   // 1. send requests
   for (auto const& pair : part_to_keys) {
     Message msg;
     msg.meta.sender = Qid();
-    msg.meta.recver = GetControllerActorQid(collection_map_->Lookup(collection_id, pair.first));// get controller qid
+    int node_id = collection_map_->Lookup(collection_id, pair.first);
+    if (direct) {
+      // the shard of the partition
+      msg.meta.recver = GetFetchServerQid(node_id, pair.first % num_fetch_servers);
+    } else {
+      msg.meta.recver = GetControllerActorQid(node_id);// get controller qid
+    }
     msg.meta.flag = Flag::kOthers;
     SArrayBinStream ctrl_bin, ctrl2_bin;
     ctrl_bin << ControllerFlag::kFetchRequest;// send to controller
@@ -2,6 +2,7 @@
 
 #include <thread>
 #include <queue>
+#include <set>
 
 #include "core/cache/abstract_fetcher.hpp"
 
@@ -45,6 +46,12 @@ class Fetcher : public Actor, public AbstractFetcher {
 
   virtual void FinishPart(FetchMeta meta) override;
 
+  // the fetch-object requests of collection_id in plan_id go to the
+  // FetchServers instead of the Controller, the collection is immutable in the plan
+  void SetNumFetchServers(int num_fetch_servers);
+  void AddDirectFetch(int plan_id, int collection_id);
+  void RemoveDirectFetch(int plan_id, int collection_id);
+
 
   void FetchPartRequest(Message msg);
   void SendFetchPart(FetchMeta meta);
@@ -87,6 +94,11 @@ class Fetcher : public Actor, public AbstractFetcher {
   std::map<std::pair<int, int>, int> local_access_count_;
 
   std::shared_ptr<Executor> executor_;
+
+  // # FetchServers on each node, 0 if there is none
+  int num_fetch_servers_ = 0;
+  // plan_id, collection_id
+  std::set<std::pair<int, int>> direct_fetches_;
 };
 
 }  // namespace xyz
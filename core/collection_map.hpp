@@ -19,6 +19,10 @@ class CollectionMap : public AbstractCollectionMap {
     std::lock_guard<std::mutex> lk(mu_);
     collection_map_[cv.collection_id] = cv;
   }
+  bool Has(int cid) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return collection_map_.find(cid) != collection_map_.end();
+  }
   CollectionView& Get(int cid) {
     std::lock_guard<std::mutex> lk(mu_);
     CHECK(collection_map_.find(cid) != collection_map_.end());
@@ -4,6 +4,9 @@
 #include "io/hdfs_reader.hpp"
 #include "io/hdfs_writer.hpp"
 #include "io/hdfs_block_reader.hpp"
+#include "io/block_reader_wrapper.hpp"
+#include "io/reader_wrapper.hpp"
+#include "io/writer_wrapper.hpp"
 
 #include <chrono>
 
@@ -19,17 +22,23 @@ void Engine::Init(Engine::Config config) {
   engine_elem_.num_local_threads = config.num_local_threads;
   engine_elem_.num_update_threads = config.num_update_threads;
   engine_elem_.num_combine_threads = config.num_combine_threads;
+  engine_elem_.num_credits_per_node = config.num_credits_per_node;
+  engine_elem_.report_batch_size = config.report_batch_size;
+  engine_elem_.report_flush_ms = config.report_flush_ms;
+  engine_elem_.num_controller_shards = config.num_controller_shards;
   config_ = config;
 }
 
 void Engine::Start() {
   // create mailbox
   Node scheduler_node{0, config_.scheduler, config_.scheduler_port, false};
-  mailbox_ =
-      std::make_shared<WorkerMailbox>(scheduler_node);
+  mailbox_ = std::make_shared<WorkerMailbox>(
+      scheduler_node, config_.num_io_threads, config_.num_recv_sockets,
+      config_.separate_bulk_sockets, config_.use_ipc);
   mailbox_->Start(); // start the mailbox so we can get the node
 
-  engine_elem_.sender = std::make_shared<Sender>(-1, mailbox_.get());
+  engine_elem_.sender = std::make_shared<Sender>(-1, mailbox_.get(),
+                                                 config_.num_sender_threads);
   engine_elem_.node = mailbox_->my_node();
 
   engine_elem_.intermediate_store =
@@ -44,17 +53,46 @@ void Engine::Start() {
   mailbox_->RegisterQueue(fetcher_id, fetcher_->GetWorkQueue());
   engine_elem_.fetcher = fetcher_;  // set it to engine_elem_ as worker needs it
 
+  // create fetch servers
+  CHECK_LE(config_.num_fetch_servers, kMaxFetchServers);
+  for (int i = 0; i < config_.num_fetch_servers; ++ i) {
+    const int fetch_server_id = GetFetchServerQid(engine_elem_.node.id, i);
+    auto fetch_server = std::make_shared<FetchServer>(fetch_server_id,
+            engine_elem_.function_store,
+            engine_elem_.partition_manager, engine_elem_.sender);
+    mailbox_->RegisterQueue(fetch_server_id, fetch_server->GetWorkQueue());
+    fetch_servers_.push_back(fetch_server);
+  }
+  fetcher_->SetNumFetchServers(fetch_servers_.size());
+
   const std::string namenode = engine_elem_.namenode;
   const int port = engine_elem_.port;
-  // set hdfs io_wrapper
+  // set io_wrapper, file:// urls are local and the others are on hdfs
   auto io_wrapper = std::make_shared<IOWrapper>(
       [namenode, port]() {
-        return std::make_shared<HdfsReader>(namenode, port);
+        return std::make_shared<ReaderWrapper>([namenode, port]() {
+          return std::make_shared<HdfsReader>(namenode, port);
+        });
       },
       [namenode, port]() {
-        return std::make_shared<HdfsWriter>(namenode, port);
+        return std::make_shared<WriterWrapper>([namenode, port]() {
+          return std::make_shared<HdfsWriter>(namenode, port);
+        });
       });
 
+  // checkpoint io, before the controller and worker copy the engine_elem_
+  std::shared_ptr<Executor> checkpoint_executor;
+  if (config_.num_checkpoint_threads > 0) {
+    checkpoint_executor = std::make_shared<Executor>(config_.num_checkpoint_threads);
+  }
+  engine_elem_.checkpoint_io = std::make_shared<CheckpointIO>(io_wrapper,
+          checkpoint_executor, config_.checkpoint_chunk_bytes,
+          config_.compress_checkpoint ? CheckpointCodec::kZeroRun : CheckpointCodec::kNone);
+  if (!config_.checkpoint_local_dir.empty()) {
+    engine_elem_.checkpoint_io->SetLocalTier(config_.checkpoint_local_dir, 
+            std::make_shared<Executor>(1));
+  }
+
   // create controller
   const int controller_id = GetControllerActorQid(engine_elem_.node.id);
   controller_ = std::make_shared<Controller>(controller_id, engine_elem_, io_wrapper);
@@ -66,7 +104,11 @@ void Engine::Start() {
   // create worker
   worker_ = std::make_shared<Worker>(worker_id, engine_elem_, 
           io_wrapper,
-          [namenode, port]() { return std::make_shared<HdfsBlockReader>(namenode, port); });
+          [namenode, port]() {
+            return std::make_shared<BlockReaderWrapper>([namenode, port]() {
+              return std::make_shared<HdfsBlockReader>(namenode, port);
+            });
+          });
   worker_->SetProgram(program_);
   mailbox_->RegisterQueue(worker_id, worker_->GetWorkQueue());
 
@@ -77,9 +119,19 @@ void Engine::Start() {
 }
 
 void Engine::Stop() {
+  // the replicate tasks report to the scheduler through the controller
+  // and the worker, and the local-only checkpoints would be lost
+  engine_elem_.checkpoint_io->WaitReplicated();
   mailbox_->Stop();
   worker_.reset();
   fetcher_.reset();
+  for (auto& fetch_server : fetch_servers_) {
+    LOG(INFO) << "[Engine] fetch server " << fetch_server->DebugString();
+  }
+  fetch_servers_.clear();
+  for (auto& shard : controller_->GetShards()) {
+    LOG(INFO) << "[Engine] controller shard " << shard->DebugString();
+  }
   controller_.reset();
 }
 
@@ -15,6 +15,7 @@
 #include "core/scheduler/worker.hpp"
 #include "core/engine_elem.hpp"
 #include "core/cache/fetcher.hpp"
+#include "core/cache/fetch_server.hpp"
 #include "comm/worker_mailbox.hpp"
 #include "comm/sender.hpp"
 
@@ -32,6 +33,30 @@ class Engine {
     int num_combine_threads;
     std::string namenode;
     int port;
+    // mailbox io, num_recv_sockets must be the same on all nodes
+    int num_io_threads = 1;
+    int num_sender_threads = 1;
+    int num_recv_sockets = 1;
+    bool separate_bulk_sockets = false;
+    bool use_ipc = false;
+    // flow control of the join messages, must be the same on all nodes
+    int num_credits_per_node = 0;
+    // progress reports batched per node, <=1 to send each report at once
+    int report_batch_size = 16;
+    int report_flush_ms = 5;
+    // # FetchServers serving the immutable fetch-object requests,
+    // 0 to serve them in the controller, must be the same on all nodes
+    int num_fetch_servers = 2;
+    // # controller threads the per-part join and fetch handling is sharded over,
+    // 1 to do everything in the controller thread
+    int num_controller_shards = 1;
+    // the checkpoints are written and read in chunks by these threads
+    int num_checkpoint_threads = 4;
+    size_t checkpoint_chunk_bytes = 16 << 20;
+    bool compress_checkpoint = true;
+    // the checkpoints are written to this local directory first and then
+    // copied to hdfs in the background, empty to write to hdfs directly
+    std::string checkpoint_local_dir;
     std::string DebugString() const {
       std::stringstream ss;
       ss << " { ";
@@ -42,6 +67,20 @@ class Engine {
       ss << ", num_combine_threads: " << num_combine_threads;
       ss << ", namenode: " << namenode;
       ss << ", port: " << port;
+      ss << ", num_io_threads: " << num_io_threads;
+      ss << ", num_sender_threads: " << num_sender_threads;
+      ss << ", num_recv_sockets: " << num_recv_sockets;
+      ss << ", separate_bulk_sockets: " << separate_bulk_sockets;
+      ss << ", use_ipc: " << use_ipc;
+      ss << ", num_credits_per_node: " << num_credits_per_node;
+      ss << ", report_batch_size: " << report_batch_size;
+      ss << ", report_flush_ms: " << report_flush_ms;
+      ss << ", num_fetch_servers: " << num_fetch_servers;
+      ss << ", num_controller_shards: " << num_controller_shards;
+      ss << ", num_checkpoint_threads: " << num_checkpoint_threads;
+      ss << ", checkpoint_chunk_bytes: " << checkpoint_chunk_bytes;
+      ss << ", compress_checkpoint: " << compress_checkpoint;
+      ss << ", checkpoint_local_dir: " << checkpoint_local_dir;
       ss << " } ";
       return ss.str();
     }
@@ -76,6 +115,7 @@ class Engine {
   std::shared_ptr<WorkerMailbox> mailbox_;
   std::shared_ptr<Worker> worker_;
   std::shared_ptr<Fetcher> fetcher_;
+  std::vector<std::shared_ptr<FetchServer>> fetch_servers_;
   std::shared_ptr<Controller> controller_;
 };
 
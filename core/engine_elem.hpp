@@ -10,6 +10,7 @@
 #include "comm/abstract_sender.hpp"
 #include "core/collection_map.hpp"
 #include "core/cache/fetcher.hpp"
+#include "core/scheduler/checkpoint_io.hpp"
 
 namespace xyz {
 
@@ -29,6 +30,17 @@ struct EngineElem {
   int num_local_threads;
   int num_update_threads;
   int num_combine_threads;
+  // credits per node for the join messages, <=0 means no flow control
+  int num_credits_per_node = 0;
+  // # finished parts reported to the scheduler in one message, <=1 means no batching
+  int report_batch_size = 16;
+  // the partial batches are flushed every report_flush_ms
+  int report_flush_ms = 5;
+  // # threads running the joins and fetches of the plans by part_id, 1 to run them in the controller
+  int num_controller_shards = 1;
+
+  // writes and reads the checkpoints (chunks, local tier)
+  std::shared_ptr<CheckpointIO> checkpoint_io;
 };
 
 }  // namespace xyz
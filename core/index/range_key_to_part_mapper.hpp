@@ -5,6 +5,7 @@
 
 #include <functional>
 #include <algorithm>
+#include <vector>
 
 #include "glog/logging.h"
 
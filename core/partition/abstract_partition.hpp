@@ -13,6 +13,19 @@ class AbstractPartition {
   virtual void ToBin(SArrayBinStream& bin) = 0;
 
   virtual size_t GetSize() const = 0;
+  // estimated memory footprint, used by the load balancing cost model
+  virtual size_t GetBytes() const { return GetSize(); }
+  // A read-only copy of the current content taken in O(1), the partition
+  // copies its content on the next write if the snapshot is still alive.
+  // nullptr if not supported.
+  virtual std::shared_ptr<AbstractPartition> Snapshot() { return nullptr; }
+  // Delta checkpoints: ToDeltaBin writes the changes since the last
+  // ResetDelta(), false (and nothing written) if a full image (ToBin) is
+  // needed instead.
+  // FromDeltaBin applies them on top of the previous image.
+  virtual bool ToDeltaBin(SArrayBinStream& bin) { return false; }
+  virtual void FromDeltaBin(SArrayBinStream& bin) { CHECK(false); }
+  virtual void ResetDelta() {}
   int id;
 };
 
@@ -45,6 +58,9 @@ class TypedPartition : public AbstractPartition {
   }
   virtual void TypedAdd(ObjT obj) = 0;
 
+  // memory owned by the objects (e.g. std::vector members) is not counted
+  virtual size_t GetBytes() const override { return GetSize() * sizeof(ObjT); }
+
   /*
    * Subclasses need to implement Iterator and implement CreateIterator() function
    * to support range-based for loop.
@@ -13,19 +13,30 @@ namespace xyz {
  * Use an unordered_map to track the unsorted part.
  * Requires ObjT to be in the form { ObjT::KeyT, ObjT::ValT }.
  * ObjT should have the function: Key().
+ *
+ * For the delta checkpoints, the objects written through Find/FindOrCreate
+ * and the objects added since the last ResetDelta() are tracked. ObjT may
+ * have ToDelta(SArrayBinStream&) const and FromDelta(SArrayBinStream&) to
+ * write only the fields that change (e.g. the rank but not the links),
+ * otherwise the whole object is written.
+ *
+ * Like the storage, the index and the dirty flags are shared with a
+ * Snapshot() and copied on the first write afterwards.
  */
 template <typename ObjT>
 class IndexedSeqPartition : public SeqPartition<ObjT>, public Indexable<ObjT> {
  public:
   virtual void TypedAdd(ObjT obj) override {
-    unsorted_[obj.Key()] = this->storage_.size();
-    this->storage_.push_back(std::move(obj));
+    auto& storage = this->MutableStorage();
+    MutableUnsorted()[obj.Key()] = storage.size();
+    storage.push_back(std::move(obj));
   }
 
+  // read only, does not copy the storage shared with a snapshot
   virtual ObjT Get(typename ObjT::KeyT key) override {
-    ObjT* obj = Find(key);
-    CHECK_NOTNULL(obj);
-    return *obj;
+    int pos = FindPos(key);
+    CHECK_NE(pos, -1);
+    return this->Storage()[pos];
   }
 
   virtual ObjT* FindOrCreate(typename ObjT::KeyT key) override {
@@ -36,56 +47,190 @@ class IndexedSeqPartition : public SeqPartition<ObjT>, public Indexable<ObjT> {
     // If cannot find, add it.
     ObjT new_obj(key);  // Assume the constructor is low cost.
     TypedAdd(std::move(new_obj));
-    return &this->storage_.back();
+    return &this->MutableStorage().back();
   }
 
   virtual ObjT* Find(typename ObjT::KeyT key) {
+    int pos = FindPos(key);
+    if (pos == -1) {
+      return nullptr;
+    }
+    MarkDirty(pos);
+    return &(this->MutableStorage()[pos]);
+  }
+
+  // the objects may be written in the loop, all of them are dirty
+  virtual typename TypedPartition<ObjT>::IterWrapper CreateIterator(bool is_begin) override {
+    all_dirty_ = true;
+    return SeqPartition<ObjT>::CreateIterator(is_begin);
+  }
+
+  virtual void FromBin(SArrayBinStream& bin) override {
+    bin >> this->MutableStorage();
+    bin >> MutableUnsorted();
+    bin >> sorted_size_;
+    // nothing is known about the last checkpoint
+    need_full_ = true;
+  }
+  virtual void ToBin(SArrayBinStream& bin) override {
+    bin << this->Storage();
+    bin << *unsorted_;
+    bin << sorted_size_;
+  }
+
+  // only the shared_ptrs are copied
+  virtual std::shared_ptr<AbstractPartition> Snapshot() override {
+    auto p = std::make_shared<IndexedSeqPartition<ObjT>>(*this);
+    p->id = this->id;
+    return p;
+  }
+
+  // <base size> <# dirty> (<pos> <delta>)... <# added> <obj>...
+  virtual bool ToDeltaBin(SArrayBinStream& bin) override {
+    if (need_full_) {
+      return false;
+    }
+    const auto& storage = this->Storage();
+    std::vector<int> dirty;
+    for (int i = 0; i < base_size_; ++ i) {
+      if (all_dirty_ || (i < dirty_->size() && (*dirty_)[i])) {
+        dirty.push_back(i);
+      }
+    }
+    bin << base_size_ << static_cast<int>(dirty.size());
+    for (int pos : dirty) {
+      bin << pos;
+      WriteDelta(bin, storage[pos], 0);
+    }
+    bin << static_cast<int>(storage.size() - base_size_);
+    for (int i = base_size_; i < storage.size(); ++ i) {
+      bin << storage[i];
+    }
+    return true;
+  }
+
+  virtual void FromDeltaBin(SArrayBinStream& bin) override {
+    int base_size, num_dirty, num_added;
+    bin >> base_size >> num_dirty;
+    CHECK_EQ(base_size, this->Storage().size());
+    auto& storage = this->MutableStorage();
+    for (int i = 0; i < num_dirty; ++ i) {
+      int pos;
+      bin >> pos;
+      CHECK_LT(pos, base_size);
+      ReadDelta(bin, storage[pos], 0);
+    }
+    bin >> num_added;
+    for (int i = 0; i < num_added; ++ i) {
+      ObjT obj;
+      bin >> obj;
+      TypedAdd(std::move(obj));
+    }
+  }
+
+  virtual void ResetDelta() override {
+    // do not clear the flags shared with a snapshot
+    dirty_ = std::make_shared<std::vector<bool>>();
+    all_dirty_ = false;
+    need_full_ = false;
+    base_size_ = this->Storage().size();
+  }
+
+  virtual void Sort() override {
+    auto& storage = this->MutableStorage();
+    std::sort(storage.begin(), storage.end(), [](const ObjT& a, const ObjT& b) { return a.Key() < b.Key(); });
+    unsorted_ = std::make_shared<IndexT>();
+    sorted_size_ = storage.size();
+    // the positions are changed
+    need_full_ = true;
+  }
+
+  size_t GetSortedSize() const {return this->Storage().size() - unsorted_->size(); }
+
+  size_t GetUnsortedSize() const { return unsorted_->size(); }
+
+ private:
+  // key -> position in the storage
+  using IndexT = std::unordered_map<typename ObjT::KeyT, size_t>;
+
+  // the position of key in the storage, -1 if not found
+  int FindPos(typename ObjT::KeyT key) const {
+    const auto& storage = this->Storage();
     ObjT obj(key);  // Assume the constructor is low cost.
     // 1. Find from sorted part.
     if (sorted_size_ != 0) {
-      auto it_end = this->storage_.begin()+sorted_size_;
-      auto it = std::lower_bound(this->storage_.begin(), it_end,
+      auto it_end = storage.begin()+sorted_size_;
+      auto it = std::lower_bound(storage.begin(), it_end,
               obj, [](const ObjT& a, const ObjT& b) {
         return a.Key() < b.Key();
       });
       if (it != it_end) {
-        return &(*it);
+        return it - storage.begin();
       }
     }
     // 2. Find from the unsorted part.
-    if (!unsorted_.empty()) {
-      auto it2 = unsorted_.find(key);
-      if (it2 != unsorted_.end()) {
-        return &(this->storage_[it2->second]);
+    if (!unsorted_->empty()) {
+      auto it2 = unsorted_->find(key);
+      if (it2 != unsorted_->end()) {
+        return it2->second;
       }
     }
-    return nullptr;
+    return -1;
   }
 
-  virtual void FromBin(SArrayBinStream& bin) override {
-    bin >> this->storage_;
-    bin >> unsorted_;
-    bin >> sorted_size_;
-  }
-  virtual void ToBin(SArrayBinStream& bin) override {
-    bin << this->storage_;
-    bin << unsorted_;
-    bin << sorted_size_;
+  void MarkDirty(int pos) {
+    // the added objects are written in full
+    if (all_dirty_ || pos >= base_size_) {
+      return;
+    }
+    if (dirty_.use_count() > 1) {
+      dirty_ = std::make_shared<std::vector<bool>>(*dirty_);
+    }
+    if (dirty_->size() < base_size_) {
+      dirty_->resize(base_size_, false);
+    }
+    (*dirty_)[pos] = true;
   }
 
-  virtual void Sort() override {
-    std::sort(this->storage_.begin(), this->storage_.end(), [](const ObjT& a, const ObjT& b) { return a.Key() < b.Key(); });
-    unsorted_.clear();
-    sorted_size_ = this->storage_.size();
+  IndexT& MutableUnsorted() {
+    if (unsorted_.use_count() > 1) {
+      // shared with a snapshot
+      unsorted_ = std::make_shared<IndexT>(*unsorted_);
+    }
+    return *unsorted_;
   }
 
-  size_t GetSortedSize() const {return this->storage_.size() - unsorted_.size(); }
-
-  size_t GetUnsortedSize() const { return unsorted_.size(); }
+  // use ObjT::ToDelta/FromDelta if there are
+  template <typename T>
+  static auto WriteDelta(SArrayBinStream& bin, const T& obj, int)
+      -> decltype(obj.ToDelta(bin), void()) {
+    obj.ToDelta(bin);
+  }
+  template <typename T>
+  static void WriteDelta(SArrayBinStream& bin, const T& obj, long) {
+    bin << obj;
+  }
+  template <typename T>
+  static auto ReadDelta(SArrayBinStream& bin, T& obj, int)
+      -> decltype(obj.FromDelta(bin), void()) {
+    obj.FromDelta(bin);
+  }
+  template <typename T>
+  static void ReadDelta(SArrayBinStream& bin, T& obj, long) {
+    bin >> obj;
+  }
 
- private:
-  std::unordered_map<typename ObjT::KeyT, size_t> unsorted_;
+  std::shared_ptr<IndexT> unsorted_ = std::make_shared<IndexT>();
   int sorted_size_ = 0;
+
+  // for the delta checkpoints
+  // # objs at the last ResetDelta(), the objs after it are added
+  int base_size_ = 0;
+  std::shared_ptr<std::vector<bool>> dirty_ = std::make_shared<std::vector<bool>>();
+  bool all_dirty_ = false;
+  // no ResetDelta() since the partition is created or loaded, or the
+  // objs are reordered
+  bool need_full_ = true;
 };
 
 }  // namespace
@@ -96,6 +96,107 @@ TEST_F(TestIndexedSeqPartition, FindOrCreate) {
   EXPECT_EQ(part.FindOrCreate(11)->val, 0);
 }
 
+TEST_F(TestIndexedSeqPartition, Snapshot) {
+  IndexedSeqPartition<ObjT> part;
+  part.Add(ObjT{1, 2});
+  part.Add(ObjT{2, 3});
+  part.Sort();
+  auto snapshot = part.Snapshot();
+  auto* typed = static_cast<IndexedSeqPartition<ObjT>*>(snapshot.get());
+  // Get does not copy the storage
+  EXPECT_EQ(part.Get(2).val, 3);
+  part.FindOrCreate(2)->val = 10;
+  part.FindOrCreate(5)->val = 1;
+  EXPECT_EQ(part.Get(2).val, 10);
+  EXPECT_EQ(typed->Get(2).val, 3);
+  EXPECT_EQ(typed->GetSize(), 2);
+  EXPECT_EQ(part.GetSize(), 3);
+}
+
+// only the val is in the delta
+struct DeltaObjT {
+  using KeyT = int;
+  DeltaObjT() = default;
+  DeltaObjT(KeyT _key):key(_key) {val = 0;}
+  DeltaObjT(KeyT _key, int _val):key(_key), val(_val) {}
+  int key;
+  int val;
+  KeyT Key() const { return key; }
+  void ToDelta(SArrayBinStream& bin) const { bin << val; }
+  void FromDelta(SArrayBinStream& bin) { bin >> val; }
+};
+
+TEST_F(TestIndexedSeqPartition, Delta) {
+  IndexedSeqPartition<DeltaObjT> part;
+  part.Add(DeltaObjT{1, 2});
+  part.Add(DeltaObjT{2, 3});
+  part.Add(DeltaObjT{3, 4});
+  SArrayBinStream delta_bin;
+  // a new partition has no base
+  EXPECT_FALSE(part.ToDeltaBin(delta_bin));
+  part.Sort();
+  SArrayBinStream base_bin;
+  part.ToBin(base_bin);
+  part.ResetDelta();
+
+  part.FindOrCreate(2)->val = 10;
+  part.FindOrCreate(5)->val = 1;
+  ASSERT_TRUE(part.ToDeltaBin(delta_bin));
+  // base size, 1 dirty obj (pos, val), 1 added obj
+  EXPECT_EQ(delta_bin.Size(), sizeof(int) * 5 + sizeof(DeltaObjT));
+
+  IndexedSeqPartition<DeltaObjT> recovered;
+  recovered.FromBin(base_bin);
+  recovered.FromDeltaBin(delta_bin);
+  EXPECT_EQ(recovered.GetSize(), 4);
+  EXPECT_EQ(recovered.Get(1).val, 2);
+  EXPECT_EQ(recovered.Get(2).val, 10);
+  EXPECT_EQ(recovered.Get(3).val, 4);
+  EXPECT_EQ(recovered.Get(5).val, 1);
+
+  // the loop may write all the objs
+  part.ResetDelta();
+  for (auto& obj : part) {
+    obj.val += 1;
+  }
+  SArrayBinStream delta_bin2;
+  ASSERT_TRUE(part.ToDeltaBin(delta_bin2));
+  recovered.FromDeltaBin(delta_bin2);
+  EXPECT_EQ(recovered.Get(1).val, 3);
+  EXPECT_EQ(recovered.Get(5).val, 2);
+
+  part.Sort();
+  SArrayBinStream delta_bin3;
+  EXPECT_FALSE(part.ToDeltaBin(delta_bin3));
+}
+
+TEST_F(TestIndexedSeqPartition, SnapshotDelta) {
+  IndexedSeqPartition<DeltaObjT> part;
+  part.Add(DeltaObjT{1, 2});
+  part.Add(DeltaObjT{2, 3});
+  part.Sort();
+  part.ResetDelta();
+  part.FindOrCreate(2)->val = 10;
+  part.FindOrCreate(5)->val = 1;
+  auto snapshot = part.Snapshot();
+  auto* typed = static_cast<IndexedSeqPartition<DeltaObjT>*>(snapshot.get());
+  part.ResetDelta();
+
+  // the writes after the snapshot do not change its index and dirty objs
+  part.FindOrCreate(1)->val = 7;
+  part.FindOrCreate(6)->val = 1;
+  EXPECT_EQ(part.GetUnsortedSize(), 2);
+  EXPECT_EQ(typed->GetUnsortedSize(), 1);
+  EXPECT_EQ(typed->Get(5).val, 1);
+  SArrayBinStream delta_bin;
+  ASSERT_TRUE(typed->ToDeltaBin(delta_bin));
+  // base size, 1 dirty obj (pos, val), 1 added obj
+  EXPECT_EQ(delta_bin.Size(), sizeof(int) * 5 + sizeof(DeltaObjT));
+  SArrayBinStream delta_bin2;
+  ASSERT_TRUE(part.ToDeltaBin(delta_bin2));
+  EXPECT_EQ(delta_bin2.Size(), sizeof(int) * 5 + sizeof(DeltaObjT));
+}
+
 
 }  // namespace
 }  // namespace xyz
@@ -14,8 +14,9 @@ class RangeIndexedSeqPartition : public SeqPartition<ObjT>, public Indexable<Obj
   RangeIndexedSeqPartition() = default;
   RangeIndexedSeqPartition(const third_party::Range& range): range_(range) {
     CHECK_GE(range_.size(), 0);
+    auto& storage = this->MutableStorage();
     for (int i = range_.begin(); i < range_.end(); ++ i) {
-      this->storage_.push_back(ObjT(i));
+      storage.push_back(ObjT(i));
     }
   }
 
@@ -24,10 +25,11 @@ class RangeIndexedSeqPartition : public SeqPartition<ObjT>, public Indexable<Obj
     // this->storage_[obj.Key()] = std::move(obj);
   }
 
+  // read only, does not copy the storage shared with a snapshot
   virtual ObjT Get(typename ObjT::KeyT key) override {
-    ObjT* obj = Find(key);
-    CHECK_NOTNULL(obj);
-    return *obj;
+    CHECK_GE(key, range_.begin());
+    CHECK_LT(key, range_.end());
+    return this->Storage()[key - range_.begin()];
   }
 
   virtual ObjT* FindOrCreate(typename ObjT::KeyT key) override {
@@ -41,26 +43,32 @@ class RangeIndexedSeqPartition : public SeqPartition<ObjT>, public Indexable<Obj
     // If cannot find, add it.
     ObjT new_obj(key);  // Assume the constructor is low cost.
     TypedAdd(std::move(new_obj));
-    return &this->storage_[key];
+    return &this->MutableStorage()[key];
     */
   }
 
   virtual ObjT* Find(typename ObjT::KeyT key) {
     CHECK_GE(key, range_.begin());
     CHECK_LT(key, range_.end());
-    return &this->storage_[key - range_.begin()];
+    return &this->MutableStorage()[key - range_.begin()];
   }
 
   virtual void FromBin(SArrayBinStream& bin) override {
-    bin >> this->storage_;
+    bin >> this->MutableStorage();
     bin >> range_;
   }
   
   virtual void ToBin(SArrayBinStream& bin) override {
-    bin << this->storage_;
+    bin << this->Storage();
     bin << range_;
   }
 
+  virtual std::shared_ptr<AbstractPartition> Snapshot() override {
+    auto p = std::make_shared<RangeIndexedSeqPartition<ObjT>>(*this);
+    p->id = this->id;
+    return p;
+  }
+
   virtual void Sort() override {
     LOG(INFO) << "Do Nothing";
   }
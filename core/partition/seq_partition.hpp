@@ -7,21 +7,32 @@ namespace xyz {
 /*
  * Basic sequential partition implementation.
  * Support range-based for loop.
+ *
+ * The storage is copy-on-write: Snapshot() shares it and the partition
+ * copies it on the first write access (MutableStorage()) afterwards.
+ * The pointers and iterators taken before a snapshot are invalid after
+ * the next write access.
  */
 template <typename ObjT>
 class SeqPartition : public TypedPartition<ObjT> {
  public:
   virtual void TypedAdd(ObjT obj) override {
-    storage_.push_back(std::move(obj));
+    MutableStorage().push_back(std::move(obj));
   }
 
-  virtual size_t GetSize() const override { return storage_.size(); }
+  virtual size_t GetSize() const override { return Storage().size(); }
 
   virtual void FromBin(SArrayBinStream& bin) override {
-    bin >> storage_;
+    bin >> MutableStorage();
   }
   virtual void ToBin(SArrayBinStream& bin) override {
-    bin << storage_;
+    bin << Storage();
+  }
+
+  virtual std::shared_ptr<AbstractPartition> Snapshot() override {
+    auto p = std::make_shared<SeqPartition<ObjT>>(*this);
+    p->id = this->id;
+    return p;
   }
 
   /*
@@ -47,23 +58,36 @@ class SeqPartition : public TypedPartition<ObjT> {
 
   virtual typename TypedPartition<ObjT>::IterWrapper CreateIterator(bool is_begin) override {
     typename TypedPartition<ObjT>::IterWrapper iw;
-    if (storage_.empty()) {
+    auto& storage = MutableStorage();
+    if (storage.empty()) {
       iw.iter.reset(new typename SeqPartition<ObjT>::Iterator(nullptr, 0));
       return iw;
     }
     if (is_begin) {
-      iw.iter.reset(new typename SeqPartition<ObjT>::Iterator(&storage_[0], 0));
+      iw.iter.reset(new typename SeqPartition<ObjT>::Iterator(&storage[0], 0));
     } else {
-      iw.iter.reset(new typename SeqPartition<ObjT>::Iterator(&storage_[0], storage_.size()));
+      iw.iter.reset(new typename SeqPartition<ObjT>::Iterator(&storage[0], storage.size()));
     }
     return iw;
   }
 
   std::vector<ObjT> GetStorage() {
-    return storage_;
+    return Storage();
   }
  protected:
-  std::vector<ObjT> storage_;
+  const std::vector<ObjT>& Storage() const {
+    return *storage_;
+  }
+  std::vector<ObjT>& MutableStorage() {
+    if (storage_.use_count() > 1) {
+      // shared with a snapshot
+      storage_ = std::make_shared<std::vector<ObjT>>(*storage_);
+    }
+    return *storage_;
+  }
+
+ private:
+  std::shared_ptr<std::vector<ObjT>> storage_ = std::make_shared<std::vector<ObjT>>();
 };
 
 }  // namespace
@@ -56,6 +56,29 @@ TEST_F(TestSeqPartition, Bin) {
   ASSERT_EQ(new_part.GetSize(), 2);
 }
 
+TEST_F(TestSeqPartition, Snapshot) {
+  SeqPartition<ObjT> part;
+  part.id = 3;
+  part.Add(ObjT{1, 2});
+  auto snapshot = part.Snapshot();
+  ASSERT_NE(snapshot, nullptr);
+  EXPECT_EQ(snapshot->id, 3);
+  // writes after the snapshot do not change it
+  part.Add(ObjT{2, 3});
+  for (auto& elem : part) {
+    elem.val = 10;
+  }
+  EXPECT_EQ(part.GetSize(), 2);
+  auto* typed = static_cast<SeqPartition<ObjT>*>(snapshot.get());
+  ASSERT_EQ(typed->GetSize(), 1);
+  EXPECT_EQ(typed->GetStorage()[0].val, 2);
+  SArrayBinStream bin;
+  snapshot->ToBin(bin);
+  SeqPartition<ObjT> new_part;
+  new_part.FromBin(bin);
+  ASSERT_EQ(new_part.GetSize(), 1);
+}
+
 }  // namespace
 }  // namespace xyz
 
@@ -5,6 +5,7 @@ namespace xyz {
 Store<CollectionBase> Context::collections_;
 Store<PlanBase> Context::plans_;
 Dag Context::dag_;
+std::map<int, int> Context::copartitions_;
 
 } // namespace xyz
 
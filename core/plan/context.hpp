@@ -27,6 +27,15 @@ struct return_type<ReturnType(ClassType::*)(Args...) const>
     using type = ReturnType;
 };
 
+// whether f(boost::string_ref) compiles, a std::string can not be made
+// from a boost::string_ref implicitly
+template <typename F, typename = void>
+struct takes_string_ref : std::false_type {};
+
+template <typename F>
+struct takes_string_ref<F, decltype(void(std::declval<F>()(std::declval<boost::string_ref>())))>
+    : std::true_type {};
+
 template <typename T>
 struct function_traits
     : public function_traits<decltype(&T::operator())>
@@ -143,7 +152,7 @@ class Context {
       [](D* d, D msg) {
         *d = msg;
       })->SetName(prefix+"::mapupdate");
-    // TODO, remove tmp_c
+    // tmp_c is released by the scheduler once the mapupdate finishes
     return c;
   }
 
@@ -158,18 +167,18 @@ class Context {
       },
       [](CountObjT*, int) {
         // dummy
-      })->SetName(prefix+"::mapupdate");
-    // TODO: remove tmp_c
+      })->SetName(prefix+"::mapupdate")->SetMapOnly();
+    // tmp_c is dropped if the plan is fused, see plan_fusion.hpp
   }
 
+  /*
+   * parse is called on each line, a parse taking a boost::string_ref gets
+   * the line in place without a std::string per line, e.g.
+   * Context::load(url, [](boost::string_ref line) { ... });
+   */
   template<typename Parse>
   static auto* load(std::string url, Parse parse, int max_line_per_part = -1, std::string name = "") {
-    using D = decltype(parse(*(std::string*)nullptr));
-    auto* c = collections_.make<Collection<D, SeqPartition<D>>>();
-    auto* p = plans_.make<Load<D>>(c->Id(), url, parse, max_line_per_part, false);
-    p->name = name+"::load";
-    dag_.AddDagNode(p->plan_id, {}, {c->Id()});
-    return c;
+    return load(url, parse, max_line_per_part, name, takes_string_ref<Parse>());
   }
   template<typename Parse>
   static auto* load_wholefiles(std::string url, Parse parse, int max_line_per_part = -1, std::string name = "") {
@@ -283,7 +292,7 @@ class Context {
     auto *p = plans_.make<MapJoin<C1, C2, typename C1::ObjT, typename C2::ObjT, MsgT>>(c1, c2);
     p->map = m;
     p->update = j;
-    dag_.AddDagNode(p->plan_id, {c1->Id()}, {c2->Id()});
+    dag_.AddDagNode(p->plan_id, {c1->Id()}, {c2->Id()}, c1->Id());
     return p;
   }
 
@@ -296,7 +305,7 @@ class Context {
     auto *p = plans_.make<MapPartJoin<C1, C2, typename C1::ObjT, typename C2::ObjT, MsgT>>(c1, c2);
     p->mappart = m;
     p->update = j;
-    dag_.AddDagNode(p->plan_id, {c1->Id()}, {c2->Id()});
+    dag_.AddDagNode(p->plan_id, {c1->Id()}, {c2->Id()}, c1->Id());
     return p;
   }
 
@@ -317,7 +326,7 @@ class Context {
     foreach(count_collection, [](const CountObjT& obj) {
       LOG(INFO) << "********** count: " << obj.b << " *********";
     });
-    // TODO: remove count_collection
+    // count_collection is released by the scheduler after the foreach
   }
 
   template<typename C1, typename C2, typename C3, typename M, typename J>
@@ -333,7 +342,7 @@ class Context {
     auto *p = plans_.make<MapPartWithJoin<C1, C2, C3, typename C1::ObjT, typename C2::ObjT, typename C3::ObjT, MsgT>>(c1, c2, c3);
     p->mappartwith = m;
     p->update = j;
-    dag_.AddDagNode(p->plan_id, {c1->Id(), c2->Id()}, {c3->Id()});
+    dag_.AddDagNode(p->plan_id, {c1->Id(), c2->Id()}, {c3->Id()}, c1->Id());
     return p;
   }
 
@@ -355,7 +364,17 @@ class Context {
       },
       [](typename C::ObjT*, int) {
         // dummy
-      })->SetName("sort each part for "+c->Name());
+      })->SetName("sort each part for "+c->Name())->SetMapOnly();
+  }
+
+  // place partition i of c on the node of partition i of with, so that the
+  // messages between them stay local (see local_map_mode_ in PlanController).
+  // c should be distributed (e.g. placeholder) after with is created and
+  // have the same number of partitions, otherwise it is placed as usual.
+  template<typename C1, typename C2>
+  static void copartition(C1* c, C2* with) {
+    CHECK_NE(c->Id(), with->Id());
+    copartitions_[c->Id()] = with->Id();
   }
 
   static auto get_allplans() {
@@ -367,10 +386,37 @@ class Context {
   static const Dag& get_dag() {
     return dag_;
   }
+  static const std::map<int, int>& get_copartitions() {
+    return copartitions_;
+  }
  private:
+  template<typename Parse>
+  static auto* load(std::string url, Parse parse, int max_line_per_part,
+          std::string name, std::false_type) {
+    using D = decltype(parse(*(std::string*)nullptr));
+    auto* c = collections_.make<Collection<D, SeqPartition<D>>>();
+    auto* p = plans_.make<Load<D>>(c->Id(), url, parse, max_line_per_part, false);
+    p->name = name+"::load";
+    dag_.AddDagNode(p->plan_id, {}, {c->Id()});
+    return c;
+  }
+  template<typename Parse>
+  static auto* load(std::string url, Parse parse, int max_line_per_part,
+          std::string name, std::true_type) {
+    using D = decltype(parse(boost::string_ref()));
+    auto* c = collections_.make<Collection<D, SeqPartition<D>>>();
+    auto* p = plans_.make<Load<D>>(c->Id(), url, 
+            std::function<D(boost::string_ref)>(parse), max_line_per_part);
+    p->name = name+"::load";
+    dag_.AddDagNode(p->plan_id, {}, {c->Id()});
+    return c;
+  }
+
   static Store<CollectionBase> collections_;
   static Store<PlanBase> plans_;
   static Dag dag_;
+  // collection_id -> the collection it is placed with
+  static std::map<int, int> copartitions_;
 };
 
 } // namespace xyz
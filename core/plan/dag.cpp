@@ -1,5 +1,7 @@
 #include "core/plan/dag.hpp"
 
+#include <algorithm>
+
 namespace xyz {
 
 std::string DagNode::DebugString() const {
@@ -20,17 +22,33 @@ std::string DagNode::DebugString() const {
     }
   }
   ss << "}";
+  if (!pipelined_in.empty()) {
+    ss << ", pipelined_in:{";
+    for (int i = 0; i < pipelined_in.size(); ++ i) {
+      ss << pipelined_in[i];
+      if (i != pipelined_in.size() - 1) {
+        ss << ", ";
+      }
+    }
+    ss << "}";
+  }
   return ss.str();
 }
 
-void Dag::AddDagNode(int id, std::vector<int> read, std::vector<int> write) {
+void Dag::AddDagNode(int id, std::vector<int> read, std::vector<int> write,
+        int partitionwise_read) {
   DagNode* node = GetOrCreateDagNode(id);
+  node->partitionwise_read = partitionwise_read;
   std::set<int> dependencies;
+  std::set<int> full_dependencies;  // not only through partitionwise_read
   for (auto c : read) {
     Col* col = GetOrCreateCol(c);
     int p = col->GetLastWrite();
     if (p != -1) {
       dependencies.insert(p);
+      if (c != partitionwise_read) {
+        full_dependencies.insert(p);
+      }
     }
     col->AppendRead(id);
   }
@@ -39,12 +57,47 @@ void Dag::AddDagNode(int id, std::vector<int> read, std::vector<int> write) {
     int p = col->GetLastWrite();
     if (p != -1) {
       dependencies.insert(p);
+      full_dependencies.insert(p);
     }
     col->AppendWrite(id);
   }
   for (auto d : dependencies) {
     AddEdge(d, id);
+    if (full_dependencies.find(d) == full_dependencies.end()) {
+      GetOrCreateDagNode(id)->pipelined_in.push_back(d);
+    }
+  }
+}
+
+std::pair<std::vector<int>, std::vector<int>> Dag::GetReadWrite(int id) const {
+  std::pair<std::vector<int>, std::vector<int>> ret;
+  for (auto& col : cols_) {
+    auto& r = col.second.read_queue;
+    auto& w = col.second.write_queue;
+    if (std::find(r.begin(), r.end(), id) != r.end()) {
+      ret.first.push_back(col.first);
+    }
+    if (std::find(w.begin(), w.end(), id) != w.end()) {
+      ret.second.push_back(col.first);
+    }
+  }
+  return ret;
+}
+
+int Dag::GetPartitionwiseRead(int id) const {
+  auto it = nodes_.find(id);
+  CHECK(it != nodes_.end());
+  return it->second.partitionwise_read;
+}
+
+std::map<int, std::set<int>> Dag::GetCollectionUsers() const {
+  std::map<int, std::set<int>> ret;
+  for (auto& col : cols_) {
+    auto& users = ret[col.first];
+    users.insert(col.second.read_queue.begin(), col.second.read_queue.end());
+    users.insert(col.second.write_queue.begin(), col.second.write_queue.end());
   }
+  return ret;
 }
 
 std::string Dag::DebugString() const {
@@ -81,6 +134,7 @@ DagVistor::DagVistor(const Dag& dag) {
  cols_ = dag.cols_;
  for (auto& node: nodes_) {
    indegrees_[node.second.id] = node.second.in.size();
+   pipelined_indegrees_[node.second.id] = node.second.pipelined_in.size();
  }
 }
 
@@ -101,9 +155,61 @@ void DagVistor::Finish(int id) {
   for (auto child : node->out) {
     indegrees_[child] -= 1;
     CHECK_GE(indegrees_[child], 0);
+    auto& pipelined_in = nodes_[child].pipelined_in;
+    if (std::find(pipelined_in.begin(), pipelined_in.end(), id) != pipelined_in.end()) {
+      pipelined_indegrees_[child] -= 1;
+      CHECK_GE(pipelined_indegrees_[child], 0);
+    }
+  }
+  // the readers do not need the partition level information anymore
+  for (auto& col : cols_) {
+    auto& w = col.second.write_queue;
+    if (std::find(w.begin(), w.end(), id) != w.end()) {
+      ready_parts_.erase(col.first);
+    }
   }
   nodes_.erase(id);
   indegrees_.erase(id);
+  pipelined_indegrees_.erase(id);
+}
+
+std::vector<int> DagVistor::GetPipelinedFront() {
+  std::vector<int> ret;
+  for (auto& node : nodes_) {
+    int id = node.second.id;
+    if (indegrees_[id] > 0 && indegrees_[id] == pipelined_indegrees_[id]) {
+      ret.push_back(id);
+    }
+  }
+  return ret;
+}
+
+std::vector<int> DagVistor::GetUnfinishedIn(int id) {
+  CHECK(nodes_.find(id) != nodes_.end());
+  std::vector<int> ret;
+  for (auto in : nodes_[id].in) {
+    if (nodes_.find(in) != nodes_.end()) {
+      ret.push_back(in);
+    }
+  }
+  return ret;
+}
+
+int DagVistor::GetPartitionwiseRead(int id) {
+  CHECK(nodes_.find(id) != nodes_.end());
+  return nodes_[id].partitionwise_read;
+}
+
+void DagVistor::FinishPart(int collection_id, int part_id) {
+  ready_parts_[collection_id].insert(part_id);
+}
+
+std::vector<int> DagVistor::GetReadyParts(int id) {
+  int c = GetPartitionwiseRead(id);
+  if (ready_parts_.find(c) == ready_parts_.end()) {
+    return {};
+  }
+  return std::vector<int>(ready_parts_[c].begin(), ready_parts_[c].end());
 }
 
 } // namespace xyz
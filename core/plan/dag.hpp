@@ -41,6 +41,11 @@ struct DagNode {
   int id;  // the plan id
   std::vector<int> out;
   std::vector<int> in;
+  // the collection this node reads partition by partition (e.g. maps over), -1 if none
+  int partitionwise_read = -1;
+  // the in nodes that only write partitionwise_read, this node can run on
+  // partition i once they finish partition i
+  std::vector<int> pipelined_in;
 
   DagNode() = default;
   DagNode(int _id): id(_id) {}
@@ -53,18 +58,27 @@ struct DagNode {
   std::string DebugString() const;
 
   friend SArrayBinStream& operator<<(xyz::SArrayBinStream& stream, const DagNode& n) {
-    stream << n.id << n.out << n.in;
+    stream << n.id << n.out << n.in << n.partitionwise_read << n.pipelined_in;
   	return stream;
   }
   friend SArrayBinStream& operator>>(xyz::SArrayBinStream& stream, DagNode& n) {
-    stream >> n.id >> n.out >> n.in;
+    stream >> n.id >> n.out >> n.in >> n.partitionwise_read >> n.pipelined_in;
   	return stream;
   }
 };
 
 class Dag {
  public:
-  void AddDagNode(int id, std::vector<int> read, std::vector<int> write);
+  // partitionwise_read: the collection in read that the plan reads
+  // partition by partition, -1 if none
+  void AddDagNode(int id, std::vector<int> read, std::vector<int> write,
+          int partitionwise_read = -1);
+
+  // the arguments node id was added with
+  std::pair<std::vector<int>, std::vector<int>> GetReadWrite(int id) const;
+  int GetPartitionwiseRead(int id) const;
+  // collection_id -> the nodes reading or writing it
+  std::map<int, std::set<int>> GetCollectionUsers() const;
 
   std::string DebugString() const;
   friend class DagVistor;
@@ -95,10 +109,24 @@ class DagVistor {
   int GetNumDagNodes() {
     return nodes_.size();
   }
+
+  // partition level
+  // the nodes that only wait for pipelined in nodes
+  std::vector<int> GetPipelinedFront();
+  // the in nodes not finished yet
+  std::vector<int> GetUnfinishedIn(int id);
+  int GetPartitionwiseRead(int id);
+  // partition part_id of collection_id is written by its last writer
+  void FinishPart(int collection_id, int part_id);
+  // the finished parts of the collection node id reads partitionwise
+  std::vector<int> GetReadyParts(int id);
  private:
   std::map<int, DagNode> nodes_;
   std::map<int, int> indegrees_;
+  std::map<int, int> pipelined_indegrees_;
   std::map<int, Col> cols_;
+  // collection_id -> finished part_ids
+  std::map<int, std::set<int>> ready_parts_;
 };
 
 } // namespace xyz
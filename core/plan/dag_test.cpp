@@ -36,6 +36,61 @@ TEST_F(TestDag, Vistor) {
   }
 }
 
+TEST_F(TestDag, PipelinedFront) {
+  Dag d;
+  d.AddDagNode(0, {}, {0});  // load 0
+  d.AddDagNode(1, {}, {1});  // load 1
+  d.AddDagNode(2, {0}, {1}, 0);  // mapupdate 0 -> 1
+  d.AddDagNode(3, {1}, {2}, 1);  // mapupdate 1 -> 2, pipelined after 2
+  d.AddDagNode(4, {2}, {1}, 2);  // mapupdate 2 -> 1, writes 1
+
+  DagVistor v(d);
+  EXPECT_EQ(v.GetFront(), std::vector<int>({0, 1}));
+  // whether the in nodes are running is up to the dag runner
+  EXPECT_EQ(v.GetPipelinedFront(), std::vector<int>({3}));
+  v.Finish(0);
+  v.Finish(1);
+  EXPECT_EQ(v.GetFront(), std::vector<int>({2}));
+  EXPECT_EQ(v.GetPipelinedFront(), std::vector<int>({3}));
+  // 4 reads 2 partitionwise but also writes 1
+  EXPECT_EQ(v.GetUnfinishedIn(4), std::vector<int>({2, 3}));
+  EXPECT_EQ(v.GetUnfinishedIn(3), std::vector<int>({2}));
+  EXPECT_EQ(v.GetPartitionwiseRead(3), 1);
+
+  v.FinishPart(1, 2);
+  v.FinishPart(1, 0);
+  EXPECT_EQ(v.GetReadyParts(3), std::vector<int>({0, 2}));
+  v.Finish(2);
+  EXPECT_EQ(v.GetFront(), std::vector<int>({3}));
+  EXPECT_TRUE(v.GetReadyParts(3).empty());
+  EXPECT_EQ(v.GetPipelinedFront(), std::vector<int>({4}));
+}
+
+TEST_F(TestDag, GetCollectionUsers) {
+  Dag d;
+  d.AddDagNode(0, {}, {0});
+  d.AddDagNode(1, {}, {1});
+  d.AddDagNode(2, {0}, {1}, 0);
+  auto users = d.GetCollectionUsers();
+  ASSERT_EQ(users.size(), 2);
+  EXPECT_EQ(users[0], std::set<int>({0, 2}));
+  EXPECT_EQ(users[1], std::set<int>({1, 2}));
+}
+
+TEST_F(TestDag, SerializePipelined) {
+  Dag d;
+  d.AddDagNode(0, {}, {0});
+  d.AddDagNode(1, {0}, {1}, 0);
+  d.AddDagNode(2, {1}, {2}, 1);
+  SArrayBinStream bin;
+  bin << d;
+  Dag d2;
+  bin >> d2;
+  DagVistor v(d2);
+  v.Finish(0);
+  EXPECT_EQ(v.GetPipelinedFront(), std::vector<int>({2}));
+}
+
 }  // namespace
 }  // namespace xyz
 
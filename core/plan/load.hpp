@@ -3,6 +3,8 @@
 #include "core/plan/plan_base.hpp"
 #include "core/partition/seq_partition.hpp"
 
+#include "boost/utility/string_ref.hpp"
+
 namespace xyz {
 
 template<typename T>
@@ -13,6 +15,13 @@ struct Load : public PlanBase {
         parse_line(f), max_line_per_part(l), is_load_meta(false),
         is_whole_file(_is_whole_file) {}
 
+  // parse the lines in place, see Context::load
+  Load(int _plan_id, int _collection_id, std::string _url, 
+          std::function<T(boost::string_ref)> f, int l)
+      : PlanBase(_plan_id), collection_id(_collection_id), url(_url), 
+        parse_line_view(f), max_line_per_part(l), is_load_meta(false),
+        is_whole_file(false) {}
+
   Load(int _plan_id, int _collection_id, std::string _url, bool _is_whole_file)
     : PlanBase(_plan_id), collection_id(_collection_id), url(_url), 
     is_load_meta(true), is_whole_file(_is_whole_file) {
@@ -30,6 +39,21 @@ struct Load : public PlanBase {
     if (is_load_meta) {
       return;
     }
+    if (parse_line_view) {
+      function_store->AddCreatePartFromBlockReaderFunc(collection_id, [this](std::shared_ptr<AbstractBlockReader> reader) {
+        auto part = std::make_shared<SeqPartition<T>>();
+        int count = 0;
+        while (reader->HasLine()) {
+          part->Add(parse_line_view(reader->GetLineView()));
+          count += 1;
+          if (count == max_line_per_part) {
+            break;
+          }
+        }
+        return part;
+      });
+      return;
+    }
     CHECK(parse_line);
     function_store->AddCreatePartFromBlockReaderFunc(collection_id, [this](std::shared_ptr<AbstractBlockReader> reader) {
       auto part = std::make_shared<SeqPartition<T>>();
@@ -68,6 +92,7 @@ struct Load : public PlanBase {
 
  private:
   std::function<T(std::string)> parse_line;
+  std::function<T(boost::string_ref)> parse_line_view;
   std::string url;
   int collection_id;
 
@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include "glog/logging.h"
+
+#include "core/plan/context.hpp"
+#include "core/plan/function_store.hpp"
+#include "core/plan/load.hpp"
+
+namespace xyz {
+namespace {
+
+class TestLoad: public testing::Test {};
+
+// the lines are views into one buffer
+struct BufferBlockReader : public AbstractBlockReader {
+  BufferBlockReader(std::string buffer) : buffer_(buffer) {}
+  virtual void Init(std::string url, size_t offset) override {}
+  virtual std::vector<std::string> ReadBlock() override { return {}; }
+  virtual bool HasLine() override {
+    if (pos_ >= buffer_.size()) {
+      return false;
+    }
+    size_t end = std::min(buffer_.find('\n', pos_), buffer_.size());
+    line_ = boost::string_ref(buffer_).substr(pos_, end - pos_);
+    pos_ = end + 1;
+    return true;
+  }
+  virtual std::string GetLine() override { return line_.to_string(); }
+  virtual boost::string_ref GetLineView() override {
+    num_views_ += 1;
+    return line_;
+  }
+  virtual int GetNumLineRead() override { return num_views_; }
+
+  std::string buffer_;
+  size_t pos_ = 0;
+  boost::string_ref line_;
+  int num_views_ = 0;
+};
+
+TEST_F(TestLoad, TakesStringRef) {
+  auto by_view = [](boost::string_ref s) { return s.size(); };
+  auto by_string = [](std::string s) { return s.size(); };
+  auto by_ref = [](const std::string& s) { return s.size(); };
+  EXPECT_TRUE(takes_string_ref<decltype(by_view)>::value);
+  EXPECT_FALSE(takes_string_ref<decltype(by_string)>::value);
+  EXPECT_FALSE(takes_string_ref<decltype(by_ref)>::value);
+}
+
+TEST_F(TestLoad, ParseLineView) {
+  Load<int> load(0, 1, "dummy", 
+          std::function<int(boost::string_ref)>([](boost::string_ref s) { return int(s.size()); }), -1);
+  auto function_store = std::make_shared<FunctionStore>();
+  load.Register(function_store);
+  auto reader = std::make_shared<BufferBlockReader>("a\nbb\n\nccc");
+  auto part = function_store->GetCreatePartFromBlockReader(1)(reader);
+  auto* seq_part = static_cast<SeqPartition<int>*>(part.get());
+  ASSERT_EQ(seq_part->GetSize(), 4);
+  std::vector<int> sizes;
+  for (auto s : *seq_part) {
+    sizes.push_back(s);
+  }
+  EXPECT_EQ(sizes, std::vector<int>({1, 2, 0, 3}));
+  // no line is copied
+  EXPECT_EQ(reader->num_views_, 4);
+}
+
+}  // namespace
+}  // namespace xyz
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <mutex>
+#include <map>
+#include <memory>
 #include <sstream>
 
 #include "core/plan/plan_base.hpp"
@@ -51,9 +54,20 @@ struct MapPartJoin : public PlanBase {
     num_iter = iter;
     return this;
   }
-  MapPartJoin<C1, C2, ObjT1, ObjT2, MsgT>* SetCheckpointInterval(int cp, std::string path = "/tmp/tmp") {
+  // num_deltas: # delta checkpoints (only the changed objects) after each
+  // full checkpoint, see IndexedSeqPartition
+  MapPartJoin<C1, C2, ObjT1, ObjT2, MsgT>* SetCheckpointInterval(int cp, std::string path = "/tmp/tmp",
+          int num_deltas = 0) {
     checkpoint_interval = cp;
     checkpoint_path = path;
+    num_delta_checkpoints = num_deltas;
+    return this;
+  }
+  // keep the join messages of the last num_versions versions, a failure
+  // then only reloads and replays the lost partitions, it should cover the
+  // checkpoint interval (plus the staleness)
+  MapPartJoin<C1, C2, ObjT1, ObjT2, MsgT>* SetMessageLog(int num_versions) {
+    num_log_versions = num_versions;
     return this;
   }
 
@@ -75,14 +89,67 @@ struct MapPartJoin : public PlanBase {
     w.SetSpec<MapJoinSpec>(plan_id, SpecWrapper::Type::kMapJoin,
             map_collection->Id(), update_collection->Id(), combine_timeout, num_iter, 
             staleness, checkpoint_interval, checkpoint_path, description_);
+    w.GetMapJoinSpec()->num_delta_checkpoints = num_delta_checkpoints;
+    w.GetMapJoinSpec()->num_log_versions = num_log_versions;
+    w.GetMapJoinSpec()->has_prologue = !prologue_state->prologues.empty();
     w.name = name;
     return w;
   }
 
+  // the update is a dummy, the plan only runs for the effect of its map
+  // (e.g. foreach, sort_each_partition), so it can be fused
+  MapPartJoin<C1, C2, ObjT1, ObjT2, MsgT>* SetMapOnly() {
+    map_only = true;
+    return this;
+  }
+
+  virtual PlanBase::PartFuncT GetMapOnlyFunc() override {
+    if (!map_only) {
+      return nullptr;
+    }
+    auto map_part = GetMapPartFunc();
+    auto prologues = prologue_state->prologues;
+    return [map_part, prologues](std::shared_ptr<AbstractPartition> partition) {
+      for (auto& f : prologues) {
+        f(partition);
+      }
+      map_part(partition);  // the output goes to the dummy update
+    };
+  }
+
+  virtual bool AddPrologue(int map_collection_id, PlanBase::PartFuncT f) override {
+    if (map_collection_id != map_collection->Id()) {
+      return false;
+    }
+    prologue_state->prologues.push_back(std::move(f));
+    return true;
+  }
+
+  // run the prologues once for each partition before its first map, again
+  // if the partition is replaced, e.g. reloaded in a recovery
+  void RunPrologues(std::shared_ptr<AbstractPartition> partition) {
+    auto& state = *prologue_state;
+    if (state.prologues.empty()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lk(state.mu);
+      auto& done = state.done[partition->id];
+      if (done.lock() == partition) {
+        return;
+      }
+      done = partition;
+    }
+    for (auto& f : state.prologues) {
+      f(partition);
+    }
+  }
+
   virtual void Register(std::shared_ptr<AbstractFunctionStore> function_store) override {
     auto map_part = GetMapPartFunc();
     function_store->AddMap(plan_id, [this, map_part](
                 std::shared_ptr<AbstractPartition> partition) {
+      RunPrologues(partition);
       auto map_output = map_part(partition);
       if (combine_func) {
         static_cast<Output<typename ObjT2::KeyT, MsgT>*>(map_output.get())->SetCombineFunc(combine_func);
@@ -119,8 +186,20 @@ struct MapPartJoin : public PlanBase {
   int staleness = 0;
   std::string checkpoint_path;
   int checkpoint_interval = 0;
+  int num_delta_checkpoints = 0;
+  int num_log_versions = 0;
   int combine_timeout = -1;
   std::string description_;
+
+  bool map_only = false;
+  struct PrologueState {
+    std::vector<PlanBase::PartFuncT> prologues;
+    std::mutex mu;
+    // part_id -> the partition the prologues ran on
+    std::map<int, std::weak_ptr<AbstractPartition>> done;
+  };
+  // shared so that the plan is still copyable
+  std::shared_ptr<PrologueState> prologue_state = std::make_shared<PrologueState>();
 };
 
 }  // namespace xyz
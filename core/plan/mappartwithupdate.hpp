@@ -66,9 +66,20 @@ struct MapPartWithJoin : public PlanBase {
     num_iter = iter;
     return this;
   }
-  MapPartWithJoin<C1, C2, C3, ObjT1, ObjT2, ObjT3, MsgT>* SetCheckpointInterval(int cp, std::string path = "/tmp/tmp") {
+  // num_deltas: # delta checkpoints (only the changed objects) after each
+  // full checkpoint, see IndexedSeqPartition
+  MapPartWithJoin<C1, C2, C3, ObjT1, ObjT2, ObjT3, MsgT>* SetCheckpointInterval(int cp, std::string path = "/tmp/tmp",
+          int num_deltas = 0) {
     checkpoint_interval = cp;
     checkpoint_path = path;
+    num_delta_checkpoints = num_deltas;
+    return this;
+  }
+  // keep the join messages of the last num_versions versions, a failure
+  // then only reloads and replays the lost partitions, it should cover the
+  // checkpoint interval (plus the staleness)
+  MapPartWithJoin<C1, C2, C3, ObjT1, ObjT2, ObjT3, MsgT>* SetMessageLog(int num_versions) {
+    num_log_versions = num_versions;
     return this;
   }
   MapPartWithJoin<C1, C2, C3, ObjT1, ObjT2, ObjT3, MsgT>* SetCombine(
@@ -89,6 +100,8 @@ struct MapPartWithJoin : public PlanBase {
             map_collection->Id(), update_collection->Id(), combine_timeout, num_iter, 
             staleness, checkpoint_interval, checkpoint_path, 
             description_, with_collection->Id());
+    w.GetMapJoinSpec()->num_delta_checkpoints = num_delta_checkpoints;
+    w.GetMapJoinSpec()->num_log_versions = num_log_versions;
     w.name = name;
     return w;
   }
@@ -141,6 +154,8 @@ struct MapPartWithJoin : public PlanBase {
   int staleness = 0;
   std::string checkpoint_path;
   int checkpoint_interval = 0;
+  int num_delta_checkpoints = 0;
+  int num_log_versions = 0;
   int combine_timeout = -1;
   std::string description_;
 };
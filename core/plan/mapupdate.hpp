@@ -54,6 +54,13 @@ struct MapJoin : public MapPartJoin<C1, C2, ObjT1, ObjT2, MsgT>{
     SetMapPart();
     MapPartJoin<C1, C2, ObjT1, ObjT2, MsgT>::Register(function_store);
   }
+  virtual PlanBase::PartFuncT GetMapOnlyFunc() override {
+    if (!this->map_only) {
+      return nullptr;
+    }
+    SetMapPart();
+    return MapPartJoin<C1, C2, ObjT1, ObjT2, MsgT>::GetMapOnlyFunc();
+  }
 
   MapFuncT map;  // a -> b
 };
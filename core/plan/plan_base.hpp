@@ -2,15 +2,25 @@
 
 #include "core/plan/spec_wrapper.hpp"
 #include "core/plan/abstract_function_store.hpp"
+#include "core/partition/abstract_partition.hpp"
 
 namespace xyz {
 
 struct PlanBase {
+  using PartFuncT = std::function<void(std::shared_ptr<AbstractPartition>)>;
+
   PlanBase(int _plan_id) : plan_id(_plan_id) {}
   virtual ~PlanBase() = default;
   virtual SpecWrapper GetSpec() = 0;
   virtual void Register(std::shared_ptr<AbstractFunctionStore> function_store) = 0;
 
+  // plan fusion, see core/plan/plan_fusion.hpp
+  // the effect of a map-only plan on a partition, nullptr if not map-only
+  virtual PartFuncT GetMapOnlyFunc() { return nullptr; }
+  // run f on each partition of map_collection_id before mapping it,
+  // return false if not supported
+  virtual bool AddPrologue(int map_collection_id, PartFuncT f) { return false; }
+
   int plan_id;
   std::string name = "";
 };
@@ -0,0 +1,100 @@
+#include "core/plan/plan_fusion.hpp"
+
+#include <algorithm>
+#include <set>
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+namespace {
+
+bool IsMapJoin(const SpecWrapper& spec) {
+  return spec.type == SpecWrapper::Type::kMapJoin
+      || spec.type == SpecWrapper::Type::kMapWithJoin;
+}
+
+}  // namespace
+
+Dag FusePlans(const Dag& dag, std::vector<PlanBase*>* plans) {
+  const int n = plans->size();
+  std::vector<SpecWrapper> specs;
+  std::vector<std::set<int>> reads(n), writes(n);
+  for (int i = 0; i < n; ++ i) {
+    CHECK_EQ((*plans)[i]->plan_id, i);
+    specs.push_back((*plans)[i]->GetSpec());
+    auto rw = dag.GetReadWrite(i);
+    reads[i].insert(rw.first.begin(), rw.first.end());
+    writes[i].insert(rw.second.begin(), rw.second.end());
+  }
+
+  std::vector<bool> removed(n, false);
+  for (int i = 0; i + 1 < n; ++ i) {
+    auto f = (*plans)[i]->GetMapOnlyFunc();
+    if (!f) {
+      continue;
+    }
+    CHECK(IsMapJoin(specs[i]));
+    auto* spec = specs[i].GetMapJoinSpec();
+    const int j = i + 1;
+    if (!(*plans)[j]->AddPrologue(spec->map_collection_id, f)) {
+      continue;
+    }
+    LOG(INFO) << "[FusePlans] fuse plan " << i << " " << specs[i].name
+      << " into plan " << j << " " << specs[j].name;
+    removed[i] = true;
+    (*plans)[j]->name = (*plans)[i]->name + " -> " + (*plans)[j]->name;
+    reads[j].insert(reads[i].begin(), reads[i].end());
+    writes[j].insert(writes[i].begin(), writes[i].end());
+
+    // the dummy update collection
+    const int tmp_c = spec->update_collection_id;
+    if (tmp_c == spec->map_collection_id) {
+      continue;
+    }
+    reads[j].erase(tmp_c);
+    writes[j].erase(tmp_c);
+    int placeholder = -1;
+    bool used_elsewhere = false;
+    for (int k = 0; k < n; ++ k) {
+      if (k == i || (reads[k].count(tmp_c) == 0 && writes[k].count(tmp_c) == 0)) {
+        continue;
+      }
+      if (placeholder == -1 && k < i && specs[k].type == SpecWrapper::Type::kDistribute) {
+        placeholder = k;
+      } else {
+        used_elsewhere = true;
+      }
+    }
+    if (placeholder != -1 && !used_elsewhere) {
+      LOG(INFO) << "[FusePlans] drop plan " << placeholder << " " << specs[placeholder].name;
+      removed[placeholder] = true;
+    }
+  }
+
+  if (std::find(removed.begin(), removed.end(), true) == removed.end()) {
+    return dag;
+  }
+
+  // renumber and rebuild the dag
+  std::vector<PlanBase*> fused;
+  Dag fused_dag;
+  for (int i = 0; i < n; ++ i) {
+    if (removed[i]) {
+      continue;
+    }
+    auto* p = (*plans)[i];
+    p->plan_id = fused.size();
+    fused.push_back(p);
+    fused_dag.AddDagNode(p->plan_id,
+            std::vector<int>(reads[i].begin(), reads[i].end()),
+            std::vector<int>(writes[i].begin(), writes[i].end()),
+            dag.GetPartitionwiseRead(i));
+  }
+  LOG(INFO) << "[FusePlans] " << n << " plans fused into " << fused.size();
+  *plans = std::move(fused);
+  return fused_dag;
+}
+
+}  // namespace xyz
+
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include "core/plan/plan_base.hpp"
+#include "core/plan/dag.hpp"
+
+namespace xyz {
+
+/*
+ * Fuse the map-only plans (e.g. Context::foreach, Context::sort_each_partition)
+ * into the next plan if it maps the same collection, so that the map-only
+ * plan runs on each partition as a prologue of the next plan instead of
+ * taking a full round of plan setup and finish.
+ *
+ * The placeholder plan creating the temporary update collection of a fused
+ * plan is dropped as well if no other plan touches that collection.
+ *
+ * The remaining plans are renumbered (plan_id) in order and the dag is
+ * rebuilt for them, the fused plan also reads and writes what the map-only
+ * plans read and wrote. dag is returned as is if nothing is fused.
+ */
+Dag FusePlans(const Dag& dag, std::vector<PlanBase*>* plans);
+
+}  // namespace xyz
+
@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include "glog/logging.h"
+
+#include "core/plan/plan_fusion.hpp"
+#include "core/plan/mapupdate.hpp"
+#include "core/plan/distribute.hpp"
+#include "core/partition/seq_partition.hpp"
+
+namespace xyz {
+namespace {
+
+class TestPlanFusion: public testing::Test {};
+
+struct ObjT {
+  using KeyT = int;
+  using ValT = int;
+  ObjT() = default;
+  ObjT(KeyT key) : a(key), b(0) {}
+  KeyT Key() const { return a; }
+  int a;
+  int b;
+};
+
+// c0 -> foreach(c0) -> mapupdate(c0, c2)
+TEST_F(TestPlanFusion, FuseForeach) {
+  Collection<ObjT> c0{0};
+  Collection<ObjT> c1{1};  // tmp collection of foreach
+  Collection<ObjT> c2{2};
+  c1.SetMapper(std::make_shared<HashKeyToPartMapper<ObjT::KeyT>>(1));
+  c2.SetMapper(std::make_shared<HashKeyToPartMapper<ObjT::KeyT>>(1));
+  Distribute<ObjT> p0(0, c0.Id(), 1);
+  Distribute<ObjT> p1(1, c1.Id(), 1);
+  MapJoin<Collection<ObjT>, Collection<ObjT>, ObjT, ObjT, int> p2(2, &c0, &c1);
+  MapJoin<Collection<ObjT>, Collection<ObjT>, ObjT, ObjT, int> p3(3, &c0, &c2);
+  int visited = 0;
+  p2.map = [&visited](const ObjT& obj, Output<int, int>* o) {
+    visited += 1;
+    o->Add(0, 0);
+  };
+  p2.update = [](ObjT*, int) {};
+  p2.SetMapOnly();
+  p3.map = [](const ObjT& obj, Output<int, int>* o) {
+    o->Add(obj.Key(), 1);
+  };
+  p3.update = [](ObjT* obj, int m) { obj->b += m; };
+  Dag dag;
+  dag.AddDagNode(0, {}, {0});
+  dag.AddDagNode(1, {}, {1});
+  dag.AddDagNode(2, {0}, {1}, 0);
+  dag.AddDagNode(3, {0}, {2}, 0);
+
+  std::vector<PlanBase*> plans{&p0, &p1, &p2, &p3};
+  Dag fused_dag = FusePlans(dag, &plans);
+  // the foreach and its placeholder are gone
+  ASSERT_EQ(plans.size(), 2);
+  EXPECT_EQ(plans[0], &p0);
+  EXPECT_EQ(plans[1], &p3);
+  EXPECT_EQ(p0.plan_id, 0);
+  EXPECT_EQ(p3.plan_id, 1);
+  auto rw = fused_dag.GetReadWrite(1);
+  EXPECT_EQ(rw.first, std::vector<int>({0}));
+  EXPECT_EQ(rw.second, std::vector<int>({2}));
+
+  auto partition = std::make_shared<SeqPartition<ObjT>>();
+  partition->id = 0;
+  partition->Add(ObjT{10});
+  partition->Add(ObjT{20});
+  // the prologue runs once per partition
+  p3.RunPrologues(partition);
+  EXPECT_EQ(visited, 2);
+  p3.RunPrologues(partition);
+  EXPECT_EQ(visited, 2);
+  // a reloaded partition runs it again
+  auto reloaded = std::make_shared<SeqPartition<ObjT>>();
+  reloaded->id = 0;
+  reloaded->Add(ObjT{10});
+  p3.RunPrologues(reloaded);
+  EXPECT_EQ(visited, 3);
+  // no speculation on the fused plan
+  EXPECT_TRUE(p3.GetSpec().GetMapJoinSpec()->has_prologue);
+}
+
+TEST_F(TestPlanFusion, NotFused) {
+  Collection<ObjT> c0{0};
+  Collection<ObjT> c1{1};
+  Collection<ObjT> c2{2};
+  Distribute<ObjT> p0(0, c0.Id(), 1);
+  // maps another collection
+  MapJoin<Collection<ObjT>, Collection<ObjT>, ObjT, ObjT, int> p1(1, &c0, &c1);
+  MapJoin<Collection<ObjT>, Collection<ObjT>, ObjT, ObjT, int> p2(2, &c1, &c2);
+  p1.map = [](const ObjT& obj, Output<int, int>* o) {};
+  p1.update = [](ObjT*, int) {};
+  p1.SetMapOnly();
+  Dag dag;
+  dag.AddDagNode(0, {}, {0});
+  dag.AddDagNode(1, {0}, {1}, 0);
+  dag.AddDagNode(2, {1}, {2}, 1);
+
+  std::vector<PlanBase*> plans{&p0, &p1, &p2};
+  FusePlans(dag, &plans);
+  EXPECT_EQ(plans.size(), 3);
+  EXPECT_EQ(p2.plan_id, 2);
+  EXPECT_FALSE(p2.GetSpec().GetMapJoinSpec()->has_prologue);
+}
+
+}  // namespace
+}  // namespace xyz
+
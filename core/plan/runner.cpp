@@ -1,5 +1,7 @@
 #include "core/plan/runner.hpp"
 
+#include "core/plan/plan_fusion.hpp"
+
 DEFINE_string(scheduler, "", "The host of scheduler");
 DEFINE_int32(scheduler_port, -1, "The port of scheduler");
 DEFINE_string(hdfs_namenode, "", "The namenode of hdfs");
@@ -8,6 +10,21 @@ DEFINE_int32(node_id, -1, "node id");
 DEFINE_int32(num_local_threads, 20, "# local_threads");
 DEFINE_int32(num_update_threads, 20, "# update_threads");
 DEFINE_int32(num_combine_threads, 20, "# combine_threads");
+DEFINE_int32(num_io_threads, 1, "# zmq io threads");
+DEFINE_int32(num_sender_threads, 1, "# sender threads");
+DEFINE_int32(num_recv_sockets, 1, "# receive sockets, must be the same as the scheduler's");
+DEFINE_bool(separate_bulk_sockets, false, "send bulk traffic through its own sockets");
+DEFINE_bool(use_ipc, false, "use ipc:// for the nodes on the same host, must be the same as the scheduler's");
+DEFINE_int32(num_credits_per_node, 0, "# outstanding join messages to each node before maps ahead of the min version are held back, <=0 to disable");
+DEFINE_int32(report_batch_size, 16, "# finished parts reported to the scheduler in one message, <=1 to disable batching");
+DEFINE_int32(report_flush_ms, 5, "flush interval (ms) of the partial report batches");
+DEFINE_int32(num_fetch_servers, 2, "# threads serving the fetch-object requests of the immutable collections, 0 to serve them in the controller, must be the same on all workers");
+DEFINE_int32(num_controller_shards, 1, "# controller threads the joins and fetches are sharded over by part_id, 1 to run them in the controller thread");
+DEFINE_int32(num_checkpoint_threads, 4, "# threads writing and reading the checkpoint chunks, 0 to do it in the calling thread");
+DEFINE_int32(checkpoint_chunk_mb, 16, "size (MB) of a checkpoint chunk");
+DEFINE_bool(compress_checkpoint, true, "encode the checkpoint chunks (zero runs)");
+DEFINE_string(checkpoint_local_dir, "", "write the checkpoints to this local directory first and copy them to hdfs in the background, empty to write to hdfs directly");
+DEFINE_bool(fuse_plans, false, "fuse the map-only plans (foreach, sort_each_partition) into the next plan, a foreach may run again on a re-executed partition, must be the same on all workers");
 
 namespace xyz {
 
@@ -25,6 +42,11 @@ void Runner::Run() {
 
   auto plans = Context::get_allplans();
   auto collections = Context::get_allcollections();
+  Dag dag = Context::get_dag();
+  if (FLAGS_fuse_plans) {
+    // renumbers the plans, so before GetSpec and Register
+    dag = FusePlans(dag, &plans);
+  }
   // TODO: replace ProgramContext with a DAG structure.
   ProgramContext program;
   // for (auto* c : collections) {
@@ -33,7 +55,8 @@ void Runner::Run() {
   for (auto* p : plans) {
     program.specs.push_back(p->GetSpec());
   }
-  program.dag = Context::get_dag();
+  program.dag = dag;
+  program.copartitions = Context::get_copartitions();
 
   Engine::Config config;
   config.scheduler = FLAGS_scheduler;
@@ -43,6 +66,20 @@ void Runner::Run() {
   config.num_combine_threads = FLAGS_num_combine_threads;
   config.namenode = FLAGS_hdfs_namenode;
   config.port = FLAGS_hdfs_port;
+  config.num_io_threads = FLAGS_num_io_threads;
+  config.num_sender_threads = FLAGS_num_sender_threads;
+  config.num_recv_sockets = FLAGS_num_recv_sockets;
+  config.separate_bulk_sockets = FLAGS_separate_bulk_sockets;
+  config.use_ipc = FLAGS_use_ipc;
+  config.num_credits_per_node = FLAGS_num_credits_per_node;
+  config.report_batch_size = FLAGS_report_batch_size;
+  config.report_flush_ms = FLAGS_report_flush_ms;
+  config.num_fetch_servers = FLAGS_num_fetch_servers;
+  config.num_controller_shards = FLAGS_num_controller_shards;
+  config.num_checkpoint_threads = FLAGS_num_checkpoint_threads;
+  config.checkpoint_chunk_bytes = static_cast<size_t>(FLAGS_checkpoint_chunk_mb) << 20;
+  config.compress_checkpoint = FLAGS_compress_checkpoint;
+  config.checkpoint_local_dir = FLAGS_checkpoint_local_dir;
 
   Engine engine;
   // initialize the components and actors,
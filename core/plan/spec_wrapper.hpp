@@ -25,6 +25,14 @@ struct MapJoinSpec : public Spec {
   int checkpoint_interval = 0;
   std::string checkpoint_path;
   std::string description;
+  // # delta checkpoints between two full checkpoints
+  int num_delta_checkpoints = 0;
+  // # versions of the join messages kept by the senders, to replay them to
+  // the partitions lost in a failure, 0 to disable
+  int num_log_versions = 0;
+  // the map runs fused prologues (see plan_fusion.hpp) which write the
+  // map partitions, so they are not read-only during the plan
+  bool has_prologue = false;
   MapJoinSpec() = default;
   MapJoinSpec(int mid, int jid, int comb, int iter, int s, 
           int cp, std::string path, std::string d)
@@ -34,12 +42,14 @@ struct MapJoinSpec : public Spec {
   virtual void ToBin(SArrayBinStream& bin) override {
     bin << map_collection_id << update_collection_id 
         << combine_timeout << num_iter << staleness << checkpoint_interval
-        << checkpoint_path << description;
+        << checkpoint_path << description << num_delta_checkpoints << num_log_versions
+        << has_prologue;
   }
   virtual void FromBin(SArrayBinStream& bin) override {
     bin >> map_collection_id >> update_collection_id
         >> combine_timeout >> num_iter >> staleness >> checkpoint_interval
-        >> checkpoint_path >> description;
+        >> checkpoint_path >> description >> num_delta_checkpoints >> num_log_versions
+        >> has_prologue;
   }
   virtual ReadWriteVector GetReadWrite() const {
     if (map_collection_id == update_collection_id) {
@@ -57,6 +67,9 @@ struct MapJoinSpec : public Spec {
     ss << ", staleness: " << staleness;
     ss << ", checkpoint_interval: " << checkpoint_interval;
     ss << ", checkpoint_path: " << checkpoint_path;
+    ss << ", num_delta_checkpoints: " << num_delta_checkpoints;
+    ss << ", num_log_versions: " << num_log_versions;
+    ss << ", has_prologue: " << has_prologue;
     ss << ", description: " << description;
     return ss.str();
   }
@@ -12,6 +12,8 @@ namespace xyz {
 struct ProgramContext {
   std::vector<SpecWrapper> specs;
   Dag dag;
+  // collection_id -> the collection it is placed with, see Context::copartition
+  std::map<int, int> copartitions;
 
   std::string DebugString() const {
     std::stringstream ss;
@@ -22,16 +24,19 @@ struct ProgramContext {
       ss << spec.DebugString() << "\n";
     }
     ss << dag.DebugString();
+    for (auto& kv : copartitions) {
+      ss << "\ncollection " << kv.first << " copartitioned with " << kv.second;
+    }
     return ss.str();
   }
 
   friend SArrayBinStream& operator<<(xyz::SArrayBinStream& stream, const ProgramContext& c) {
-    stream << c.specs << c.dag;
+    stream << c.specs << c.dag << c.copartitions;
   	return stream;
   }
   
   friend SArrayBinStream& operator>>(xyz::SArrayBinStream& stream, ProgramContext& c) {
-    stream >> c.specs >> c.dag;
+    stream >> c.specs >> c.dag >> c.copartitions;
   	return stream;
   }
 };
@@ -21,6 +21,12 @@ int GetControllerActorQid(int nid) {
   return nid * kMagic + 3;
 }
 
+// the fetch servers take the queues left
+const int kMaxFetchServers = 4;
+int GetFetchServerQid(int nid, int shard) {
+  return nid * kMagic + 4 + shard;
+}
+
 }
 }  // namespace xyz
 
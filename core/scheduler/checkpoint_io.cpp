@@ -0,0 +1,236 @@
+#include "core/scheduler/checkpoint_io.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <thread>
+
+#include "glog/logging.h"
+#include "io/local_reader.hpp"
+#include "io/local_writer.hpp"
+
+namespace xyz {
+
+void CheckpointIO::SetLocalTier(std::string local_dir, 
+        std::shared_ptr<Executor> replicate_executor) {
+  CHECK(!local_dir.empty());
+  CHECK_NOTNULL(replicate_executor);
+  local_dir_ = local_dir;
+  replicate_executor_ = replicate_executor;
+  local_io_wrapper_ = std::make_shared<IOWrapper>(
+      []() { return std::make_shared<LocalReader>(); },
+      []() { return std::make_shared<LocalWriter>(); });
+}
+
+// hdfs://namenode/a/b -> <local_dir>/namenode/a/b, /a/b -> <local_dir>/a/b
+std::string CheckpointIO::GetLocalUrl(std::string url) const {
+  auto pos = url.find("://");
+  if (pos != std::string::npos) {
+    url = url.substr(pos + 3);
+  }
+  if (url.empty() || url[0] != '/') {
+    url = "/" + url;
+  }
+  return local_dir_ + url;
+}
+
+void CheckpointIO::Write(std::string url, const SArrayBinStream& bin,
+        std::function<void()> persisted) {
+  if (!HasLocalTier()) {
+    WriteTo(io_wrapper_, url, bin);
+    if (persisted) {
+      persisted();
+    }
+    return;
+  }
+  const std::string local_url = GetLocalUrl(url);
+  const int num_chunks = WriteTo(local_io_wrapper_, local_url, bin);
+  // copy the encoded files as they are
+  auto local_io_wrapper = local_io_wrapper_;
+  auto io_wrapper = io_wrapper_;
+  auto num_replicating = num_replicating_;
+  num_replicating->fetch_add(1);
+  replicate_executor_->Add([local_io_wrapper, io_wrapper, num_replicating,
+          local_url, url, num_chunks, persisted]() {
+    for (int i = 0; i <= num_chunks; ++ i) {
+      // the manifest is the last one
+      std::string from = i == num_chunks ? local_url : GetChunkUrl(local_url, i);
+      std::string to = i == num_chunks ? url : GetChunkUrl(url, i);
+      std::string content = ReadFile(local_io_wrapper, from);
+      auto writer = io_wrapper->GetWriter();
+      int rc = writer->Write(to, content.data(), content.size());
+      CHECK_EQ(rc, 0);
+    }
+    if (persisted) {
+      persisted();
+    }
+    num_replicating->fetch_sub(1);
+  });
+}
+
+void CheckpointIO::WaitReplicated() const {
+  int num_logged = 0;
+  while (int num = GetNumReplicating()) {
+    if (num != num_logged) {
+      LOG(INFO) << "[CheckpointIO] waiting for " << num << " checkpoints to be replicated";
+      num_logged = num;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+SArrayBinStream CheckpointIO::Read(std::string url, bool prefer_local) {
+  if (prefer_local && HasLocalTier() && LocalReader::Exists(GetLocalUrl(url))) {
+    VLOG(1) << "[CheckpointIO] read the local copy of " << url;
+    return ReadFrom(local_io_wrapper_, GetLocalUrl(url));
+  }
+  return ReadFrom(io_wrapper_, url);
+}
+
+// manifest: <codec> <raw size> <chunk size> <encoded size of each chunk>
+int CheckpointIO::WriteTo(std::shared_ptr<IOWrapper> io_wrapper, std::string url,
+        const SArrayBinStream& bin) {
+  const char* data = bin.GetPtr();
+  const size_t size = bin.Size();
+  const int num_chunks = (size + chunk_size_ - 1) / chunk_size_;
+  std::vector<size_t> encoded_sizes(num_chunks);
+  std::vector<std::function<void()>> tasks;
+  for (int i = 0; i < num_chunks; ++ i) {
+    tasks.push_back([this, io_wrapper, url, data, size, i, &encoded_sizes]() {
+      const size_t begin = i * chunk_size_;
+      const size_t len = std::min(chunk_size_, size - begin);
+      std::string encoded = Encode(data + begin, len, codec_);
+      encoded_sizes[i] = encoded.size();
+      auto writer = io_wrapper->GetWriter();
+      int rc = writer->Write(GetChunkUrl(url, i), encoded.data(), encoded.size());
+      CHECK_EQ(rc, 0);
+    });
+  }
+  RunAll(tasks);
+
+  SArrayBinStream manifest;
+  manifest << codec_ << size << chunk_size_ << encoded_sizes;
+  auto writer = io_wrapper->GetWriter();
+  int rc = writer->Write(url, manifest.GetPtr(), manifest.Size());
+  CHECK_EQ(rc, 0);
+  return num_chunks;
+}
+
+SArrayBinStream CheckpointIO::ReadFrom(std::shared_ptr<IOWrapper> io_wrapper, std::string url) {
+  std::string manifest_str = ReadFile(io_wrapper, url);
+  SArrayBinStream manifest;
+  manifest.CopyFrom(manifest_str.data(), manifest_str.size());
+  CheckpointCodec codec;
+  size_t size, chunk_size;
+  std::vector<size_t> encoded_sizes;
+  manifest >> codec >> size >> chunk_size >> encoded_sizes;
+
+  SArrayBinStream bin;
+  if (size == 0) {
+    return bin;
+  }
+  bin.Resize(size);
+  char* out = bin.GetBegin();
+  std::vector<std::function<void()>> tasks;
+  for (int i = 0; i < encoded_sizes.size(); ++ i) {
+    tasks.push_back([io_wrapper, url, codec, size, chunk_size, out, i, &encoded_sizes]() {
+      std::string encoded = ReadFile(io_wrapper, GetChunkUrl(url, i));
+      CHECK_EQ(encoded.size(), encoded_sizes[i]) << GetChunkUrl(url, i);
+      const size_t begin = i * chunk_size;
+      const size_t len = std::min(chunk_size, size - begin);
+      Decode(encoded.data(), encoded.size(), codec, out + begin, len);
+    });
+  }
+  RunAll(tasks);
+  return bin;
+}
+
+std::string CheckpointIO::ReadFile(std::shared_ptr<IOWrapper> io_wrapper, std::string url) {
+  auto reader = io_wrapper->GetReader();
+  reader->Init(url);
+  size_t file_size = reader->GetFileSize();
+  std::string buffer(file_size, 0);
+  if (file_size != 0) {
+    reader->Read(&buffer[0], file_size);
+  }
+  return buffer;
+}
+
+void CheckpointIO::RunAll(const std::vector<std::function<void()>>& tasks) {
+  if (!executor_) {
+    for (auto& task : tasks) {
+      task();
+    }
+    return;
+  }
+  std::vector<std::future<void>> futures;
+  for (auto& task : tasks) {
+    futures.push_back(executor_->Add(task));
+  }
+  for (auto& f : futures) {
+    f.get();
+  }
+}
+
+// kZeroRun: a control byte c and then
+//   c < 0x80: c + 1 literal bytes
+//   c >= 0x80: (c & 0x7f) + 1 zero bytes, nothing follows
+// a single zero byte stays in the literals
+std::string CheckpointIO::Encode(const char* data, size_t size, CheckpointCodec codec) {
+  if (codec == CheckpointCodec::kNone) {
+    return std::string(data, size);
+  }
+  CHECK(codec == CheckpointCodec::kZeroRun);
+  std::string out;
+  out.reserve(size / 2 + 16);
+  size_t i = 0;
+  while (i < size) {
+    size_t run = 0;
+    while (i + run < size && data[i + run] == 0 && run < 128) {
+      ++ run;
+    }
+    if (run >= 2) {
+      out.push_back(static_cast<char>(0x80 | (run - 1)));
+      i += run;
+      continue;
+    }
+    size_t len = 0;
+    while (i + len < size && len < 128
+            && !(data[i + len] == 0 && i + len + 1 < size && data[i + len + 1] == 0)) {
+      ++ len;
+    }
+    out.push_back(static_cast<char>(len - 1));
+    out.append(data + i, len);
+    i += len;
+  }
+  return out;
+}
+
+void CheckpointIO::Decode(const char* data, size_t size, CheckpointCodec codec,
+        char* out, size_t raw_size) {
+  if (codec == CheckpointCodec::kNone) {
+    CHECK_EQ(size, raw_size);
+    memcpy(out, data, size);
+    return;
+  }
+  CHECK(codec == CheckpointCodec::kZeroRun)
+    << "unknown codec: " << static_cast<int>(codec);
+  size_t i = 0, pos = 0;
+  while (i < size) {
+    const unsigned char c = data[i ++];
+    const size_t len = (c & 0x7f) + 1;
+    CHECK_LE(pos + len, raw_size);
+    if (c & 0x80) {
+      memset(out + pos, 0, len);
+    } else {
+      CHECK_LE(i + len, size);
+      memcpy(out + pos, data + i, len);
+      i += len;
+    }
+    pos += len;
+  }
+  CHECK_EQ(pos, raw_size);
+}
+
+}  // namespace xyz
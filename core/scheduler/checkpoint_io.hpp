@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/sarray_binstream.hpp"
+#include "core/executor/executor.hpp"
+#include "io/io_wrapper.hpp"
+
+namespace xyz {
+
+enum class CheckpointCodec : char {
+  kNone,
+  // the runs of zero bytes are encoded in one byte, the serialized
+  // ints and sizes have many of them
+  kZeroRun
+};
+
+static const char* CheckpointCodecName[] = {
+  "kNone",
+  "kZeroRun"
+};
+
+/*
+ * Write and read the checkpoint of a partition in chunks.
+ *
+ * The serialized partition is cut into chunks of chunk_size bytes, each
+ * chunk is encoded and written to <url>.chunk-<i> in the executor, in
+ * parallel, once it is encoded. The manifest (codec, sizes) is written to
+ * <url> after all the chunks, so a checkpoint with a manifest is complete.
+ * Read reads and decodes the chunks in parallel into one buffer.
+ *
+ * Without an executor the chunks are written and read in the caller.
+ * The executor should not be the one the caller is running in, the caller
+ * waits for the chunks.
+ *
+ * With a local tier (SetLocalTier), Write writes to the local directory
+ * and returns, the files are then copied to the shared store (io_wrapper)
+ * in the background, the manifest last. Read(url, true) reads the local
+ * copy if there is one, e.g. on a surviving node rolled back by the
+ * recovery. The caller knows whether the local copy is the latest one
+ * (the scheduler tracks the node writing each checkpoint), a url may be
+ * written again on another node.
+ */
+class CheckpointIO {
+ public:
+  CheckpointIO(std::shared_ptr<IOWrapper> io_wrapper,
+          std::shared_ptr<Executor> executor = nullptr,
+          size_t chunk_size = 16 << 20,
+          CheckpointCodec codec = CheckpointCodec::kZeroRun)
+      : io_wrapper_(io_wrapper), executor_(executor),
+        chunk_size_(chunk_size), codec_(codec) {
+    CHECK_GT(chunk_size_, 0);
+  }
+
+  // local_dir: e.g. /tmp/xyz-cp, the urls are mapped under it
+  void SetLocalTier(std::string local_dir, std::shared_ptr<Executor> replicate_executor);
+  bool HasLocalTier() const { return !local_dir_.empty(); }
+  std::string GetLocalUrl(std::string url) const;
+  // the replications whose persisted callbacks are not done yet
+  int GetNumReplicating() const { return num_replicating_->load(); }
+  // block until all the replications and their callbacks are done
+  void WaitReplicated() const;
+
+  // persisted: called once the checkpoint is in the shared store,
+  // in the replicate_executor if there is a local tier
+  void Write(std::string url, const SArrayBinStream& bin,
+          std::function<void()> persisted = nullptr);
+  SArrayBinStream Read(std::string url, bool prefer_local = false);
+
+  static std::string Encode(const char* data, size_t size, CheckpointCodec codec);
+  // out must have raw_size bytes
+  static void Decode(const char* data, size_t size, CheckpointCodec codec,
+          char* out, size_t raw_size);
+  static std::string GetChunkUrl(std::string url, int chunk_id) {
+    return url + ".chunk-" + std::to_string(chunk_id);
+  }
+
+ private:
+  // return the # chunks
+  int WriteTo(std::shared_ptr<IOWrapper> io_wrapper, std::string url,
+          const SArrayBinStream& bin);
+  SArrayBinStream ReadFrom(std::shared_ptr<IOWrapper> io_wrapper, std::string url);
+  static std::string ReadFile(std::shared_ptr<IOWrapper> io_wrapper, std::string url);
+  // run the tasks in the executor and wait for them
+  void RunAll(const std::vector<std::function<void()>>& tasks);
+
+  std::shared_ptr<IOWrapper> io_wrapper_;
+  std::shared_ptr<Executor> executor_;
+  size_t chunk_size_;
+  CheckpointCodec codec_;
+
+  // the local tier
+  std::string local_dir_;
+  std::shared_ptr<IOWrapper> local_io_wrapper_;
+  std::shared_ptr<Executor> replicate_executor_;
+  // shared with the replicate tasks
+  std::shared_ptr<std::atomic<int>> num_replicating_ = std::make_shared<std::atomic<int>>(0);
+};
+
+}  // namespace xyz
@@ -0,0 +1,155 @@
+#include "gtest/gtest.h"
+#include "glog/logging.h"
+
+#include "core/scheduler/checkpoint_io.hpp"
+#include "io/local_reader.hpp"
+#include "io/local_writer.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
+
+namespace xyz {
+namespace {
+
+class TestCheckpointIO : public testing::Test {};
+
+// url -> content
+struct MemStore {
+  std::map<std::string, std::string> files;
+  std::mutex mu;
+};
+
+struct MemWriter : public AbstractWriter {
+  MemWriter(MemStore* store) : store_(store) {}
+  virtual int Write(std::string dest_url, const void *buffer, size_t len) override {
+    std::lock_guard<std::mutex> lk(store_->mu);
+    store_->files[dest_url] = std::string(static_cast<const char*>(buffer), len);
+    return 0;
+  }
+  MemStore* store_;
+};
+
+struct MemReader : public AbstractReader {
+  MemReader(MemStore* store) : store_(store) {}
+  virtual void Init(std::string url) override {
+    std::lock_guard<std::mutex> lk(store_->mu);
+    CHECK(store_->files.find(url) != store_->files.end());
+    content_ = store_->files[url];
+  }
+  virtual size_t GetFileSize() override {
+    return content_.size();
+  }
+  virtual int Read(void *buffer, size_t len) override {
+    memcpy(buffer, content_.data(), len);
+    return 0;
+  }
+  MemStore* store_;
+  std::string content_;
+};
+
+std::shared_ptr<IOWrapper> GetMemIOWrapper(MemStore* store) {
+  return std::make_shared<IOWrapper>(
+      [store]() { return std::make_shared<MemReader>(store); },
+      [store]() { return std::make_shared<MemWriter>(store); });
+}
+
+TEST_F(TestCheckpointIO, Codec) {
+  std::string raw("ab\0c\0\0\0d", 8);
+  raw += std::string(300, 0);
+  raw += std::string(200, 'x');
+  for (auto codec : {CheckpointCodec::kNone, CheckpointCodec::kZeroRun}) {
+    std::string encoded = CheckpointIO::Encode(raw.data(), raw.size(), codec);
+    std::string decoded(raw.size(), 1);
+    CheckpointIO::Decode(encoded.data(), encoded.size(), codec, &decoded[0], decoded.size());
+    EXPECT_EQ(decoded, raw) << CheckpointCodecName[static_cast<int>(codec)];
+  }
+  std::string encoded = CheckpointIO::Encode(raw.data(), raw.size(), CheckpointCodec::kZeroRun);
+  EXPECT_LT(encoded.size(), raw.size() / 2);
+}
+
+TEST_F(TestCheckpointIO, WriteRead) {
+  MemStore store;
+  auto executor = std::make_shared<Executor>(2);
+  CheckpointIO io(GetMemIOWrapper(&store), executor, 64);
+  SArrayBinStream bin;
+  std::vector<int> v;
+  for (int i = 0; i < 100; ++ i) {
+    v.push_back(i);
+  }
+  bin << v << std::string("hello");
+  io.Write("/tmp/cp-1/c0-p0", bin);
+  // the manifest and the chunks
+  const int num_chunks = (bin.Size() + 63) / 64;
+  EXPECT_EQ(store.files.size(), num_chunks + 1);
+  EXPECT_EQ(store.files.count(CheckpointIO::GetChunkUrl("/tmp/cp-1/c0-p0", num_chunks - 1)), 1);
+
+  // no executor
+  CheckpointIO io2(GetMemIOWrapper(&store));
+  SArrayBinStream read_bin = io2.Read("/tmp/cp-1/c0-p0");
+  ASSERT_EQ(read_bin.Size(), bin.Size());
+  std::vector<int> read_v;
+  std::string s;
+  read_bin >> read_v >> s;
+  EXPECT_EQ(read_v, v);
+  EXPECT_EQ(s, "hello");
+}
+
+TEST_F(TestCheckpointIO, Empty) {
+  MemStore store;
+  CheckpointIO io(GetMemIOWrapper(&store));
+  io.Write("/tmp/empty", SArrayBinStream());
+  EXPECT_EQ(io.Read("/tmp/empty").Size(), 0);
+}
+
+// a local directory stands in for the shared store
+TEST_F(TestCheckpointIO, LocalTier) {
+  char shared_tmpl[] = "/tmp/xyz-shared-XXXXXX";
+  char local_tmpl[] = "/tmp/xyz-local-XXXXXX";
+  const std::string shared_dir = mkdtemp(shared_tmpl);
+  const std::string local_dir = mkdtemp(local_tmpl);
+  auto io_wrapper = std::make_shared<IOWrapper>(
+      []() { return std::make_shared<LocalReader>(); },
+      []() { return std::make_shared<LocalWriter>(); });
+  CheckpointIO io(io_wrapper, nullptr, 16);
+  io.SetLocalTier(local_dir, std::make_shared<Executor>(1));
+  const std::string url = shared_dir + "/cp-1/c0-p0";
+  EXPECT_EQ(io.GetLocalUrl(url), local_dir + url);
+  EXPECT_EQ(io.GetLocalUrl("hdfs://a/b"), local_dir + "/a/b");
+
+  SArrayBinStream bin;
+  bin << std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8};
+  std::promise<void> persisted;
+  io.Write(url, bin, [&persisted]() { persisted.set_value(); });
+  // the local copy is there once Write returns
+  EXPECT_TRUE(LocalReader::Exists(io.GetLocalUrl(url)));
+  persisted.get_future().wait();
+  io.WaitReplicated();
+  EXPECT_EQ(io.GetNumReplicating(), 0);
+  EXPECT_TRUE(LocalReader::Exists(url));
+  EXPECT_TRUE(LocalReader::Exists(CheckpointIO::GetChunkUrl(url, 0)));
+
+  // the shared copy is broken, only the local copy can be read
+  LocalWriter().Write(CheckpointIO::GetChunkUrl(url, 0), "x", 1);
+  std::vector<int> v;
+  SArrayBinStream local_bin = io.Read(url, true);
+  local_bin >> v;
+  EXPECT_EQ(v, std::vector<int>({1, 2, 3, 4, 5, 6, 7, 8}));
+
+  // no local copy, read the shared one
+  SArrayBinStream bin2;
+  bin2 << std::string("shared");
+  CheckpointIO(io_wrapper).Write(shared_dir + "/cp-2/c0-p0", bin2);
+  std::string s;
+  SArrayBinStream shared_bin = io.Read(shared_dir + "/cp-2/c0-p0", true);
+  shared_bin >> s;
+  EXPECT_EQ(s, "shared");
+
+  std::string cmd = "rm -rf " + shared_dir + " " + local_dir;
+  EXPECT_EQ(system(cmd.c_str()), 0);
+}
+
+}  // namespace
+}  // namespace xyz
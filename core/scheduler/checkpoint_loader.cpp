@@ -33,10 +33,28 @@ void CheckpointLoader::LoadCheckpointPartial(int cid, std::string url,
   }
 }
 
+// The worker loads the url and then replays the deltas after it.
+// It reads its local copy of the ones it wrote (local_urls), if any.
 void CheckpointLoader::SendLoadCommand(int cid, int part_id, int node_id, std::string url) {
   SArrayBinStream bin;
   std::string dest_url = GetCheckpointUrl(url, cid, part_id);
-  bin << cid << part_id << dest_url;  // collection_id, partition_id, url
+  std::vector<std::string> delta_urls;
+  std::vector<std::string> local_urls;
+  if (collection_status_) {
+    for (auto& delta : collection_status_->GetDeltaCPs(cid, url)) {
+      delta_urls.push_back(GetCheckpointUrl(delta, cid, part_id));
+    }
+    if (collection_status_->GetCPWriter(dest_url) == node_id) {
+      local_urls.push_back(dest_url);
+    }
+    for (auto& delta_url : delta_urls) {
+      if (collection_status_->GetCPWriter(delta_url) == node_id) {
+        local_urls.push_back(delta_url);
+      }
+    }
+  }
+  // collection_id, partition_id, url, delta urls, local urls
+  bin << cid << part_id << dest_url << delta_urls << local_urls;
   SendTo(elem_, node_id, ScheduleFlag::kLoadCheckpoint, bin);
 }
 
@@ -3,14 +3,17 @@
 #include <functional>
 
 #include "core/scheduler/scheduler_elem.hpp"
+#include "core/scheduler/collection_status.hpp"
 
 namespace xyz {
 
 
 class CheckpointLoader {
  public:
-  CheckpointLoader(std::shared_ptr<SchedulerElem> elem)
-      : elem_(elem) {}
+  // collection_status: for the delta checkpoints on top of the url loaded
+  CheckpointLoader(std::shared_ptr<SchedulerElem> elem,
+          std::shared_ptr<CollectionStatus> collection_status = nullptr)
+      : elem_(elem), collection_status_(collection_status) {}
 
   // non thread-safe
   void LoadCheckpoint(int cid, std::string url,
@@ -25,6 +28,7 @@ class CheckpointLoader {
   void SendLoadCommand(int cid, int part_id, int node_id, std::string url);
  private:
   std::shared_ptr<SchedulerElem> elem_;
+  std::shared_ptr<CollectionStatus> collection_status_;
 
   std::map<int, int> loadcheckpoint_reply_count_map_;
   std::map<int, int> expected_loadcheckpoint_reply_count_map_;
@@ -17,6 +17,7 @@ void CheckpointManager::Checkpoint(SpecWrapper s) {
     SArrayBinStream bin;
     std::string dest_url = GetCheckpointUrl(url, cid, i);
     bin << cid << i << dest_url;  // collection_id, partition_id, url
+    collection_status_->SetCPWriter(dest_url, node_id);
     SendTo(elem_, node_id, ScheduleFlag::kCheckpoint, bin);
   }
   collection_status_->AddCP(cid, url);  // add checkpoint here
@@ -13,6 +13,32 @@ std::string CollectionStatus::GetLastCP(int collection_id) const {
 
 void CollectionStatus::AddCP(int collection_id, std::string url) {
   last_cp_[collection_id] = url;
+  delta_cps_.erase(collection_id);
+}
+
+void CollectionStatus::AddDeltaCP(int collection_id, std::string url) {
+  CHECK(last_cp_.find(collection_id) != last_cp_.end()) 
+    << "no full checkpoint before the delta: " << url;
+  delta_cps_[collection_id].push_back(url);
+}
+
+std::vector<std::string> CollectionStatus::GetDeltaCPs(int collection_id, 
+        std::string base_url) const {
+  auto it = last_cp_.find(collection_id);
+  auto delta_it = delta_cps_.find(collection_id);
+  if (it == last_cp_.end() || it->second != base_url || delta_it == delta_cps_.end()) {
+    return {};
+  }
+  return delta_it->second;
+}
+
+void CollectionStatus::SetCPWriter(std::string part_url, int node_id) {
+  cp_writers_[part_url] = node_id;
+}
+
+int CollectionStatus::GetCPWriter(std::string part_url) const {
+  auto it = cp_writers_.find(part_url);
+  return it == cp_writers_.end() ? -1 : it->second;
 }
 
 void CollectionStatus::AddPlan(int id, const ReadWriteVector& p) {
@@ -78,7 +104,12 @@ std::string CollectionStatus::DebugString() const {
   ss << "\n";
   ss << "last_cp: ";
   for (auto& kv: last_cp_) {
-    ss << kv.first << ": " << kv.second << ", ";
+    ss << kv.first << ": " << kv.second;
+    auto it = delta_cps_.find(kv.first);
+    if (it != delta_cps_.end()) {
+      ss << " (+" << it->second.size() << " deltas)";
+    }
+    ss << ", ";
   }
   return ss.str();
 }
@@ -115,5 +146,25 @@ std::vector<std::pair<int, std::string>> CollectionStatus::GetWritesAndCP() cons
   return ret;
 }
 
+void CollectionStatus::SetCollectionUsers(std::map<int, std::set<int>> users) {
+  collection_users_ = std::move(users);
+}
+
+std::vector<int> CollectionStatus::ReleaseUser(int plan_id) {
+  std::vector<int> ret;
+  for (auto it = collection_users_.begin(); it != collection_users_.end(); ) {
+    auto& users = it->second;
+    if (users.erase(plan_id) && users.empty()) {
+      CHECK(read_ids_.find(it->first) == read_ids_.end());
+      CHECK(write_ids_.find(it->first) == write_ids_.end());
+      ret.push_back(it->first);
+      it = collection_users_.erase(it);
+    } else {
+      ++ it;
+    }
+  }
+  return ret;
+}
+
 } // namespace xyz
 
@@ -17,6 +17,14 @@ class CollectionStatus {
   std::string GetLastCP(int collection_id) const;
 
   void AddCP(int collection_id, std::string url);
+  // a delta checkpoint on top of the last one (full or delta)
+  void AddDeltaCP(int collection_id, std::string url);
+  // the deltas to replay after loading base_url, in order
+  std::vector<std::string> GetDeltaCPs(int collection_id, std::string base_url) const;
+  // the node writing the checkpoint of a partition (see GetCheckpointUrl),
+  // it may have a local copy, -1 if unknown
+  void SetCPWriter(std::string part_url, int node_id);
+  int GetCPWriter(std::string part_url) const;
   void AddPlan(int id, const ReadWriteVector& p);
   void FinishPlan(int plan_id);
   std::vector<int> GetCurrentPlans();
@@ -26,13 +34,26 @@ class CollectionStatus {
 
   std::vector<std::pair<int, std::string>> GetReadsAndCP() const;
   std::vector<std::pair<int, std::string>> GetWritesAndCP() const;
+
+  // garbage collection of the dead collections
+  // collection_id -> plans reading or writing it (from the dag)
+  void SetCollectionUsers(std::map<int, std::set<int>> users);
+  // the plan is finished for good, return the collections no plan uses anymore
+  std::vector<int> ReleaseUser(int plan_id);
  private:
   std::map<int, ReadWriteVector> cur_plans_;
   std::map<int, std::chrono::system_clock::time_point> plan_time_;
   std::map<int, int> read_ids_;
   std::map<int, int> write_ids_;
 
+  // the last full checkpoint and the deltas after it
   std::map<int, std::string> last_cp_;
+  std::map<int, std::vector<std::string>> delta_cps_;
+  // part url -> node_id
+  std::map<std::string, int> cp_writers_;
+
+  // collection_id -> plans not finished
+  std::map<int, std::set<int>> collection_users_;
 };
 
 } // namespace xyz
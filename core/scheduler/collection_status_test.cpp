@@ -0,0 +1,52 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/scheduler/collection_status.hpp"
+
+namespace xyz {
+namespace {
+
+class TestCollectionStatus : public testing::Test {};
+
+TEST_F(TestCollectionStatus, ReleaseUser) {
+  CollectionStatus status;
+  // plan 0 writes 0, plan 1 reads 0 and writes 1, plan 2 reads 1
+  status.SetCollectionUsers({{0, {0, 1}}, {1, {1, 2}}});
+  status.AddPlan(0, {{}, {0}});
+  status.FinishPlan(0);
+  EXPECT_TRUE(status.ReleaseUser(0).empty());
+  status.AddPlan(1, {{0}, {1}});
+  status.FinishPlan(1);
+  EXPECT_EQ(status.ReleaseUser(1), std::vector<int>({0}));
+  status.AddPlan(2, {{1}, {}});
+  status.FinishPlan(2);
+  EXPECT_EQ(status.ReleaseUser(2), std::vector<int>({1}));
+}
+
+TEST_F(TestCollectionStatus, DeltaCP) {
+  CollectionStatus status;
+  status.AddCP(0, "/tmp/cp-1");
+  status.AddDeltaCP(0, "/tmp/cp-2");
+  status.AddDeltaCP(0, "/tmp/cp-3");
+  EXPECT_EQ(status.GetLastCP(0), "/tmp/cp-1");
+  EXPECT_EQ(status.GetDeltaCPs(0, "/tmp/cp-1"), 
+          std::vector<std::string>({"/tmp/cp-2", "/tmp/cp-3"}));
+  // not the last full checkpoint
+  EXPECT_TRUE(status.GetDeltaCPs(0, "/tmp/cp-0").empty());
+  // compacted
+  status.AddCP(0, "/tmp/cp-4");
+  EXPECT_TRUE(status.GetDeltaCPs(0, "/tmp/cp-4").empty());
+}
+
+TEST_F(TestCollectionStatus, CPWriter) {
+  CollectionStatus status;
+  EXPECT_EQ(status.GetCPWriter("/tmp/cp-1/c0-p0"), -1);
+  status.SetCPWriter("/tmp/cp-1/c0-p0", 2);
+  EXPECT_EQ(status.GetCPWriter("/tmp/cp-1/c0-p0"), 2);
+  // written again by the recovery
+  status.SetCPWriter("/tmp/cp-1/c0-p0", 3);
+  EXPECT_EQ(status.GetCPWriter("/tmp/cp-1/c0-p0"), 3);
+}
+
+} // namespace
+} // namespace xyz
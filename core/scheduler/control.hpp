@@ -24,6 +24,7 @@ enum class ScheduleFlag : char {
   kUpdateCollection,
   kUpdateCollectionReply,
   kRecovery,
+  kReleaseCollection,
 };
 
 static const char *ScheduleFlagName[] = {
@@ -45,7 +46,7 @@ static const char *ScheduleFlagName[] = {
   "kUpdateCollection",
   "kUpdateCollectionReply",
   "kRecovery",
-  "kFinishRecovery"
+  "kReleaseCollection",
 };
 
 enum class FetcherFlag : char{
@@ -65,16 +66,20 @@ struct WorkerInfo {
  */
 struct ControllerMsg {
   enum class Flag : char {
-    kSetup, kMap, kJoin, kFinish, kFinishMigrate, kFinishCP
+    kSetup, kMap, kJoin, kFinish, kFinishMigrate, kFinishCP, kCheckSpeculation
   };
   static constexpr const char* FlagName[] = {
-    "kSetup", "kMap", "kJoin", "kFinish", "kFinishMigrate", "kFinishCP"
+    "kSetup", "kMap", "kJoin", "kFinish", "kFinishMigrate", "kFinishCP", "kCheckSpeculation"
   };
   Flag flag;
   int version;
   int node_id;
   int plan_id;
   int part_id;
+  size_t part_bytes = 0;  // estimated bytes of the partition, 0 if unknown
+  // kFinish only, the join message bytes the node sent to itself and to the others
+  size_t local_shuffle_bytes = 0;
+  size_t remote_shuffle_bytes = 0;
   std::string DebugString() const {
     std::stringstream ss;
     ss << "flag: " << FlagName[static_cast<int>(flag)];
@@ -82,6 +87,7 @@ struct ControllerMsg {
     ss << ", node_id: " << node_id;
     ss << ", plan_id: " << plan_id;
     ss << ", part_id: " << part_id;
+    ss << ", part_bytes: " << part_bytes;
     return ss.str();
   }
 };
@@ -100,6 +106,10 @@ enum class ControllerFlag : char {
   kTerminatePlan,
   kFinishLoadWith,
   kReassignMap,  // no partition lost during machine failure, reassign the map partitions
+  kGrantCredit,  // flow control, the receiver of join messages grants credits back
+  kReadyParts,  // pipelining, the map parts whose upstream plans have finished them
+  kFlushReports,  // send the batched progress reports of all plans, from the controller itself
+  kRecoverParts,  // update partitions lost, the new owners restart them and the senders replay the message log
 };
 
 static const char *ControllerFlagName[] = {
@@ -116,6 +126,10 @@ static const char *ControllerFlagName[] = {
   "kTerminatePlan",
   "kFinishLoadWith",
   "kReassignMap",
+  "kGrantCredit",
+  "kReadyParts",
+  "kFlushReports",
+  "kRecoverParts",
 };
 
 struct FetchMeta {
@@ -142,15 +156,15 @@ struct MigrateMeta {
     kStartMigrate,
     kFlushAll,
     kDest,
-    kStartMigrateMapOnly,
-    kReceiveMapOnly,
+    kStartSpeculativeMap,
+    kReceiveSpeculativeMap,
   };
   static constexpr const char* FlagName[] = {
     "kStartMigrate", 
     "kFlushAll",
     "kDest",
-    "kStartMigrateMapOnly",
-    "kReceiveMapOnly"
+    "kStartSpeculativeMap",
+    "kReceiveSpeculativeMap"
   };
   MigrateFlag flag;
   int plan_id;
@@ -182,6 +196,12 @@ std::string GetCheckpointUrl(std::string url,
   return dest_url;
 }
 
+// the checkpoints are numbered from 1, the first one is full and
+// then every num_deltas + 1
+bool IsDeltaCheckpoint(int checkpoint_iter, int num_deltas) {
+  return (checkpoint_iter - 1) % (num_deltas + 1) != 0;
+}
+
 const int kRecoverMagic = 10000;
 bool IsRecoverPlan(int id) {
   return id >= kRecoverMagic ? true:false;
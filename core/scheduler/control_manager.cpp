@@ -3,24 +3,35 @@
 #include "core/queue_node_map.hpp"
 
 #include "base/color.hpp"
+#include "base/magic.hpp"
 
 #include <algorithm>
-//#define WITH_LB
-//#define WITH_LB_JOIN
-
-//core/scheduler/control_manager.cpp; core/worker/plan_controller.cpp
-#define BGCP false
+#include <deque>
 
 namespace xyz {
 
 void ControlManager::Control(SArrayBinStream bin) {
-  ControllerMsg ctrl;
-  bin >> ctrl;
+  // the progress reports from a node may come in one batch
+  while (bin.Size()) {
+    ControllerMsg ctrl;
+    bin >> ctrl;
+    Control(ctrl);
+  }
+}
+
+void ControlManager::Control(ControllerMsg ctrl) {
   VLOG(2) << "[ControlManager] ctrl: " << ctrl.DebugString();
   if (ctrl.flag == ControllerMsg::Flag::kSetup) {
     is_setup_[ctrl.plan_id].insert(ctrl.node_id);
     if (is_setup_[ctrl.plan_id].size() == elem_->nodes.size()) {
       LOG(INFO) << "[ControlManager] Setup all nodes, startPlan: " << ctrl.plan_id;
+      if (gated_plans_.find(ctrl.plan_id) != gated_plans_.end()) {
+        // gate the maps before kStart
+        SArrayBinStream ready_bin;
+        ready_bin << pending_ready_parts_[ctrl.plan_id];
+        pending_ready_parts_.erase(ctrl.plan_id);
+        SendToAllControllers(elem_, ControllerFlag::kReadyParts, ctrl.plan_id, ready_bin);
+      }
       SArrayBinStream reply_bin;
       SendToAllControllers(elem_, ControllerFlag::kStart, ctrl.plan_id, reply_bin);
       version_time_[ctrl.plan_id].push_back(std::chrono::system_clock::now());  
@@ -29,82 +40,17 @@ void ControlManager::Control(SArrayBinStream bin) {
     }
   } else if (ctrl.flag == ControllerMsg::Flag::kMap) {
     HandleUpdateMapVersion(ctrl);
-#ifdef WITH_LB
-    // TODO: add logic here
-    // for pr
-    // for pr() in test_lb.cpp specifically
-    //if (specs_[ctrl.plan_id].id == 3 && 
-    //    ctrl.node_id == 1 &&
-    //    map_node_versions_[ctrl.plan_id][ctrl.node_id].first == 1 && 
-    //    migrate_control_) {  
-    //  Migrate(ctrl.plan_id, 2, 1, 1);
-    //  migrate_control_ = false;
-    //}
-    // // for mr
-    // if (migrate_control_) {
-    //   MigrateMapOnly(ctrl.plan_id, 5, 1, 4);
-    //   migrate_control_ = false;
-    // }
-    // TrySpeculativeMap(ctrl.plan_id);
-  
-    if (migrate_control && specs_[ctrl.plan_id].name == "pagerank main logic") {
-      std::vector<std::tuple<int, int, int>> meta;
-      for (int i = 0; i < 100; i = i + 5) {
-        int to_id = (i / 5) % 4 + 2;
-        int from_id = 1;
-        meta.push_back(std::make_tuple(from_id, to_id, i));
-      }
-      PreBatchMigrate(ctrl.plan_id, meta);
-      migrate_control = false;
-    }
-
-    //if (specs_[ctrl.plan_id].name == "pagerank main logic") { 
-    //  TryMigrate(ctrl.plan_id);
-    //}
-#endif
+    TryLoadBalance(ctrl.plan_id);
   } else if (ctrl.flag == ControllerMsg::Flag::kJoin) {
     HandleUpdateJoinVersion(ctrl);
-    //// for kmeans
-    /*
-    if (migrate_control && versions_[ctrl.plan_id] == 3 && ctrl.plan_id == 7) {
-      migrate_control = false;
-      const int from_id = 1;
-      const int node_num = 10;
-      const int num_parts = 1200;
-      const int parts_per_node = num_parts/node_num;
-      for (int i = 0; i < parts_per_node; ++ i) {
-        int part_id = 0 + i*node_num;
-        int to_id = from_id + 1 + i %(node_num-1);
-        MigrateMapOnly(ctrl.plan_id, from_id, to_id, part_id);
-        LOG(INFO) << "migrating from_id, to_id, part_id: " << from_id << " " << to_id << " " << part_id;
-      }
+    if (ctrl.part_bytes > 0) {
+      part_bytes_[ctrl.plan_id][ctrl.part_id] = ctrl.part_bytes;
     }
-    */
-    //// for kmeans
-#ifdef WITH_LB_JOIN
-    if (migrate_control && 
-        specs_[ctrl.plan_id].name == "pagerank main logic" &&
-        versions_[ctrl.plan_id] == 6) {//migrate at version x
-      std::vector<std::tuple<int, int, int>> meta;
-      // NEED TO BE MANUALLY SET
-      int from_id = 1;
-      int node_num = 20;
-      int num_parts = 100;
-	  CHECK_EQ(num_parts % node_num, 0);
-
-	  int nodesPerPart = num_parts / node_num;
-	  for (int i = 0; i < nodesPerPart; i++) {
-		int part_id = 0 + i*node_num;
-		int to_id = (from_id + 1 + i%(node_num-1)) % node_num;
-		//LOG(INFO) << "to id: " << to_id << " part id: " << part_id << std::endl;
-        meta.push_back(std::make_tuple(from_id, to_id, part_id));
-	  }
-      PreBatchMigrate(ctrl.plan_id, meta);
-      migrate_control = false;
-    }
-#endif
+    TryLoadBalance(ctrl.plan_id);
   } else if (ctrl.flag == ControllerMsg::Flag::kFinish) {
     is_finished_[ctrl.plan_id].insert(ctrl.node_id);
+    shuffle_bytes_[ctrl.plan_id].first += ctrl.local_shuffle_bytes;
+    shuffle_bytes_[ctrl.plan_id].second += ctrl.remote_shuffle_bytes;
     // LOG(INFO) << "finish: " << is_finished_[ctrl.plan_id].size() << ", " << elem_->nodes.size();
     if (is_finished_[ctrl.plan_id].size() == elem_->nodes.size()) {
       if (versions_[ctrl.plan_id] == expected_versions_[ctrl.plan_id]) {
@@ -117,171 +63,175 @@ void ControlManager::Control(SArrayBinStream bin) {
         std::chrono::duration<double> duration = version_time_[ctrl.plan_id].at(i+1) - version_time_[ctrl.plan_id].at(i);
         LOG(INFO) << "[ControlManager] version interval for plan: " << ctrl.plan_id << ": " << "(" << i << "->" << i+1 << ") " << duration.count();
       }
+      const auto shuffle_bytes = GetShuffleBytes(ctrl.plan_id);
+      const size_t total = shuffle_bytes.first + shuffle_bytes.second;
+      LOG(INFO) << "[ControlManager] plan " << ctrl.plan_id
+        << ", local shuffle bytes: " << shuffle_bytes.first
+        << ", remote shuffle bytes: " << shuffle_bytes.second
+        << ", local ratio: " << (total == 0 ? 0 : static_cast<double>(shuffle_bytes.first) / total);
 
       CHECK(callbacks_.find(ctrl.plan_id) != callbacks_.end());
       callbacks_[ctrl.plan_id]();
       callbacks_.erase(ctrl.plan_id);
+      gated_plans_.erase(ctrl.plan_id);
+      ready_parts_.erase(ctrl.plan_id);
+      num_running_plans_ -= 1;
     }
   } else if (ctrl.flag == ControllerMsg::Flag::kFinishMigrate) {
     migrate_time[ctrl.part_id].second = std::chrono::system_clock::now();
     std::chrono::duration<double> duration = migrate_time[ctrl.part_id].second - migrate_time[ctrl.part_id].first;
     LOG(INFO) << "[ControlManager] migrate part " << ctrl.part_id << " done, migrate time: "
       << duration.count();
+  } else if (ctrl.flag == ControllerMsg::Flag::kCheckSpeculation) {
+    for (auto& kv : callbacks_) {
+      TrySpeculativeMap(kv.first);
+    }
   } else if (ctrl.flag == ControllerMsg::Flag::kFinishCP) {
-	ReceiveFinishCP(ctrl.plan_id, ctrl.part_id, ctrl.version);
+    ReceiveFinishCP(ctrl.plan_id, ctrl.part_id, ctrl.version, ctrl.node_id);
   } else {
     CHECK(false) << ctrl.DebugString();
   }
 }
 
-void ControlManager::ReceiveFinishCP(int plan_id, int part_id, int version) {
-  if (versions_[plan_id] == expected_versions_[plan_id]) {
-	return;
-  }
-  cp_count_[plan_id][version].insert(part_id);
+// The partitions are written in the background (from a snapshot), the
+// checkpoint is added once all the partitions of the version are written.
+// The last one may arrive after the plan finishes.
+// The checkpoints are added in order since a delta needs the ones before.
+void ControlManager::ReceiveFinishCP(int plan_id, int part_id, int version, int node_id) {
   auto* mapupdate_spec = specs_[plan_id].GetMapJoinSpec();
   int collection_id = mapupdate_spec->update_collection_id;
-  if (cp_count_[plan_id][version].size() == elem_->collection_map->Get(mapupdate_spec->map_collection_id).num_partition) {
-    if (mapupdate_spec->checkpoint_interval != 0) {
-      int cp_iter = versions_[plan_id] / mapupdate_spec->checkpoint_interval;
-      CHECK(mapupdate_spec->checkpoint_path.size());
-      std::string checkpoint_path = mapupdate_spec->checkpoint_path;
-      checkpoint_path = checkpoint_path + "/cp-" + std::to_string(cp_iter);
-      collection_status_->AddCP(mapupdate_spec->update_collection_id, checkpoint_path);
-      LOG(INFO) << RED("[ControlManager::UpdateVersion] BGCP: checkpoint added for collection: "
-              + std::to_string(mapupdate_spec->update_collection_id) + ", path: " + checkpoint_path);
+  CHECK_NE(mapupdate_spec->checkpoint_interval, 0);
+  // the node may have a local copy
+  std::string cp_url = mapupdate_spec->checkpoint_path + "/cp-" 
+      + std::to_string(version / mapupdate_spec->checkpoint_interval);
+  collection_status_->SetCPWriter(GetCheckpointUrl(cp_url, collection_id, part_id), node_id);
+  if (version / mapupdate_spec->checkpoint_interval < next_cp_iters_[plan_id]) {
+    // written again by a part restarted in RecoverParts, added already
+    return;
+  }
+  cp_count_[plan_id][version].insert(part_id);
+  if (cp_count_[plan_id][version].size() != elem_->collection_map->Get(collection_id).num_partition) {
+    return;
+  }
+  cp_count_[plan_id].erase(version);
+  CHECK(mapupdate_spec->checkpoint_path.size());
+  finished_cps_[plan_id].insert(version / mapupdate_spec->checkpoint_interval);
+  auto& next_cp_iter = next_cp_iters_[plan_id];
+  if (next_cp_iter == 0) {
+    next_cp_iter = 1;
+  }
+  while (finished_cps_[plan_id].erase(next_cp_iter)) {
+    std::string checkpoint_path = mapupdate_spec->checkpoint_path;
+    checkpoint_path = checkpoint_path + "/cp-" + std::to_string(next_cp_iter);
+    if (IsDeltaCheckpoint(next_cp_iter, mapupdate_spec->num_delta_checkpoints)) {
+      collection_status_->AddDeltaCP(collection_id, checkpoint_path);
+    } else {
+      collection_status_->AddCP(collection_id, checkpoint_path);
     }
+    LOG(INFO) << RED("[ControlManager::ReceiveFinishCP] checkpoint added for collection: "
+            + std::to_string(collection_id) + ", path: " + checkpoint_path);
+    next_cp_iter += 1;
   }
 }
 
-void ControlManager::TryMigrate(int plan_id){
-  auto* mapupdate_spec = static_cast<MapJoinSpec*>(specs_[plan_id].spec.get());
-  if (mapupdate_spec->map_collection_id == mapupdate_spec->update_collection_id) {
-    int max_version = versions_[plan_id] + mapupdate_spec->staleness + 1;
-    std::map<int, std::vector<int>> nodes; // version, node ids
-    for (auto node : map_node_versions_[plan_id]) {
-      nodes[node.second.first].push_back(node.first);
-    }
-    std::vector<int> fast_nodes = nodes[max_version];
-    std::vector<int> slow_nodes;
-    for (int i = versions_[plan_id]; i < max_version; i++) {
-      for (auto node : nodes[i]) {
-        slow_nodes.push_back(node);
-      }
-      break; //only migrate for the min version
-    }
-    auto& collection_view = elem_->collection_map->Get(mapupdate_spec->map_collection_id);
-   
-    //TODO: better schedule migration
-    std::vector<std::tuple<int, int, int>> meta;
-    auto iter1 = fast_nodes.begin();
-    auto iter2 = slow_nodes.begin();
-    while (iter1 != fast_nodes.end() && iter2 != slow_nodes.end()) {
-      std::vector<int> part_ids = collection_view.mapper.GetNodeParts(*iter2);
-      std::map<int, std::vector<int>> version; // version, part_ids
-      for (int part_id : part_ids) {
-        version[map_part_versions_[plan_id][part_id].first].push_back(part_id);
-      }
-      for (int i = versions_[plan_id]; i < max_version; i++) {
-        if (!version[i].empty()) {
-          int part_id = version[i].at(0);
-          if (std::find(parts_migrated[part_id].begin(), parts_migrated[part_id].end(), map_part_versions_[plan_id][part_id].first)
-              != parts_migrated[part_id].end()) continue;
-          LOG(INFO)<<"[ControlManager Migrate] plan "<<plan_id<<" version "<<versions_[plan_id]
-            <<", from node "<< *iter2 <<" version "<< map_node_versions_[plan_id][*iter2].first
-            <<", to node "<< *iter1 <<" version "<< map_node_versions_[plan_id][*iter1].first
-            <<", migrate part "<< part_id <<" version "<< map_part_versions_[plan_id][part_id].first;
-          
-          meta.push_back(std::make_tuple(*iter2, *iter1, part_id));
-          parts_migrated[part_id].push_back(map_part_versions_[plan_id][part_id].first);
-          iter1++;
-          //return; //only migrate one partition at one time
-        }
-        break; //only migrate for the min version
-      }
-      iter2++;
+// Ask the lb_policy_ which partitions to move once the fast nodes are
+// blocked by the staleness, at most once per min version.
+// The partitions of the update collection are moved by BatchMigrate
+// (together with the map partitions if they are the same collection).
+// For the update collection only, the workers need MIGRATE_JOIN.
+void ControlManager::TryLoadBalance(int plan_id) {
+  if (versions_[plan_id] == expected_versions_[plan_id]) {
+    return;
+  }
+  // the pipelined plans are setup with the current part_to_node
+  if (!gated_plans_.empty()) {
+    return;
+  }
+  if (lb_versions_.find(plan_id) != lb_versions_.end()
+          && lb_versions_[plan_id] >= versions_[plan_id]) {
+    return;
+  }
+  auto* mapupdate_spec = specs_[plan_id].GetMapJoinSpec();
+  const bool map_is_update = (mapupdate_spec->map_collection_id == mapupdate_spec->update_collection_id);
+  // the progress of map if the map partitions move together, otherwise join
+  const auto& tracker = map_is_update ? map_versions_[plan_id] : update_versions_[plan_id];
+  if (tracker.GetMaxNodeVersion() <= versions_[plan_id] + mapupdate_spec->staleness) {
+    return;
+  }
+  lb_versions_[plan_id] = versions_[plan_id];
+
+  LBStats stats;
+  stats.min_version = versions_[plan_id];
+  stats.staleness = mapupdate_spec->staleness;
+  stats.start_time = start_time_;
+  stats.now = std::chrono::system_clock::now();
+  stats.node_versions = tracker.GetNodeVersions();
+  stats.part_to_node = elem_->collection_map->Get(mapupdate_spec->update_collection_id).mapper.Get();
+  stats.part_bytes = part_bytes_[plan_id];
+  const auto& update_versions = update_versions_[plan_id];
+  for (int part_id = 0; part_id < update_versions.GetNumParts(); ++ part_id) {
+    bool migrating = migrate_time.find(part_id) != migrate_time.end()
+        && migrate_time[part_id].first > migrate_time[part_id].second;
+    bool at_min_version = update_versions.GetPartVersion(part_id) == versions_[plan_id]
+        && (!map_is_update || map_versions_[plan_id].GetPartVersion(part_id) == versions_[plan_id]);
+    if (at_min_version && !migrating) {
+      stats.movable_parts.push_back(part_id);
     }
-    PreBatchMigrate(plan_id, meta);
   }
+
+  auto meta = lb_policy_->Decide(stats);
+  if (meta.empty()) {
+    return;
+  }
+  for (auto& submeta : meta) {
+    LOG(INFO) << "[ControlManager::TryLoadBalance] plan " << plan_id << " version " << versions_[plan_id]
+      << ", migrate part " << std::get<2>(submeta) << " from node " << std::get<0>(submeta)
+      << " to node " << std::get<1>(submeta);
+  }
+  PreBatchMigrate(plan_id, meta);
 }
 
 void ControlManager::HandleUpdateMapVersion(ControllerMsg ctrl) {
-  auto& part_versions = map_part_versions_[ctrl.plan_id];
-  auto& node_versions = map_node_versions_[ctrl.plan_id];
-  auto& node_count = map_node_count_[ctrl.plan_id];
-  auto* mapupdate_spec = static_cast<MapJoinSpec*>(specs_[ctrl.plan_id].spec.get());
-  auto& collection_view = elem_->collection_map->Get(mapupdate_spec->map_collection_id);
-  auto& part_to_node_map = collection_view.mapper.Get();
-
-  CHECK_EQ(part_versions[ctrl.part_id].first + 1, ctrl.version) << "version updated by 1 every time";
-  part_versions[ctrl.part_id].first = ctrl.version;
-  part_versions[ctrl.part_id].second = std::chrono::system_clock::now();
-
-  int node_id = part_to_node_map[ctrl.part_id];
-  if (node_versions[node_id].first == ctrl.version - 1) {
-    CHECK_GT(node_count[node_id], 0);
-    node_count[node_id] -= 1;
-    if (node_count[node_id] == 0) {
-      node_versions[node_id].first += 1;
-      node_versions[node_id].second = std::chrono::system_clock::now();
-
-      // LOG(INFO) << DebugVersions(ctrl.plan_id);
-      LOG(INFO) << "[ControlManager::HandleUpdateMapVersion] node: " << node_id << ", map version: " << node_versions[node_id].first;
-      // update node_count to next version
-      node_count[node_id] = 0;
-      for (auto& pv : part_versions) {
-        if (part_to_node_map[pv.first] == node_id && pv.second.first == node_versions[node_id].first) {
-          node_count[node_id] += 1;
-        }
-      }
-    }
+  auto& tracker = map_versions_[ctrl.plan_id];
+  auto now = std::chrono::system_clock::now();
+  // for speculative execution
+  std::chrono::duration<double> duration = now - GetMapStartTime(ctrl.plan_id, 
+          ctrl.version - 1, tracker.GetPartTime(ctrl.part_id));
+  map_durations_[ctrl.plan_id][ctrl.version - 1].push_back(duration.count());
+  if (tracker.Update(ctrl.part_id, ctrl.version, now)) {
+    int node_id = tracker.GetPartNode(ctrl.part_id);
+    // LOG(INFO) << DebugVersions(ctrl.plan_id);
+    LOG(INFO) << "[ControlManager::HandleUpdateMapVersion] node: " << node_id << ", map version: " << tracker.GetNodeVersion(node_id);
   }
 }
 
 void ControlManager::HandleUpdateJoinVersion(ControllerMsg ctrl) {
-  auto& part_versions = update_part_versions_[ctrl.plan_id];
-  auto& node_versions = update_node_versions_[ctrl.plan_id];
-  auto& node_count = update_node_count_[ctrl.plan_id];
+  auto& tracker = update_versions_[ctrl.plan_id];
   auto* mapupdate_spec = static_cast<MapJoinSpec*>(specs_[ctrl.plan_id].spec.get());
-  auto& collection_view = elem_->collection_map->Get(mapupdate_spec->update_collection_id);
-  auto& part_to_node_map = collection_view.mapper.Get();
-
-  CHECK_EQ(part_versions[ctrl.part_id].first + 1, ctrl.version) << "version updated by 1 every time";
-  part_versions[ctrl.part_id].first = ctrl.version;
-  part_versions[ctrl.part_id].second = std::chrono::system_clock::now();
-
-  int node_id = part_to_node_map[ctrl.part_id];
-  if (node_versions[node_id].first == ctrl.version - 1) {
-    CHECK_GT(node_count[node_id], 0);
-    node_count[node_id] -= 1;
-    if (node_count[node_id] == 0) {
-      node_versions[node_id].first += 1;
-      node_versions[node_id].second = std::chrono::system_clock::now();
-
-      // LOG(INFO) << DebugVersions(ctrl.plan_id);
-      LOG(INFO) << "node: " << node_id << ", update version: " << node_versions[node_id].first;
-      // update node_count to next version
-      node_count[node_id] = 0;
-      for (auto& pv : part_versions) {
-        if (part_to_node_map[pv.first] == node_id && pv.second.first == node_versions[node_id].first) {
-          node_count[node_id] += 1;
-        }
-      }
-      // try update version
-      bool update_update_version = true;
-      for (auto& node_version : node_versions) {
-        if (node_count[node_version.first] == 0) {  // no update part there
-          continue;
-        }
-        if (node_version.second.first == versions_[ctrl.plan_id]) {
-          update_update_version = false;
-          break;
-        }
-      }
-      if (update_update_version) {
-        UpdateVersion(ctrl.plan_id);
-      }
+
+  bool node_updated = tracker.Update(ctrl.part_id, ctrl.version, std::chrono::system_clock::now());
+  if (ctrl.version == expected_versions_[ctrl.plan_id] && finish_part_callback_) {
+    finish_part_callback_(mapupdate_spec->update_collection_id, ctrl.part_id);
+  }
+  if (!node_updated) {
+    return;
+  }
+  int node_id = tracker.GetPartNode(ctrl.part_id);
+  // LOG(INFO) << DebugVersions(ctrl.plan_id);
+  LOG(INFO) << "node: " << node_id << ", update version: " << tracker.GetNodeVersion(node_id);
+  // try update version
+  bool update_update_version = true;
+  for (int id : tracker.GetNodeIds()) {
+    if (tracker.GetNodeCount(id) == 0) {  // no update part there
+      continue;
     }
+    if (tracker.GetNodeVersion(id) == versions_[ctrl.plan_id]) {
+      update_update_version = false;
+      break;
+    }
+  }
+  if (update_update_version) {
+    UpdateVersion(ctrl.plan_id);
   }
 }
 
@@ -353,96 +303,20 @@ void ControlManager::BatchMigrate(int plan_id, std::vector<std::tuple<int, int,
     //migrate update 
     part_to_node[part_id] = to_id;
     auto current_time = std::chrono::system_clock::now();
-    CHECK_EQ(update_part_versions_[plan_id][part_id].first, versions_[plan_id]) << "only migrate for the minimum version";
+    auto& update_versions = update_versions_[plan_id];
+    CHECK_EQ(update_versions.GetPartVersion(part_id), versions_[plan_id]) << "only migrate for the minimum version";
     // LOG(INFO) << DebugVersions(plan_id);
-    // update from_id
-    // try to update update_node_versions_ and update_node_count_
-    CHECK_EQ(update_part_versions_[plan_id][part_id].first, update_node_versions_[plan_id][from_id].first);
-    if (update_node_count_[plan_id][from_id] > 1) {
-      update_node_count_[plan_id][from_id] -= 1;
-    } else if (update_node_count_[plan_id][from_id] == 1) {
-      // 1. find a new min version for from_id
-      int new_min = 1000000;
-      for (int i = 0; i < part_to_node.size(); ++ i) {
-        if (part_to_node[i] == from_id) {
-          if (update_part_versions_[plan_id][i].first < new_min) {
-            new_min = update_part_versions_[plan_id][i].first;
-          }
-        }
-      }
-      // 2. calc count
-      int count = 0;
-      for (int i = 0; i < part_to_node.size(); ++ i) {
-        if (part_to_node[i] == from_id) {
-          if (update_part_versions_[plan_id][i].first == new_min) {
-            count += 1;
-          }
-        }
-      }
-      update_node_count_[plan_id][from_id] = count;
-      update_node_versions_[plan_id][from_id].first = new_min;
-      update_node_versions_[plan_id][from_id].second = current_time;
-      LOG(INFO) << "[ControlManager::Migrate] update update_node_versions_ for node: " << from_id << " to " << new_min << ", min_count: " << count;
-    } else {
-      CHECK(false);
-    }
+    CHECK_EQ(update_versions.GetPartVersion(part_id), update_versions.GetNodeVersion(from_id));
+    update_versions.Move(part_id, to_id, current_time);
+    LOG(INFO) << "[ControlManager::Migrate] update version of node " << from_id << ": "
+      << update_versions.GetNodeVersion(from_id) << ", min_count: " << update_versions.GetNodeCount(from_id);
 
     // migrate map if map collection equals update collection
     if (mapupdate_spec->map_collection_id == mapupdate_spec->update_collection_id) {
-      if (map_node_versions_[plan_id][from_id].first == map_part_versions_[plan_id][part_id].first) {
-        // migrating the min version
-        if (map_node_count_[plan_id][from_id] > 1) {
-          map_node_count_[plan_id][from_id] -= 1;
-          LOG(INFO) << "pid, fid, min_count: " << plan_id << ", " << from_id << ", " << map_node_count_[plan_id][from_id];
-        } else {
-          // 1. find a new version
-          int new_min = 1000000;
-          for (int i = 0; i < part_to_node.size(); ++ i) {
-            if (part_to_node[i] == from_id) {
-              if (map_part_versions_[plan_id][i].first < new_min) {
-                new_min = map_part_versions_[plan_id][i].first;
-              }
-            }
-          }
-          // 2. calc count
-          int count = 0;
-          for (int i = 0; i < part_to_node.size(); ++ i) {
-            if (part_to_node[i] == from_id) {
-              if (map_part_versions_[plan_id][i].first == new_min) {
-                count += 1;
-              }
-            }
-          }
-          map_node_count_[plan_id][from_id] = count;
-          map_node_versions_[plan_id][from_id].first = new_min;
-          map_node_versions_[plan_id][from_id].second = current_time;
-          LOG(INFO) << "update map_node_versions_ for node: " << from_id << " to " << new_min << ", min_count: " << count;
-        }
-      } else {
-        // do nothing
-      }
-    }
-
-    // update to_id
-    if (update_part_versions_[plan_id][part_id].first < update_node_versions_[plan_id][to_id].first) {
-      update_node_count_[plan_id][to_id] = 1;
-      update_node_versions_[plan_id][to_id].first = update_part_versions_[plan_id][part_id].first;
-    } else if (update_part_versions_[plan_id][part_id].first == update_node_versions_[plan_id][to_id].first) {
-      update_node_count_[plan_id][to_id] += 1;
-    } else {
-      // do nothing.
-    }
-
-    // for map
-    if (mapupdate_spec->map_collection_id == mapupdate_spec->update_collection_id) {
-      if (map_part_versions_[plan_id][part_id].first < map_node_versions_[plan_id][to_id].first) {
-        map_node_count_[plan_id][to_id] = 1;
-        map_node_versions_[plan_id][to_id].first = map_part_versions_[plan_id][part_id].first;
-      } else if (map_part_versions_[plan_id][part_id].first == map_node_versions_[plan_id][to_id].first) {
-        map_node_count_[plan_id][part_id] += 1;
-      } else {
-        // do nothing.
-      }
+      auto& map_versions = map_versions_[plan_id];
+      map_versions.Move(part_id, to_id, current_time);
+      LOG(INFO) << "[ControlManager::Migrate] map version of node " << from_id << ": "
+        << map_versions.GetNodeVersion(from_id) << ", min_count: " << map_versions.GetNodeCount(from_id);
     }
     // LOG(INFO) << DebugVersions(plan_id);
     MigrateMeta migrate_meta;
@@ -459,18 +333,19 @@ void ControlManager::BatchMigrate(int plan_id, std::vector<std::tuple<int, int,
   }
 }
 
-void ControlManager::MigrateMapOnly(int plan_id, int from_id, int to_id, int part_id) {
+void ControlManager::SpeculativeMap(int plan_id, int from_id, int to_id, int part_id, int version) {
   // some checking
-  CHECK(map_part_versions_[plan_id].find(part_id) != map_part_versions_[plan_id].end());
+  CHECK_LT(part_id, map_versions_[plan_id].GetNumParts());
   auto* mapupdate_spec = static_cast<MapJoinSpec*>(specs_[plan_id].spec.get());
   auto& collection_view = elem_->collection_map->Get(mapupdate_spec->map_collection_id);
   CHECK_NE(mapupdate_spec->map_collection_id, mapupdate_spec->update_collection_id);
   auto& part_to_node = collection_view.mapper.Get();
   CHECK_LT(part_id, part_to_node.size());
   CHECK_EQ(part_to_node[part_id], from_id);
+  CHECK_NE(from_id, to_id);
 
   MigrateMeta migrate_meta;
-  migrate_meta.flag = MigrateMeta::MigrateFlag::kStartMigrateMapOnly;
+  migrate_meta.flag = MigrateMeta::MigrateFlag::kStartSpeculativeMap;
   migrate_meta.plan_id = plan_id;
   migrate_meta.collection_id = mapupdate_spec->map_collection_id;
   migrate_meta.partition_id = part_id;
@@ -478,24 +353,124 @@ void ControlManager::MigrateMapOnly(int plan_id, int from_id, int to_id, int par
   migrate_meta.to_id = to_id;
   migrate_meta.num_nodes = elem_->nodes.size();
   SArrayBinStream bin;
-  bin << migrate_meta << collection_view;
+  bin << migrate_meta << version;
   SendToController(elem_, from_id, ControllerFlag::kMigratePartition, plan_id, bin);
 }
 
-void ControlManager::UpdateVersion(int plan_id) {
+// Periodically ask the scheduler thread to check for stragglers
+// as no message may arrive while waiting for them.
+void ControlManager::SpeculationTicker() {
+  while (!finished_.load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSpeculationCheckInterval));
+    if (num_running_plans_.load() == 0) {
+      continue;
+    }
+    SArrayBinStream bin;
+    ControllerMsg ctrl;
+    ctrl.flag = ControllerMsg::Flag::kCheckSpeculation;
+    ctrl.version = -1;
+    ctrl.node_id = -1;
+    ctrl.plan_id = -1;
+    ctrl.part_id = -1;
+    bin << ctrl;
+    ToScheduler(elem_, ScheduleFlag::kControl, bin);
+  }
+}
+
+// The map of a part can start once the part finishes the last version
+// and the min version allows it.
+ControlManager::Timepoint ControlManager::GetMapStartTime(int plan_id, int version, Timepoint part_time) {
+  int v = version - specs_[plan_id].GetMapJoinSpec()->staleness;
+  if (v > 0 && v < version_time_[plan_id].size()) {
+    return std::max(part_time, version_time_[plan_id][v]);
+  }
+  return part_time;
+}
+
+// Launch a backup copy of the map partitions running much longer than the
+// median of the finished ones of the same version on the idle nodes.
+// Only for immutable map collections and combine modes that send the
+// output of each map partition separately, so that the joiners can drop
+// the duplicates per upstream part.
+void ControlManager::TrySpeculativeMap(int plan_id) {
+  if (speculation_factor_ <= 0 || versions_[plan_id] == expected_versions_[plan_id]
+          || is_setup_[plan_id].size() != elem_->nodes.size()) {
+    return;
+  }
   auto* mapupdate_spec = specs_[plan_id].GetMapJoinSpec();
-  versions_[plan_id] ++;
+  // the fused prologues write the map partitions, they can not be shipped
+  // while the maps run
+  if (mapupdate_spec->map_collection_id == mapupdate_spec->update_collection_id
+          || mapupdate_spec->combine_timeout > kDirectCombine
+          || mapupdate_spec->has_prologue) {
+    return;
+  }
+  const int max_version = versions_[plan_id] + mapupdate_spec->staleness;
+  // the nodes finished all the maps they can run
+  const auto& map_versions = map_versions_[plan_id];
+  std::deque<int> idle_nodes;
+  for (int node_id : map_versions.GetNodeIds()) {
+    if (map_versions.GetNodeVersion(node_id) > max_version) {
+      idle_nodes.push_back(node_id);
+    }
+  }
+  if (idle_nodes.empty()) {
+    return;
+  }
 
-  if (!BGCP && mapupdate_spec->checkpoint_interval != 0 
-          && versions_[plan_id] % mapupdate_spec->checkpoint_interval == 0) {
-    int cp_iter = versions_[plan_id] / mapupdate_spec->checkpoint_interval;
-    CHECK(mapupdate_spec->checkpoint_path.size());
-    std::string checkpoint_path = mapupdate_spec->checkpoint_path;
-    checkpoint_path = checkpoint_path + "/cp-" + std::to_string(cp_iter);
-    collection_status_->AddCP(mapupdate_spec->update_collection_id, checkpoint_path);
-    LOG(INFO) << RED("[ControlManager::UpdateVersion] checkpoint added for collection: "
-            + std::to_string(mapupdate_spec->update_collection_id) + ", path: " + checkpoint_path);
+  const auto& part_to_node = elem_->collection_map->Get(mapupdate_spec->map_collection_id).mapper.Get();
+  const int num_parts = part_to_node.size();
+  auto now = std::chrono::system_clock::now();
+  std::map<int, double> medians;  // version -> median duration
+  for (int part_id = 0; part_id < map_versions.GetNumParts(); ++ part_id) {
+    int version = map_versions.GetPartVersion(part_id);
+    if (version > max_version || idle_nodes.empty()) {
+      continue;
+    }
+    if (speculated_[plan_id].find(part_id) != speculated_[plan_id].end()
+            && speculated_[plan_id][part_id] >= version) {
+      continue;
+    }
+    if (medians.find(version) == medians.end()) {
+      auto durations = map_durations_[plan_id][version];
+      if (durations.size() * 2 < num_parts) {
+        medians[version] = -1;  // not enough finished parts
+      } else {
+        std::nth_element(durations.begin(), durations.begin() + durations.size()/2, durations.end());
+        medians[version] = durations[durations.size()/2];
+      }
+    }
+    if (medians[version] < 0) {
+      continue;
+    }
+    std::chrono::duration<double> elapsed = now - GetMapStartTime(plan_id, version, map_versions.GetPartTime(part_id));
+    if (elapsed.count() < kMinSpeculationSeconds
+            || elapsed.count() < speculation_factor_ * medians[version]) {
+      continue;
+    }
+    int from_id = part_to_node[part_id];
+    // pick an idle node other than the owner
+    for (int i = 0; i < idle_nodes.size(); ++ i) {
+      int to_id = idle_nodes.front();
+      idle_nodes.pop_front();
+      if (to_id != from_id) {
+        LOG(INFO) << "[ControlManager::TrySpeculativeMap] plan " << plan_id << ", part " << part_id
+          << ", version " << version << " runs " << elapsed.count() << "s, median " << medians[version]
+          << "s, speculate from node " << from_id << " to node " << to_id;
+        SpeculativeMap(plan_id, from_id, to_id, part_id, version);
+        speculated_[plan_id][part_id] = version;
+        break;
+      }
+      idle_nodes.push_back(to_id);
+    }
   }
+}
+
+void ControlManager::UpdateVersion(int plan_id) {
+  versions_[plan_id] ++;
+  map_durations_[plan_id].erase(versions_[plan_id] - 1);
+
+  // the checkpoints are added in ReceiveFinishCP
 
   //record time 
   version_time_[plan_id].push_back(std::chrono::system_clock::now());
@@ -531,10 +506,14 @@ void ControlManager::RunPlan(SpecWrapper spec, std::function<void()> f) {
 
   is_setup_[plan_id].clear();
   is_finished_[plan_id].clear();
+  shuffle_bytes_.erase(plan_id);
   versions_[plan_id] = 0;
   expected_versions_[plan_id] = static_cast<MapJoinSpec*>(spec.spec.get())->num_iter;
   CHECK_NE(expected_versions_[plan_id], 0);
   callbacks_[plan_id] = f;
+  num_running_plans_ += 1;
+  speculated_[plan_id].clear();
+  map_durations_[plan_id].clear();
   // LOG(INFO) << "[ControlManager] Start a plan num_iter: " << expected_versions_[plan_id]; 
 
   SArrayBinStream bin;
@@ -542,6 +521,20 @@ void ControlManager::RunPlan(SpecWrapper spec, std::function<void()> f) {
   SendToAllControllers(elem_, ControllerFlag::kSetup, plan_id, bin);
 }
 
+void ControlManager::ReadyParts(int plan_id, std::vector<int> part_ids) {
+  CHECK(callbacks_.find(plan_id) != callbacks_.end()) << "plan " << plan_id << " is not running";
+  gated_plans_.insert(plan_id);
+  ready_parts_[plan_id].insert(part_ids.begin(), part_ids.end());
+  if (is_setup_[plan_id].size() != elem_->nodes.size()) {
+    auto& pending = pending_ready_parts_[plan_id];
+    pending.insert(pending.end(), part_ids.begin(), part_ids.end());
+    return;
+  }
+  SArrayBinStream bin;
+  bin << part_ids;
+  SendToAllControllers(elem_, ControllerFlag::kReadyParts, plan_id, bin);
+}
+
 void ControlManager::ReassignMap(int plan_id, int collection_id) {
   auto* mapupdate_spec = static_cast<MapJoinSpec*>(specs_[plan_id].spec.get());
   CHECK_EQ(collection_id, mapupdate_spec->map_collection_id) << "only support map now (no with)";
@@ -557,27 +550,22 @@ void ControlManager::ReassignMap(int plan_id, int collection_id) {
       cached_part_to_node[i] = new_part_to_node[i];
     }
   }
-  // 2. update map_node_count_ and map_node_versions_
+  // 2. move the parts in map_versions_, the reassigned parts rerun from the min version
   // to_id, part_id, version
   std::vector<std::tuple<int,int,int>> t_p_v;
+  auto& map_versions = map_versions_[plan_id];
+  auto now = std::chrono::system_clock::now();
   for (auto t : reassignments) {
     int part_id = std::get<0>(t);
-    int from_id = std::get<1>(t);
     int to_id = std::get<2>(t);
-    // update the to_id
-    if (map_part_versions_[plan_id][part_id].first != versions_[plan_id]) {
-      // adjust the map_part_versions_ to min versions_
-      map_part_versions_[plan_id][part_id].first = versions_[plan_id];
+    map_versions.Move(part_id, to_id, now);
+    if (map_versions.GetPartVersion(part_id) != versions_[plan_id]) {
+      // adjust the map part version to min versions_
+      map_versions.SetPartVersion(part_id, versions_[plan_id], now);
     }
-    if (map_part_versions_[plan_id][part_id].first < map_node_versions_[plan_id][to_id].first) {
-      map_node_count_[plan_id][to_id] = 1;
-      map_node_versions_[plan_id][to_id].first = map_part_versions_[plan_id][part_id].first;
-    } else if (map_part_versions_[plan_id][part_id].first == map_node_versions_[plan_id][to_id].first) {
-      map_node_count_[plan_id][part_id] += 1;
-    }
-    t_p_v.push_back(std::make_tuple(to_id, part_id, map_part_versions_[plan_id][part_id].first));
+    t_p_v.push_back(std::make_tuple(to_id, part_id, map_versions.GetPartVersion(part_id)));
     LOG(INFO) << "reassigning: <to_id, part_id, version>: " 
-      << to_id << ", " << part_id << ", " << map_part_versions_[plan_id][part_id].first;
+      << to_id << ", " << part_id << ", " << map_versions.GetPartVersion(part_id);
   }
   // 3. send to plan_controller and trigger RunMap
   SArrayBinStream bin;
@@ -585,34 +573,94 @@ void ControlManager::ReassignMap(int plan_id, int collection_id) {
   SendToAllControllers(elem_, ControllerFlag::kReassignMap, plan_id, bin);
 }
 
+int ControlManager::GetLastCPVersion(int plan_id) {
+  auto it = next_cp_iters_.find(plan_id);
+  if (it == next_cp_iters_.end() || it->second <= 1) {
+    return -1;
+  }
+  return (it->second - 1) * specs_[plan_id].GetMapJoinSpec()->checkpoint_interval;
+}
+
+bool ControlManager::CanReplayLog(int plan_id) {
+  auto* mapupdate_spec = specs_[plan_id].GetMapJoinSpec();
+  if (mapupdate_spec->num_log_versions == 0) {
+    return false;
+  }
+  // a pipelined plan is gated until its upstream plans finish all its map
+  // parts, the parts not ready yet are still written by them and cannot be
+  // restarted on their own. Once all are ready the gate does nothing.
+  if (gated_plans_.find(plan_id) != gated_plans_.end()
+          && ready_parts_[plan_id].size() < elem_->collection_map->GetNumParts(mapupdate_spec->map_collection_id)) {
+    return false;
+  }
+  // the fetches of the lost parts are not replayed
+  auto* mapwith_spec = dynamic_cast<MapWithJoinSpec*>(specs_[plan_id].spec.get());
+  if (mapwith_spec != nullptr
+          && mapwith_spec->with_collection_id == mapupdate_spec->update_collection_id) {
+    return false;
+  }
+  // the senders keep the versions from versions_ - num_log_versions
+  const int version = GetLastCPVersion(plan_id);
+  return version != -1 && version >= versions_[plan_id] - mapupdate_spec->num_log_versions;
+}
+
+// The parts on the dead nodes are reloaded on the new owners from the last
+// checkpoint (by the RecoverManager), they restart from its version and the
+// other parts go on. The min version goes back to it, the controllers
+// replay the joins logged since then to the lost update parts.
+void ControlManager::RecoverParts(int plan_id, std::set<int> dead_nodes) {
+  auto* mapupdate_spec = specs_[plan_id].GetMapJoinSpec();
+  const int version = GetLastCPVersion(plan_id);
+  CHECK_NE(version, -1);
+  CHECK_LE(version, versions_[plan_id]);
+  auto now = std::chrono::system_clock::now();
+  // part_id, to_id
+  auto restart_lost_parts = [this, &dead_nodes, version, now](
+          VersionTracker& tracker, int collection_id) {
+    std::vector<std::pair<int, int>> parts;
+    const auto& part_to_node = elem_->collection_map->Get(collection_id).mapper.Get();
+    CHECK_EQ(part_to_node.size(), tracker.GetNumParts());
+    for (int part_id = 0; part_id < tracker.GetNumParts(); ++ part_id) {
+      if (dead_nodes.find(tracker.GetPartNode(part_id)) == dead_nodes.end()) {
+        continue;
+      }
+      tracker.Move(part_id, part_to_node[part_id], now);
+      tracker.SetPartVersion(part_id, version, now);
+      parts.push_back({part_id, part_to_node[part_id]});
+    }
+    return parts;
+  };
+  auto update_parts = restart_lost_parts(update_versions_[plan_id], mapupdate_spec->update_collection_id);
+  auto map_parts = restart_lost_parts(map_versions_[plan_id], mapupdate_spec->map_collection_id);
+  cached_part_to_node_[plan_id][mapupdate_spec->map_collection_id] =
+      elem_->collection_map->Get(mapupdate_spec->map_collection_id).mapper.Get();
+  LOG(INFO) << RED("[ControlManager::RecoverParts] plan " + std::to_string(plan_id)
+          + ", restart " + std::to_string(update_parts.size()) + " update parts and "
+          + std::to_string(map_parts.size()) + " map parts from version " + std::to_string(version)
+          + ", min version: " + std::to_string(versions_[plan_id]));
+  versions_[plan_id] = version;
+  lb_versions_.erase(plan_id);
+
+  SArrayBinStream bin;
+  bin << version << dead_nodes << update_parts << map_parts;
+  SendToAllControllers(elem_, ControllerFlag::kRecoverParts, plan_id, bin);
+}
+
 void ControlManager::Init(int plan_id) {
   start_time_ = std::chrono::system_clock::now();
+  std::vector<int> node_ids;
   for (auto& node : elem_->nodes) {
-    map_node_versions_[plan_id][node.second.node.id].first = 0;
-    map_node_versions_[plan_id][node.second.node.id].second = start_time_;
-    map_node_count_[plan_id][node.second.node.id] = 0;
-
-    update_node_versions_[plan_id][node.second.node.id].first = 0;
-    update_node_versions_[plan_id][node.second.node.id].second = start_time_;
-    update_node_count_[plan_id][node.second.node.id] = 0;
+    node_ids.push_back(node.second.node.id);
   }
 
   auto* mapupdate_spec = static_cast<MapJoinSpec*>(specs_[plan_id].spec.get());
   auto& map_collection_view = elem_->collection_map->Get(mapupdate_spec->map_collection_id);
   auto& map_part_to_node_map = map_collection_view.mapper.Get();
-  for (int i = 0; i < map_part_to_node_map.size(); ++ i) {
-    map_node_count_[plan_id][map_part_to_node_map[i]] += 1;
-    map_part_versions_[plan_id][i].first = 0;
-    map_part_versions_[plan_id][i].second = start_time_;
-  }
+  map_versions_[plan_id].Init(node_ids, map_part_to_node_map, expected_versions_[plan_id], start_time_);
 
   auto& update_collection_view = elem_->collection_map->Get(mapupdate_spec->update_collection_id);
   auto& update_part_to_node_map = update_collection_view.mapper.Get();
-  for (int i = 0; i < update_part_to_node_map.size(); ++ i) {
-    update_node_count_[plan_id][update_part_to_node_map[i]] += 1;
-    update_part_versions_[plan_id][i].first = 0;
-    update_part_versions_[plan_id][i].second = start_time_;
-  }
+  update_versions_[plan_id].Init(node_ids, update_part_to_node_map, expected_versions_[plan_id], start_time_);
   // set the cached_part_to_node_
   cached_part_to_node_[plan_id][mapupdate_spec->map_collection_id] = map_part_to_node_map;
 }
@@ -623,31 +671,8 @@ int ControlManager::GetCurVersion(int plan_id) {
 
 std::string ControlManager::DebugVersions(int plan_id) {
   std::stringstream ss;
-  ss << "map_part_versions_: ";
-  for (auto& pv : map_part_versions_[plan_id]) {
-    ss << pv.first << ": " << pv.second.first << ", ";
-  }
-  ss << "\nmap_node_versions_: ";
-  for (auto& pv : map_node_versions_[plan_id]) {
-    ss << pv.first << ": " << pv.second.first << ", ";
-  }
-  ss << "\nmap_node_count_: ";
-  for (auto& pv : map_node_count_[plan_id]) {
-    ss << pv.first << ": " << pv.second << ", ";
-  }
-
-  ss << "\nupdate_part_versions_: ";
-  for (auto& pv : update_part_versions_[plan_id]) {
-    ss << pv.first << ": " << pv.second.first << ", ";
-  }
-  ss << "\nupdate_node_versions_: ";
-  for (auto& pv : update_node_versions_[plan_id]) {
-    ss << pv.first << ": " << pv.second.first << ", ";
-  }
-  ss << "\nupdate_node_count_: ";
-  for (auto& pv : update_node_count_[plan_id]) {
-    ss << pv.first << ": " << pv.second << ", ";
-  }
+  ss << "map versions:\n" << map_versions_[plan_id].DebugString();
+  ss << "\nupdate versions:\n" << update_versions_[plan_id].DebugString();
   return ss.str();
 }
 
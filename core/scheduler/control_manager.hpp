@@ -1,11 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <thread>
 #include "core/scheduler/scheduler_elem.hpp"
 #include "core/scheduler/control.hpp"
 #include "core/scheduler/checkpoint_loader.hpp"
 #include "core/scheduler/collection_status.hpp"
 #include "core/scheduler/collection_manager.hpp"
+#include "core/scheduler/lb_policy.hpp"
+#include "core/scheduler/version_tracker.hpp"
 
 #include "core/plan/spec_wrapper.hpp"
 
@@ -16,17 +20,50 @@ class ControlManager {
   ControlManager(std::shared_ptr<SchedulerElem> elem,
           std::shared_ptr<CheckpointLoader> cp_loader,
           std::shared_ptr<CollectionStatus> collection_status,
-          std::shared_ptr<CollectionManager> collection_manager)
+          std::shared_ptr<CollectionManager> collection_manager,
+          std::shared_ptr<AbstractLBPolicy> lb_policy = std::make_shared<NoLBPolicy>(),
+          double speculation_factor = 0)
       : elem_(elem), checkpoint_loader_(cp_loader),
         collection_status_(collection_status),
-        collection_manager_(collection_manager) {}
+        collection_manager_(collection_manager),
+        lb_policy_(lb_policy), speculation_factor_(speculation_factor) {
+    if (speculation_factor_ > 0) {
+      speculation_thread_ = std::thread([this]() { SpeculationTicker(); });
+    }
+  }
+  ~ControlManager() {
+    finished_.store(true);
+    if (speculation_thread_.joinable()) {
+      speculation_thread_.join();
+    }
+  }
 
   void Control(SArrayBinStream bin);
+  void Control(ControllerMsg ctrl);
   void RunPlan(SpecWrapper spec, std::function<void()> f);
+  // partition level pipelining
+  // f(collection_id, part_id) is called when an update part reaches the last version
+  void SetFinishPartCallback(std::function<void(int, int)> f) {
+    finish_part_callback_ = f;
+  }
+  // the plan only runs map on the ready parts, gated once called
+  void ReadyParts(int plan_id, std::vector<int> part_ids);
   void AbortPlan(int id, std::function<void()> f);
   //void ToScheduler(ScheduleFlag flag, SArrayBinStream bin);
   int GetCurVersion(int plan_id);
   void ReassignMap(int plan_id, int collection_id);
+  // recovery with the message log
+  // the version of the last checkpoint added in the plan, -1 if none
+  int GetLastCPVersion(int plan_id);
+  // whether the lost update parts can restart from the last checkpoint,
+  // i.e. the senders still have the messages since then
+  bool CanReplayLog(int plan_id);
+  void RecoverParts(int plan_id, std::set<int> dead_nodes);
+  // part_id -> bytes of the update partitions reported
+  std::map<int, size_t> GetPartBytes(int plan_id) { return part_bytes_[plan_id]; }
+  // the join message bytes sent within and across the nodes, summed over
+  // the nodes that have finished the plan
+  std::pair<size_t, size_t> GetShuffleBytes(int plan_id) { return shuffle_bytes_[plan_id]; }
   
   void Migrate(int plan_id);
   void TrySpeculativeMap(int plan_id);
@@ -40,9 +77,11 @@ class ControlManager {
   void Migrate(int plan_id, int from_id, int to_id, int part_id);
   void PreBatchMigrate(int plan_id, std::vector<std::tuple<int, int, int>> meta);
   void BatchMigrate(int plan_id, std::vector<std::tuple<int, int, int>> meta);
-  void MigrateMapOnly(int plan_id, int from_id, int to_id, int part_id);
-  void TryMigrate(int plan_id);
-  void ReceiveFinishCP(int plan_id, int part_id, int version);
+  void SpeculativeMap(int plan_id, int from_id, int to_id, int part_id, int version);
+  void SpeculationTicker();
+  Timepoint GetMapStartTime(int plan_id, int version, Timepoint part_time);
+  void TryLoadBalance(int plan_id);
+  void ReceiveFinishCP(int plan_id, int part_id, int version, int node_id);
  private:
   std::shared_ptr<SchedulerElem> elem_;
   std::shared_ptr<CollectionManager> collection_manager_;
@@ -60,29 +99,50 @@ class ControlManager {
   std::map<int, std::vector<int>> parts_migrated; //part id, versions
   std::map<int, std::pair<std::chrono::system_clock::time_point, std::chrono::system_clock::time_point>> migrate_time;//migrate part id, start time, end time
 
-  // plan_id -> part_id -> {version, time}
-  std::map<int, std::map<int, std::pair<int, Timepoint>>> map_part_versions_;
-  // plan_id -> node_id -> {version, time}
-  std::map<int, std::map<int, std::pair<int, Timepoint>>> map_node_versions_;
-  // plan_id -> node_id -> # min_version part
-  std::map<int, std::map<int, int>> map_node_count_;
-
-  // plan_id -> part_id -> {version, time}
-  std::map<int, std::map<int, std::pair<int, Timepoint>>> update_part_versions_;
-  // plan_id -> node_id -> {version, time}
-  std::map<int, std::map<int, std::pair<int, Timepoint>>> update_node_versions_;
-  // plan_id -> node_id -> # min_version part
-  std::map<int, std::map<int, int>> update_node_count_;
+  // plan_id -> versions of the map parts and nodes
+  std::map<int, VersionTracker> map_versions_;
+  // plan_id -> versions of the update parts and nodes
+  std::map<int, VersionTracker> update_versions_;
   // plan_id -> version -> part ids
   std::map<int, std::map<int, std::set<int>>> cp_count_;
+  // plan_id -> the checkpoints written but not added (waiting for the ones before)
+  std::map<int, std::set<int>> finished_cps_;
+  // plan_id -> the next checkpoint to add
+  std::map<int, int> next_cp_iters_;
 
   std::string DebugVersions(int plan_id);
 
   std::shared_ptr<CheckpointLoader> checkpoint_loader_;
   std::shared_ptr<CollectionStatus> collection_status_;
-  bool migrate_control = true;
+  std::shared_ptr<AbstractLBPolicy> lb_policy_;
+  // plan_id -> the min version at which the lb_policy_ was last asked
+  std::map<int, int> lb_versions_;
+  // plan_id -> part_id -> bytes of the update partition
+  std::map<int, std::map<int, size_t>> part_bytes_;
+  // plan_id -> local, remote shuffle bytes
+  std::map<int, std::pair<size_t, size_t>> shuffle_bytes_;
+
+  // speculative execution, <=0 to disable
+  const double speculation_factor_;
+  static constexpr double kMinSpeculationSeconds = 1.0;
+  static const int kSpeculationCheckInterval = 1000;  // ms
+  // plan_id -> version -> map durations of the finished parts
+  std::map<int, std::map<int, std::vector<double>>> map_durations_;
+  // plan_id -> part_id -> the last version speculated
+  std::map<int, std::map<int, int>> speculated_;
+  std::atomic<int> num_running_plans_{0};
+  std::thread speculation_thread_;
+  std::atomic<bool> finished_{false};
 
   std::map<int, std::function<void()>> callbacks_;
+
+  std::function<void(int, int)> finish_part_callback_;
+  // the running plans gated on the ready parts
+  std::set<int> gated_plans_;
+  // plan_id -> ready parts not sent yet (the plan is not setup)
+  std::map<int, std::vector<int>> pending_ready_parts_;
+  // plan_id -> all the ready parts of the gated plans
+  std::map<int, std::set<int>> ready_parts_;
   
   // plan_id -> collection_id -> part_to_node
   // TODO: this is only used for map-only recovery 
@@ -45,5 +45,84 @@ int WideDagRunner::GetNumRemainingPlans() {
   return dag_visitor_.GetNumDagNodes();
 }
 
+// pipelined dag runner
+std::vector<int> PipelinedDagRunner::GetRunnablePlans() {
+  std::vector<int> ret;
+  for (auto plan : dag_visitor_.GetFront()) {
+    if (running_.find(plan) == running_.end()) {
+      ret.push_back(plan);
+      running_.insert(plan);
+    }
+  }
+  for (auto plan : dag_visitor_.GetPipelinedFront()) {
+    if (running_.find(plan) != running_.end()
+        || deferred_.find(plan) != deferred_.end()) {
+      continue;
+    }
+    // all the upstream plans should be running to produce the parts
+    bool can_run = true;
+    for (auto in : dag_visitor_.GetUnfinishedIn(plan)) {
+      if (running_.find(in) == running_.end() || !can_pipeline_(in, plan)) {
+        can_run = false;
+        break;
+      }
+    }
+    if (can_run) {
+      ret.push_back(plan);
+      running_.insert(plan);
+      pipelined_.insert(plan);
+    }
+  }
+  return ret;
+}
+
+void PipelinedDagRunner::Finish(int plan_id) {
+  CHECK(running_.find(plan_id) != running_.end());
+  running_.erase(plan_id);
+  pipelined_.erase(plan_id);
+  if (!dag_visitor_.GetUnfinishedIn(plan_id).empty()) {
+    // the upstream plans have not reported finish yet
+    deferred_.insert(plan_id);
+    return;
+  }
+  dag_visitor_.Finish(plan_id);
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    for (auto it = deferred_.begin(); it != deferred_.end(); ++ it) {
+      if (dag_visitor_.GetUnfinishedIn(*it).empty()) {
+        dag_visitor_.Finish(*it);
+        deferred_.erase(it);
+        progress = true;
+        break;
+      }
+    }
+  }
+}
+
+int PipelinedDagRunner::GetNumRemainingPlans() {
+  return dag_visitor_.GetNumDagNodes();
+}
+
+bool PipelinedDagRunner::IsPipelined(int plan_id) {
+  return pipelined_.find(plan_id) != pipelined_.end();
+}
+
+std::vector<int> PipelinedDagRunner::GetReadyParts(int plan_id) {
+  CHECK(IsPipelined(plan_id));
+  return dag_visitor_.GetReadyParts(plan_id);
+}
+
+std::vector<int> PipelinedDagRunner::FinishPart(int collection_id, int part_id) {
+  dag_visitor_.FinishPart(collection_id, part_id);
+  std::vector<int> ret;
+  for (auto plan : pipelined_) {
+    if (dag_visitor_.GetPartitionwiseRead(plan) == collection_id) {
+      ret.push_back(plan);
+    }
+  }
+  return ret;
+}
+
 } // namespace xyz
 
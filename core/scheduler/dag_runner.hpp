@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include "core/plan/dag.hpp"
 
 namespace xyz {
@@ -8,6 +10,14 @@ struct AbstractDagRunner {
   virtual std::vector<int> GetRunnablePlans() = 0;
   virtual void Finish(int) = 0;
   virtual int GetNumRemainingPlans() = 0;
+
+  // partition level, only the PipelinedDagRunner starts a plan before
+  // its upstream plans finish.
+  // whether the plan runs gated on the ready parts of its map collection
+  virtual bool IsPipelined(int plan_id) { return false; }
+  virtual std::vector<int> GetReadyParts(int plan_id) { return {}; }
+  // return the pipelined plans that can run on the part now
+  virtual std::vector<int> FinishPart(int collection_id, int part_id) { return {}; }
 };
 
 /*
@@ -51,5 +61,33 @@ class WideDagRunner : public AbstractDagRunner {
   std::set<int> running_;
 };
 
+/*
+ * run as many plans as possible, and start a plan before the plans
+ * writing its map collection finish (e.g. a mapupdate after another
+ * mapupdate), it runs on partition i once partition i is finished.
+ *
+ * can_pipeline(src, dst) tells whether dst can run pipelined after src.
+ */
+class PipelinedDagRunner : public AbstractDagRunner {
+ public:
+  PipelinedDagRunner(const Dag& dag, std::function<bool(int, int)> can_pipeline):
+      dag_visitor_(dag), can_pipeline_(can_pipeline) {}
+  virtual std::vector<int> GetRunnablePlans() override;
+  virtual void Finish(int) override;
+  virtual int GetNumRemainingPlans() override;
+
+  virtual bool IsPipelined(int plan_id) override;
+  virtual std::vector<int> GetReadyParts(int plan_id) override;
+  virtual std::vector<int> FinishPart(int collection_id, int part_id) override;
+ private:
+  DagVistor dag_visitor_;
+  std::function<bool(int, int)> can_pipeline_;
+
+  std::set<int> running_;
+  std::set<int> pipelined_;
+  // pipelined plans finished before their upstream plans
+  std::set<int> deferred_;
+};
+
 } // namespace xyz
 
@@ -7,13 +7,11 @@ void DistributeManager::Distribute(SpecWrapper spec_wrapper) {
   LOG(INFO) << "[Scheduler] Distribute {plan_id, collection_id}: {" 
       << spec_wrapper.id << "," << spec->collection_id << "}";
   part_expected_map_[spec_wrapper.id] = spec->num_partition;
-  // round-robin
-  auto node_iter = elem_->nodes.begin();
+  auto placement = GetPlacement(spec->collection_id, spec->num_partition);
   for (int i = 0; i < spec->num_partition; ++i) {
-    CHECK(node_iter != elem_->nodes.end());
     Message msg;
     msg.meta.sender = 0;
-    msg.meta.recver = GetWorkerQid(node_iter->second.node.id);
+    msg.meta.recver = GetWorkerQid(placement[i]);
     msg.meta.flag = Flag::kOthers;
     SArrayBinStream ctrl_bin, bin;
     ctrl_bin << ScheduleFlag::kDistribute;
@@ -22,12 +20,50 @@ void DistributeManager::Distribute(SpecWrapper spec_wrapper) {
     msg.AddData(ctrl_bin.ToSArray());
     msg.AddData(bin.ToSArray());
     elem_->sender->Send(std::move(msg));
+  }
+}
 
+std::vector<int> DistributeManager::GetPlacement(int collection_id, int num_partition) {
+  std::vector<int> placement(num_partition);
+  // round-robin
+  auto node_iter = elem_->nodes.begin();
+  for (int i = 0; i < num_partition; ++i) {
+    CHECK(node_iter != elem_->nodes.end());
+    placement[i] = node_iter->second.node.id;
     node_iter++;
     if (node_iter == elem_->nodes.end()) {
       node_iter = elem_->nodes.begin();
     }
   }
+
+  auto it = copartitions_.find(collection_id);
+  if (it == copartitions_.end()) {
+    return placement;
+  }
+  int with = it->second;
+  if (!elem_->collection_map->Has(with)) {
+    LOG(WARNING) << "[Scheduler] collection " << collection_id << " is copartitioned with "
+        << with << " which is not created yet, use round-robin";
+    return placement;
+  }
+  const auto& with_view = elem_->collection_map->Get(with);
+  if (with_view.num_partition != num_partition) {
+    LOG(WARNING) << "[Scheduler] collection " << collection_id << " has " << num_partition
+        << " partitions but the copartitioned collection " << with << " has "
+        << with_view.num_partition << ", use round-robin";
+    return placement;
+  }
+  const auto& with_part_to_node = with_view.mapper.Get();
+  int num_colocated = 0;
+  for (int i = 0; i < num_partition; ++i) {
+    if (elem_->nodes.find(with_part_to_node[i]) != elem_->nodes.end()) {
+      placement[i] = with_part_to_node[i];
+      num_colocated += 1;
+    }
+  }
+  LOG(INFO) << "[Scheduler] collection " << collection_id << " copartitioned with "
+      << with << ", " << num_colocated << "/" << num_partition << " partitions colocated";
+  return placement;
 }
 
 void DistributeManager::FinishDistribute(SArrayBinStream bin) {
@@ -15,7 +15,15 @@ class DistributeManager {
   void Distribute(SpecWrapper spec);
   void FinishDistribute(SArrayBinStream bin);
 
+  // collection_id -> the collection it is placed with
+  void SetCopartitions(std::map<int, int> copartitions) {
+    copartitions_ = std::move(copartitions);
+  }
+  // the node of each partition, following the copartitioned collection if possible
+  std::vector<int> GetPlacement(int collection_id, int num_partition);
+
  private:
+  std::map<int, int> copartitions_;
   std::map<int, int> part_expected_map_;
   std::shared_ptr<SchedulerElem> elem_;
   // collection_id, part_id, node_id
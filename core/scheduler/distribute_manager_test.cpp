@@ -0,0 +1,59 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/scheduler/distribute_manager.hpp"
+
+namespace xyz {
+namespace {
+
+class TestDistributeManager : public testing::Test {};
+
+// 3 nodes and collection 0 with 4 parts placed on them
+std::shared_ptr<SchedulerElem> MakeElem() {
+  auto elem = std::make_shared<SchedulerElem>();
+  elem->collection_map = std::make_shared<CollectionMap>();
+  for (int id : {1, 2, 3}) {
+    elem->nodes[id].node.id = id;
+  }
+  CollectionView cv;
+  cv.collection_id = 0;
+  cv.mapper = SimplePartToNodeMapper({3, 1, 1, 2});
+  cv.num_partition = cv.mapper.GetNumParts();
+  elem->collection_map->Insert(cv);
+  return elem;
+}
+
+TEST_F(TestDistributeManager, RoundRobin) {
+  DistributeManager manager(MakeElem(), nullptr);
+  EXPECT_EQ(manager.GetPlacement(1, 4), std::vector<int>({1, 2, 3, 1}));
+}
+
+TEST_F(TestDistributeManager, Copartition) {
+  auto elem = MakeElem();
+  DistributeManager manager(elem, nullptr);
+  manager.SetCopartitions({{1, 0}});
+  // the same part_to_node as collection 0
+  EXPECT_EQ(manager.GetPlacement(1, 4), elem->collection_map->Get(0).mapper.Get());
+  // a different # partitions
+  EXPECT_EQ(manager.GetPlacement(1, 3), std::vector<int>({1, 2, 3}));
+  // not copartitioned
+  EXPECT_EQ(manager.GetPlacement(2, 4), std::vector<int>({1, 2, 3, 1}));
+}
+
+TEST_F(TestDistributeManager, CopartitionNotCreated) {
+  DistributeManager manager(MakeElem(), nullptr);
+  manager.SetCopartitions({{1, 5}});
+  EXPECT_EQ(manager.GetPlacement(1, 4), std::vector<int>({1, 2, 3, 1}));
+}
+
+TEST_F(TestDistributeManager, CopartitionDeadNode) {
+  auto elem = MakeElem();
+  elem->nodes.erase(3);
+  DistributeManager manager(elem, nullptr);
+  manager.SetCopartitions({{1, 0}});
+  // part 0 of collection 0 is on the dead node 3, round-robin for it
+  EXPECT_EQ(manager.GetPlacement(1, 4), std::vector<int>({1, 1, 1, 2}));
+}
+
+}  // namespace
+}  // namespace xyz
@@ -0,0 +1,125 @@
+#include "core/scheduler/lb_policy.hpp"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+namespace {
+
+double Seconds(LBStats::Timepoint::duration d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+}  // namespace
+
+std::vector<std::tuple<int, int, int>> StragglerLBPolicy::Decide(const LBStats& stats) {
+  std::vector<std::tuple<int, int, int>> ret;
+  if (stats.movable_parts.empty() || stats.node_versions.size() < 2) {
+    return ret;
+  }
+
+  // 1. bytes of each part and node
+  double avg_bytes = 1;
+  if (!stats.part_bytes.empty()) {
+    double total = 0;
+    for (auto& pb : stats.part_bytes) {
+      total += pb.second;
+    }
+    avg_bytes = std::max(total / stats.part_bytes.size(), 1.0);
+  }
+  auto bytes_of = [&stats, avg_bytes](int part_id) {
+    auto it = stats.part_bytes.find(part_id);
+    return it == stats.part_bytes.end() ? avg_bytes : std::max<double>(it->second, 1);
+  };
+  std::map<int, double> node_bytes;
+  for (int part_id = 0; part_id < stats.part_to_node.size(); ++ part_id) {
+    node_bytes[stats.part_to_node[part_id]] += bytes_of(part_id);
+  }
+
+  // 2. time of one version and seconds per byte of each node
+  std::map<int, double> time;
+  std::map<int, double> sec_per_byte;
+  double total_sec_per_byte = 0;
+  for (auto& nv : stats.node_versions) {
+    int node_id = nv.first;
+    int version = nv.second.first;
+    double t = 0;
+    if (version > 0) {
+      t = Seconds(nv.second.second - stats.start_time) / version;
+    }
+    if (version == stats.min_version) {
+      // the node is still working on this version
+      t = std::max(t, Seconds(stats.now - stats.start_time) / (version + 1));
+    }
+    if (node_bytes[node_id] > 0 && t > 0) {
+      sec_per_byte[node_id] = t / node_bytes[node_id];
+      total_sec_per_byte += sec_per_byte[node_id];
+    } else {
+      t = 0;  // no part there, idle
+    }
+    time[node_id] = t;
+  }
+  if (sec_per_byte.empty()) {
+    return ret;
+  }
+  const double avg_sec_per_byte = total_sec_per_byte / sec_per_byte.size();
+  for (auto& nv : stats.node_versions) {
+    if (sec_per_byte.find(nv.first) == sec_per_byte.end()) {
+      sec_per_byte[nv.first] = avg_sec_per_byte;
+    }
+  }
+
+  std::map<int, std::vector<int>> movable;  // node_id -> part_ids
+  for (int part_id : stats.movable_parts) {
+    CHECK_LT(part_id, stats.part_to_node.size());
+    movable[stats.part_to_node[part_id]].push_back(part_id);
+  }
+
+  // 3. greedily move from the slowest node to the fastest one
+  using NodeTime = std::pair<const int, double>;
+  auto less_time = [](const NodeTime& a, const NodeTime& b) { return a.second < b.second; };
+  for (int i = 0; i < config_.max_moves; ++ i) {
+    int from_id = std::max_element(time.begin(), time.end(), less_time)->first;
+    int to_id = std::min_element(time.begin(), time.end(), less_time)->first;
+    if (from_id == to_id) {
+      break;
+    }
+    auto& candidates = movable[from_id];
+    int best = -1;
+    double best_time = time[from_id];
+    for (int k = 0; k < candidates.size(); ++ k) {
+      double b = bytes_of(candidates[k]);
+      double t = std::max(time[from_id] - b * sec_per_byte[from_id],
+              time[to_id] + b * (sec_per_byte[to_id] + config_.migrate_sec_per_byte));
+      if (t < best_time) {
+        best = k;
+        best_time = t;
+      }
+    }
+    if (best == -1 || best_time > time[from_id] * (1 - config_.min_gain)) {
+      break;
+    }
+    int part_id = candidates[best];
+    double b = bytes_of(part_id);
+    time[from_id] -= b * sec_per_byte[from_id];
+    time[to_id] += b * (sec_per_byte[to_id] + config_.migrate_sec_per_byte);
+    candidates.erase(candidates.begin() + best);
+    ret.push_back(std::make_tuple(from_id, to_id, part_id));
+  }
+  return ret;
+}
+
+std::shared_ptr<AbstractLBPolicy> CreateLBPolicy(const std::string& type) {
+  if (type == "none") {
+    return std::make_shared<NoLBPolicy>();
+  } else if (type == "straggler") {
+    return std::make_shared<StragglerLBPolicy>();
+  } else {
+    CHECK(false) << "unknown lb policy: " << type;
+  }
+  return nullptr;
+}
+
+}  // namespace xyz
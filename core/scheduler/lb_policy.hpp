@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace xyz {
+
+/*
+ * The runtime information of a plan fed to the load balancing policy.
+ * It is collected by the ControlManager from the versions reported by
+ * the PlanControllers.
+ */
+struct LBStats {
+  using Timepoint = std::chrono::system_clock::time_point;
+  int min_version;
+  int staleness;
+  Timepoint start_time;
+  Timepoint now;
+  // node_id -> {version, time when the node reached the version}
+  std::map<int, std::pair<int, Timepoint>> node_versions;
+  // the part_to_node of the collection to be balanced
+  std::vector<int> part_to_node;
+  // part_id -> estimated bytes, parts not reported yet use the average
+  std::map<int, size_t> part_bytes;
+  // the parts that can be migrated now (at the min version)
+  std::vector<int> movable_parts;
+};
+
+/*
+ * Decide which partitions to move from the stragglers to the fast nodes.
+ * The ControlManager carries out the decision with BatchMigrate.
+ */
+class AbstractLBPolicy {
+ public:
+  virtual ~AbstractLBPolicy() = default;
+  // return <from_id, to_id, part_id>
+  virtual std::vector<std::tuple<int, int, int>> Decide(const LBStats& stats) = 0;
+};
+
+class NoLBPolicy : public AbstractLBPolicy {
+ public:
+  virtual std::vector<std::tuple<int, int, int>> Decide(const LBStats& stats) override {
+    return {};
+  }
+};
+
+/*
+ * Greedy policy with a cost model on partition bytes.
+ *
+ * The time a node needs for one version is estimated from its progress,
+ * and divided by the bytes it holds to get its seconds per byte. Moving a
+ * partition of b bytes from s to f is expected to change the time of the
+ * next version to
+ *   max(T_s - b * spb_s, T_f + b * (spb_f + migrate_sec_per_byte))
+ * The policy keeps moving the partition that minimizes this from the
+ * slowest node to the fastest one as long as it gains at least min_gain.
+ */
+class StragglerLBPolicy : public AbstractLBPolicy {
+ public:
+  struct Config {
+    // cost of moving one byte, 1e-8 is about 100MB/s
+    double migrate_sec_per_byte = 1e-8;
+    // the relative gain required for a move
+    double min_gain = 0.1;
+    int max_moves = 8;
+  };
+
+  StragglerLBPolicy() = default;
+  explicit StragglerLBPolicy(Config config) : config_(config) {}
+
+  virtual std::vector<std::tuple<int, int, int>> Decide(const LBStats& stats) override;
+
+ private:
+  Config config_;
+};
+
+// type: "none", "straggler"
+std::shared_ptr<AbstractLBPolicy> CreateLBPolicy(const std::string& type);
+
+}  // namespace xyz
@@ -0,0 +1,74 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/scheduler/lb_policy.hpp"
+
+namespace xyz {
+namespace {
+
+class TestLBPolicy : public testing::Test {};
+
+// 3 nodes with 2 parts of 100 bytes each
+LBStats MakeStats() {
+  LBStats stats;
+  stats.min_version = 0;
+  stats.staleness = 2;
+  stats.start_time = LBStats::Timepoint();
+  stats.now = stats.start_time + std::chrono::seconds(30);
+  stats.part_to_node = {1, 2, 3, 1, 2, 3};
+  for (int i = 0; i < 6; ++ i) {
+    stats.part_bytes[i] = 100;
+  }
+  return stats;
+}
+
+TEST_F(TestLBPolicy, NoLB) {
+  auto stats = MakeStats();
+  stats.node_versions[1] = {0, stats.start_time};
+  stats.node_versions[2] = {3, stats.start_time + std::chrono::seconds(9)};
+  stats.movable_parts = {0, 3};
+  auto policy = CreateLBPolicy("none");
+  EXPECT_TRUE(policy->Decide(stats).empty());
+}
+
+TEST_F(TestLBPolicy, MoveFromStraggler) {
+  auto stats = MakeStats();
+  // node 1 has not finished version 0 in 30s, the others take 3s per version
+  stats.node_versions[1] = {0, stats.start_time};
+  stats.node_versions[2] = {3, stats.start_time + std::chrono::seconds(9)};
+  stats.node_versions[3] = {3, stats.start_time + std::chrono::seconds(9)};
+  stats.movable_parts = {0, 3};
+  auto policy = CreateLBPolicy("straggler");
+  auto ret = policy->Decide(stats);
+  ASSERT_EQ(ret.size(), 2);
+  EXPECT_EQ(ret[0], std::make_tuple(1, 2, 0));
+  EXPECT_EQ(ret[1], std::make_tuple(1, 3, 3));
+}
+
+TEST_F(TestLBPolicy, Balanced) {
+  auto stats = MakeStats();
+  stats.min_version = 1;
+  stats.now = stats.start_time + std::chrono::seconds(12);
+  for (int node_id = 1; node_id <= 3; ++ node_id) {
+    stats.node_versions[node_id] = {1, stats.start_time + std::chrono::seconds(10)};
+  }
+  stats.movable_parts = {0, 1, 2, 3, 4, 5};
+  auto policy = CreateLBPolicy("straggler");
+  EXPECT_TRUE(policy->Decide(stats).empty());
+}
+
+TEST_F(TestLBPolicy, MigrateCost) {
+  auto stats = MakeStats();
+  stats.node_versions[1] = {0, stats.start_time};
+  stats.node_versions[2] = {3, stats.start_time + std::chrono::seconds(9)};
+  stats.node_versions[3] = {3, stats.start_time + std::chrono::seconds(9)};
+  stats.movable_parts = {0, 3};
+  // moving is more expensive than waiting for the straggler
+  StragglerLBPolicy::Config config;
+  config.migrate_sec_per_byte = 1;
+  StragglerLBPolicy policy(config);
+  EXPECT_TRUE(policy.Decide(stats).empty());
+}
+
+} // namespace
+} // namespace xyz
@@ -0,0 +1,139 @@
+#include "core/scheduler/recover_assigner.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+namespace {
+
+double AvgBytes(const RecoverStats& stats) {
+  if (stats.part_bytes.empty()) {
+    return 1;
+  }
+  double total = 0;
+  for (auto& pb : stats.part_bytes) {
+    total += pb.second;
+  }
+  return std::max(total / stats.part_bytes.size(), 1.0);
+}
+
+double BytesOf(const RecoverStats& stats, double avg_bytes, int part_id) {
+  auto it = stats.part_bytes.find(part_id);
+  return it == stats.part_bytes.end() ? avg_bytes : std::max<double>(it->second, 1);
+}
+
+int ThreadsOf(const RecoverStats& stats, int node_id) {
+  auto it = stats.node_threads.find(node_id);
+  return (it == stats.node_threads.end() || it->second <= 0) ? 1 : it->second;
+}
+
+// the live node with the least load after taking bytes, the smaller id on ties
+int LeastLoaded(const RecoverStats& stats, const std::map<int, double>& loads, double bytes) {
+  int best = -1;
+  double best_load = std::numeric_limits<double>::max();
+  for (auto& kv : loads) {
+    double load = kv.second + bytes / ThreadsOf(stats, kv.first);
+    if (load < best_load) {
+      best = kv.first;
+      best_load = load;
+    }
+  }
+  return best;
+}
+
+}  // namespace
+
+std::map<int, double> RecoverAssigner::GetNodeLoads(const RecoverStats& stats,
+        const std::vector<int>& part_to_node) {
+  const double avg_bytes = AvgBytes(stats);
+  std::map<int, double> loads;
+  for (auto& nt : stats.node_threads) {
+    if (stats.dead_nodes.find(nt.first) == stats.dead_nodes.end()) {
+      loads[nt.first] = 0;
+    }
+  }
+  for (int part_id = 0; part_id < part_to_node.size(); ++ part_id) {
+    int node_id = part_to_node[part_id];
+    if (stats.dead_nodes.find(node_id) == stats.dead_nodes.end()) {
+      loads[node_id] += BytesOf(stats, avg_bytes, part_id) / ThreadsOf(stats, node_id);
+    }
+  }
+  return loads;
+}
+
+double RecoverAssigner::GetImbalance(const std::map<int, double>& loads) {
+  double total = 0, max_load = 0;
+  for (auto& kv : loads) {
+    total += kv.second;
+    max_load = std::max(max_load, kv.second);
+  }
+  return total == 0 ? 1 : max_load / (total / loads.size());
+}
+
+std::string RecoverAssigner::DebugString(const std::map<int, double>& loads) {
+  std::stringstream ss;
+  ss << "imbalance: " << GetImbalance(loads) << ", node loads:";
+  for (auto& kv : loads) {
+    ss << " " << kv.first << ":" << kv.second;
+  }
+  return ss.str();
+}
+
+std::vector<int> RecoverAssigner::Assign(const RecoverStats& stats) const {
+  std::vector<int> part_to_node = stats.part_to_node;
+  auto loads = GetNodeLoads(stats, part_to_node);
+  CHECK(!loads.empty()) << "no live node";
+  const double avg_bytes = AvgBytes(stats);
+
+  // dead node -> lost parts, the largest first
+  std::map<int, std::vector<int>> lost;
+  for (int part_id = 0; part_id < part_to_node.size(); ++ part_id) {
+    if (stats.dead_nodes.find(part_to_node[part_id]) != stats.dead_nodes.end()) {
+      lost[part_to_node[part_id]].push_back(part_id);
+    }
+  }
+  auto larger = [&stats, avg_bytes](int a, int b) {
+    double ba = BytesOf(stats, avg_bytes, a), bb = BytesOf(stats, avg_bytes, b);
+    return ba != bb ? ba > bb : a < b;
+  };
+
+  if (spread_) {
+    std::vector<int> parts;
+    for (auto& kv : lost) {
+      parts.insert(parts.end(), kv.second.begin(), kv.second.end());
+    }
+    std::sort(parts.begin(), parts.end(), larger);
+    for (int part_id : parts) {
+      double bytes = BytesOf(stats, avg_bytes, part_id);
+      int node_id = LeastLoaded(stats, loads, bytes);
+      part_to_node[part_id] = node_id;
+      loads[node_id] += bytes / ThreadsOf(stats, node_id);
+    }
+  } else {
+    // the dead node with the most bytes first
+    std::vector<std::pair<double, int>> dead;  // bytes, dead node
+    for (auto& kv : lost) {
+      double bytes = 0;
+      for (int part_id : kv.second) {
+        bytes += BytesOf(stats, avg_bytes, part_id);
+      }
+      dead.push_back({-bytes, kv.first});
+    }
+    std::sort(dead.begin(), dead.end());
+    for (auto& d : dead) {
+      double bytes = -d.first;
+      int node_id = LeastLoaded(stats, loads, bytes);
+      for (int part_id : lost[d.second]) {
+        part_to_node[part_id] = node_id;
+      }
+      loads[node_id] += bytes / ThreadsOf(stats, node_id);
+    }
+  }
+  return part_to_node;
+}
+
+}  // namespace xyz
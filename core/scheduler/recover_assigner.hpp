@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace xyz {
+
+/*
+ * The placement of a collection when some nodes are dead, fed to the
+ * RecoverAssigner by the RecoverManager.
+ */
+struct RecoverStats {
+  // the part_to_node of the collection, with the dead nodes
+  std::vector<int> part_to_node;
+  std::set<int> dead_nodes;
+  // node_id -> # threads of the live nodes
+  std::map<int, int> node_threads;
+  // part_id -> estimated bytes, parts not reported yet use the average
+  std::map<int, size_t> part_bytes;
+};
+
+/*
+ * Assign the partitions of the dead nodes to the live nodes by load.
+ *
+ * The load of a node is the bytes of its partitions divided by its
+ * threads. With spread, the lost partitions are placed one by one, the
+ * largest first, on the node with the least load after taking it. Without
+ * spread, all the partitions of a dead node go to one live node (the least
+ * loaded one after taking them), to keep them together.
+ *
+ * It is deterministic, so the copartitioned collections with the same
+ * part_to_node and bytes get the same placement.
+ */
+class RecoverAssigner {
+ public:
+  explicit RecoverAssigner(bool spread = true) : spread_(spread) {}
+
+  // return the new part_to_node
+  std::vector<int> Assign(const RecoverStats& stats) const;
+
+  // node_id -> load of the live nodes in part_to_node
+  static std::map<int, double> GetNodeLoads(const RecoverStats& stats,
+          const std::vector<int>& part_to_node);
+  // the max load over the average load of the live nodes, 1 is balanced
+  static double GetImbalance(const std::map<int, double>& loads);
+  static std::string DebugString(const std::map<int, double>& loads);
+
+ private:
+  const bool spread_;
+};
+
+}  // namespace xyz
@@ -0,0 +1,89 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/scheduler/recover_assigner.hpp"
+
+namespace xyz {
+
+namespace {
+
+class TestRecoverAssigner : public testing::Test {};
+
+// 4 nodes with 1 thread, node 1 is dead
+RecoverStats MakeStats() {
+  RecoverStats stats;
+  stats.part_to_node = {1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4};
+  stats.dead_nodes = {1};
+  for (int node_id = 1; node_id <= 4; ++ node_id) {
+    stats.node_threads[node_id] = 1;
+  }
+  return stats;
+}
+
+TEST_F(TestRecoverAssigner, Spread) {
+  auto stats = MakeStats();
+  RecoverAssigner assigner;
+  auto part_to_node = assigner.Assign(stats);
+  ASSERT_EQ(part_to_node.size(), 12);
+  // the 3 lost parts go to 3 different nodes
+  std::set<int> nodes;
+  for (int part_id : {0, 4, 8}) {
+    EXPECT_NE(part_to_node[part_id], 1);
+    nodes.insert(part_to_node[part_id]);
+  }
+  EXPECT_EQ(nodes.size(), 3);
+  // the others stay
+  for (int part_id = 0; part_id < 12; ++ part_id) {
+    if (part_id % 4 != 0) {
+      EXPECT_EQ(part_to_node[part_id], stats.part_to_node[part_id]);
+    }
+  }
+  EXPECT_DOUBLE_EQ(RecoverAssigner::GetImbalance(
+              RecoverAssigner::GetNodeLoads(stats, part_to_node)), 1);
+}
+
+TEST_F(TestRecoverAssigner, ByBytes) {
+  auto stats = MakeStats();
+  // node 2 is heavy, node 3 has 2 threads
+  stats.part_bytes = {{0, 100}, {4, 100}, {8, 100},
+      {1, 400}, {5, 400}, {9, 400},
+      {2, 100}, {6, 100}, {10, 100},
+      {3, 100}, {7, 100}, {11, 100}};
+  stats.node_threads[3] = 2;
+  RecoverAssigner assigner;
+  auto part_to_node = assigner.Assign(stats);
+  // loads before: 2: 1200, 3: 150, 4: 300, node 3 takes 50 per part
+  int num_on_2 = 0, num_on_3 = 0;
+  for (int part_id : {0, 4, 8}) {
+    num_on_2 += part_to_node[part_id] == 2;
+    num_on_3 += part_to_node[part_id] == 3;
+  }
+  EXPECT_EQ(num_on_2, 0);
+  EXPECT_EQ(num_on_3, 3);
+}
+
+TEST_F(TestRecoverAssigner, NoSpread) {
+  auto stats = MakeStats();
+  stats.part_to_node = {1, 2, 3, 4, 1, 2, 3, 1};
+  stats.dead_nodes = {1, 3};
+  RecoverAssigner assigner(false);
+  auto part_to_node = assigner.Assign(stats);
+  // the parts of node 1 (3 parts) stay together, and so do the ones of node 3
+  EXPECT_EQ(part_to_node[0], part_to_node[4]);
+  EXPECT_EQ(part_to_node[0], part_to_node[7]);
+  EXPECT_EQ(part_to_node[2], part_to_node[6]);
+  EXPECT_NE(part_to_node[0], part_to_node[2]);
+  for (int node_id : part_to_node) {
+    EXPECT_TRUE(node_id == 2 || node_id == 4);
+  }
+}
+
+TEST_F(TestRecoverAssigner, Deterministic) {
+  auto stats = MakeStats();
+  stats.part_bytes = {{0, 10}, {4, 30}};  // the others use the average
+  RecoverAssigner assigner;
+  EXPECT_EQ(assigner.Assign(stats), assigner.Assign(stats));
+}
+
+}  // namespace
+}  // namespace xyz
@@ -42,8 +42,12 @@ void RecoverManager::Recover(std::set<int> dead_nodes,
 
   // recover the reads
   for (auto r : reads) {
-    recovering_collections_.insert(r.first);
     auto updates = ReplaceDeadnodesAndReturnUpdated(r.first, dead_nodes);
+    if (updates.empty()) {
+      // nothing to load, the collection map is still updated below
+      continue;
+    }
+    recovering_collections_.insert(r.first);
     const std::string url = r.second;
 
     std::stringstream ss;
@@ -99,24 +103,35 @@ void RecoverManager::RecoverDoneForACollection(int cid, RecoverManager::Type typ
   }
 }
 
+// The lost partitions go to the live nodes by their bytes and threads.
 std::vector<int> RecoverManager::ReplaceDeadnodesAndReturnUpdated(int cid, std::set<int> dead_nodes) {
   std::vector<int> updates;
   auto& collection_view = elem_->collection_map->Get(cid);
   auto& part_to_node = collection_view.mapper.Mutable();
-  auto live_node_iter = elem_->nodes.begin();
+  RecoverStats stats;
+  stats.part_to_node = part_to_node;
+  stats.dead_nodes = dead_nodes;
+  for (auto& node : elem_->nodes) {
+    if (dead_nodes.find(node.first) == dead_nodes.end()) {
+      stats.node_threads[node.first] = node.second.num_local_threads;
+    }
+  }
+  if (part_bytes_num_parts_ == part_to_node.size()) {
+    stats.part_bytes = part_bytes_;
+  }
+  auto before = RecoverAssigner::GetNodeLoads(stats, part_to_node);
+  auto new_part_to_node = assigner_.Assign(stats);
   for (int i = 0; i < part_to_node.size(); ++ i) {
-    int node_id = part_to_node[i];
-    // if a node is a dead node, replace it with a live node
-    if (dead_nodes.find(node_id) != dead_nodes.end()) {
-      part_to_node[i] = live_node_iter->second.node.id;
+    if (new_part_to_node[i] != part_to_node[i]) {
+      CHECK(dead_nodes.find(part_to_node[i]) != dead_nodes.end());
       updates.push_back(i);
-      live_node_iter++;
-      if (live_node_iter == elem_->nodes.end()) {
-        // round-robin assign the live node to it.
-        live_node_iter = elem_->nodes.begin();
-      }
     }
   }
+  part_to_node = new_part_to_node;
+  auto after = RecoverAssigner::GetNodeLoads(stats, part_to_node);
+  LOG(INFO) << "[RecoverManager] collection " << cid << " reassigned " << updates.size()
+    << " parts, before: " << RecoverAssigner::DebugString(before)
+    << "; after: " << RecoverAssigner::DebugString(after);
   return updates;
 }
 
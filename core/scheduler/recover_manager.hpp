@@ -4,6 +4,7 @@
 #include "core/scheduler/checkpoint_loader.hpp"
 #include "core/scheduler/collection_manager.hpp"
 #include "core/scheduler/collection_status.hpp"
+#include "core/scheduler/recover_assigner.hpp"
 #include "core/plan/spec_wrapper.hpp"
 
 #include <chrono>
@@ -12,9 +13,19 @@ namespace xyz {
 
 class RecoverManager {
  public:
+  // spread: spread the partitions of a dead node over the live nodes,
+  // see RecoverAssigner
   RecoverManager(std::shared_ptr<SchedulerElem> elem, std::shared_ptr<CollectionManager> collection_manager,
-    std::shared_ptr<CheckpointLoader> checkpoint_loader)
-      : elem_(elem), collection_manager_(collection_manager), checkpoint_loader_(checkpoint_loader) {}
+    std::shared_ptr<CheckpointLoader> checkpoint_loader, bool spread = true)
+      : elem_(elem), collection_manager_(collection_manager), checkpoint_loader_(checkpoint_loader),
+        assigner_(spread) {}
+
+  // part_id -> bytes of the collections with num_parts partitions, for
+  // the placement of the lost partitions
+  void SetPartBytes(int num_parts, std::map<int, size_t> part_bytes) {
+    part_bytes_num_parts_ = num_parts;
+    part_bytes_ = std::move(part_bytes);
+  }
 
   // <int, std::string>: <collection_id, checkpoint>
   void Recover(std::set<int> dead_nodes,
@@ -33,6 +44,9 @@ class RecoverManager {
   std::shared_ptr<SchedulerElem> elem_;
   std::shared_ptr<CollectionManager> collection_manager_;
   std::shared_ptr<CheckpointLoader> checkpoint_loader_;
+  RecoverAssigner assigner_;
+  int part_bytes_num_parts_ = -1;
+  std::map<int, size_t> part_bytes_;
 
   std::set<int> recovering_collections_;
   std::set<int> updating_collections_;
@@ -73,6 +73,9 @@ void Scheduler::Process(Message msg) {
     }
     dag_runner_->Finish(plan_id);
     collection_status_->FinishPlan(plan_id);
+    for (auto collection_id : collection_status_->ReleaseUser(plan_id)) {
+      ReleaseCollection(collection_id);
+    }
     // LOG(INFO) << collection_status_->DebugString();
     TryRunPlan();
     break;
@@ -99,9 +102,20 @@ void Scheduler::RegisterProgram(int node_id, SArrayBinStream bin) {
       dag_runner_.reset(new SequentialDagRunner(program_.dag));
     } else if (dag_runner_type_ == "wide") {
       dag_runner_.reset(new WideDagRunner(program_.dag));
+    } else if (dag_runner_type_ == "pipelined") {
+      // the partition level gating is done by the PlanControllers
+      auto is_mapjoin = [this](int plan_id) {
+        auto type = program_.specs[plan_id].type;
+        return type == SpecWrapper::Type::kMapJoin || type == SpecWrapper::Type::kMapWithJoin;
+      };
+      dag_runner_.reset(new PipelinedDagRunner(program_.dag, [is_mapjoin](int src, int dst) {
+        return is_mapjoin(src) && is_mapjoin(dst);
+      }));
     } else {
       CHECK(false);
     }
+    collection_status_->SetCollectionUsers(program_.dag.GetCollectionUsers());
+    distribute_manager_->SetCopartitions(program_.copartitions);
     LOG(INFO) << "[Scheduler] Receive program: " << program_.DebugString();
   }
   register_program_count_ += 1;
@@ -143,6 +157,10 @@ void Scheduler::RunPlan(int plan_id) {
       reply_bin << id;
       ToScheduler(elem_, ScheduleFlag::kFinishPlan, reply_bin);
     });
+    if (dag_runner_->IsPipelined(plan_id)) {
+      LOG(INFO) << "[Scheduler] Plan " << plan_id << " runs pipelined with its upstream plans";
+      control_manager_->ReadyParts(id, dag_runner_->GetReadyParts(plan_id));
+    }
   } else if (spec.type == SpecWrapper::Type::kWrite) {
     LOG(INFO) << "[Scheduler] Writing: " << spec.DebugString();
     write_manager_->Write(spec);
@@ -157,6 +175,19 @@ void Scheduler::RunPlan(int plan_id) {
   }
 }
 
+void Scheduler::ReleaseCollection(int collection_id) {
+  LOG(INFO) << "[Scheduler] Release collection " << collection_id << ", no plan uses it anymore";
+  SArrayBinStream bin;
+  bin << collection_id;
+  SendToAllWorkers(elem_, ScheduleFlag::kReleaseCollection, bin);
+}
+
+void Scheduler::FinishPart(int collection_id, int part_id) {
+  for (auto plan_id : dag_runner_->FinishPart(collection_id, part_id)) {
+    control_manager_->ReadyParts(plan_id, {part_id});
+  }
+}
+
 void Scheduler::FinishRecovery() {
   LOG(INFO) << "[Scheduler] FinishRecovery";
   auto cur_plans = collection_status_->GetCurrentPlans();
@@ -218,8 +249,24 @@ void Scheduler::Recovery(SArrayBinStream bin) {
   auto spec_wrapper = program_.specs[plan_id];
   CHECK(spec_wrapper.type == SpecWrapper::Type::kMapJoin
        || spec_wrapper.type == SpecWrapper::Type::kMapWithJoin);
+  // place the lost partitions by the bytes of the update partitions
+  int update_collection_id = spec_wrapper.GetMapJoinSpec()->update_collection_id;
+  recover_manager_->SetPartBytes(elem_->collection_map->GetNumParts(update_collection_id),
+          control_manager_->GetPartBytes(plan_id));
   
-  if (LostWriteCollection(dead_nodes)) {
+  if (LostWriteCollection(dead_nodes) && control_manager_->CanReplayLog(plan_id)) {
+    LOG(INFO) << RED("Some write partitions lost, restarting them with the message log");
+    // only the lost partitions are loaded, the writes as well
+    auto reads = collection_status_->GetReadsAndCP();
+    for (auto& w : collection_status_->GetWritesAndCP()) {
+      if (std::find(reads.begin(), reads.end(), w) == reads.end()) {
+        reads.push_back(w);
+      }
+    }
+    recover_manager_->Recover(dead_nodes, {}, reads, [this, plan_id, dead_nodes]() {
+      control_manager_->RecoverParts(plan_id, dead_nodes);
+    });
+  } else if (LostWriteCollection(dead_nodes)) {
     LOG(INFO) << RED("Some write partitions lost, aborting plan");
     control_manager_->AbortPlan(plan_id, [this, dead_nodes]() {
       // TODO: only work for 1 running plan
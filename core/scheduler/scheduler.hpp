@@ -38,27 +38,35 @@ class Scheduler : public Actor {
 public:
   Scheduler(int qid, std::shared_ptr<AbstractSender> sender,
             std::function<std::shared_ptr<Assigner>()> builder,
-            std::string dag_runner_type)
+            std::string dag_runner_type,
+            std::string lb_policy_type = "none",
+            double speculation_factor = 0,
+            bool spread_recovery = true)
       : Actor(qid), dag_runner_type_(dag_runner_type) {
     CHECK(dag_runner_type_ == "sequential"
-       || dag_runner_type_ == "wide");
+       || dag_runner_type_ == "wide"
+       || dag_runner_type_ == "pipelined");
     // setup elem_
     elem_ = std::make_shared<SchedulerElem>();
     elem_->sender = sender;
     elem_->collection_map = std::make_shared<CollectionMap>();
     // setup managers 
-    checkpoint_loader_ = std::make_shared<CheckpointLoader>(elem_);
-    collection_manager_ = std::make_shared<CollectionManager>(elem_);
-
     collection_status_ = std::make_shared<CollectionStatus>();
+    checkpoint_loader_ = std::make_shared<CheckpointLoader>(elem_, collection_status_);
+    collection_manager_ = std::make_shared<CollectionManager>(elem_);
 
     block_manager_ = std::make_shared<BlockManager>(elem_, collection_manager_, builder);
     control_manager_ = std::make_shared<ControlManager>(elem_, 
-            checkpoint_loader_, collection_status_, collection_manager_);
+            checkpoint_loader_, collection_status_, collection_manager_,
+            CreateLBPolicy(lb_policy_type), speculation_factor);
+    control_manager_->SetFinishPartCallback([this](int collection_id, int part_id) {
+      FinishPart(collection_id, part_id);
+    });
     distribute_manager_ = std::make_shared<DistributeManager>(elem_, collection_manager_);
     write_manager_ = std::make_shared<WriteManager>(elem_);
     checkpoint_manager_ = std::make_shared<CheckpointManager>(elem_, checkpoint_loader_, collection_status_);
-    recover_manager_ = std::make_shared<RecoverManager>(elem_, collection_manager_, checkpoint_loader_);
+    recover_manager_ = std::make_shared<RecoverManager>(elem_, collection_manager_, checkpoint_loader_,
+            spread_recovery);
   }
   virtual ~Scheduler() override {
     if (start_) {
@@ -90,6 +98,10 @@ public:
   void Exit();
 
   void RunPlan(int plan_id);
+  // an update part of a running plan reaches its last version
+  void FinishPart(int collection_id, int part_id);
+  // free the partitions of a dead collection on the workers
+  void ReleaseCollection(int collection_id);
 
   void Recovery(SArrayBinStream bin);
   void FinishRecovery();
@@ -11,6 +11,7 @@ void SendToAllWorkers(std::shared_ptr<SchedulerElem> elem, ScheduleFlag flag, SA
     msg.meta.sender = 0;
     msg.meta.recver = GetWorkerQid(node.second.node.id);
     msg.meta.flag = Flag::kOthers;
+    msg.meta.traffic_class = TrafficClass::kControl;
     msg.AddData(ctrl_bin.ToSArray());
     msg.AddData(bin.ToSArray());
     elem->sender->Send(std::move(msg));
@@ -24,6 +25,7 @@ void SendTo(std::shared_ptr<SchedulerElem> elem, int node_id, ScheduleFlag flag,
   msg.meta.sender = 0;
   msg.meta.recver = GetWorkerQid(node_id);
   msg.meta.flag = Flag::kOthers;
+  msg.meta.traffic_class = TrafficClass::kControl;
   msg.AddData(ctrl_bin.ToSArray());
   msg.AddData(bin.ToSArray());
   elem->sender->Send(std::move(msg));
@@ -36,6 +38,7 @@ void ToScheduler(std::shared_ptr<SchedulerElem> elem, ScheduleFlag flag, SArrayB
   msg.meta.sender = -1;
   msg.meta.recver = 0;
   msg.meta.flag = Flag::kOthers;
+  msg.meta.traffic_class = TrafficClass::kControl;
   msg.AddData(ctrl_bin.ToSArray());
   msg.AddData(bin.ToSArray());
   elem->sender->Send(std::move(msg));
@@ -50,6 +53,7 @@ void SendToAllControllers(std::shared_ptr<SchedulerElem> elem, ControllerFlag fl
     msg.meta.sender = 0;
     msg.meta.recver = GetControllerActorQid(node.second.node.id);
     msg.meta.flag = Flag::kOthers;
+    msg.meta.traffic_class = TrafficClass::kControl;
     msg.AddData(ctrl_bin.ToSArray());
     msg.AddData(plan_bin.ToSArray());
     msg.AddData(bin.ToSArray());
@@ -65,6 +69,7 @@ void SendToController(std::shared_ptr<SchedulerElem> elem, int node_id, Controll
   msg.meta.sender = 0;
   msg.meta.recver = GetControllerActorQid(node_id);
   msg.meta.flag = Flag::kOthers;
+  msg.meta.traffic_class = TrafficClass::kControl;
   msg.AddData(ctrl_bin.ToSArray());
   msg.AddData(plan_bin.ToSArray());
   msg.AddData(bin.ToSArray());
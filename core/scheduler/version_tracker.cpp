@@ -0,0 +1,210 @@
+#include "core/scheduler/version_tracker.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+void VersionTracker::Init(const std::vector<int>& node_ids, const std::vector<int>& part_to_node,
+        int max_version, Timepoint start_time) {
+  CHECK_GE(max_version, 0);
+  max_version_ = max_version;
+  node_slot_.clear();
+  node_ids_.clear();
+  node_version_.clear();
+  node_time_.clear();
+  node_num_parts_.clear();
+  counts_.clear();
+  for (int node_id : node_ids) {
+    AddNode(node_id, start_time);
+  }
+
+  part_version_.assign(part_to_node.size(), 0);
+  part_time_.assign(part_to_node.size(), start_time);
+  part_node_.resize(part_to_node.size());
+  for (int part_id = 0; part_id < part_to_node.size(); ++ part_id) {
+    int slot = Slot(part_to_node[part_id]);
+    if (slot == -1) {
+      slot = AddNode(part_to_node[part_id], start_time);
+    }
+    part_node_[part_id] = slot;
+    Add(slot, 0);
+  }
+}
+
+bool VersionTracker::Update(int part_id, int version, Timepoint t) {
+  CHECK_LT(part_id, part_version_.size());
+  CHECK_EQ(part_version_[part_id] + 1, version) << "version updated by 1 every time";
+  CHECK_LE(version, max_version_);
+  const int slot = part_node_[part_id];
+  const int stride = max_version_ + 1;
+  counts_[slot * stride + version - 1] -= 1;
+  counts_[slot * stride + version] += 1;
+  part_version_[part_id] = version;
+  part_time_[part_id] = t;
+  if (node_version_[slot] == version - 1 && counts_[slot * stride + version - 1] == 0) {
+    return Advance(slot, t);
+  }
+  return false;
+}
+
+void VersionTracker::Move(int part_id, int to_id, Timepoint t) {
+  CHECK_LT(part_id, part_version_.size());
+  int to_slot = Slot(to_id);
+  if (to_slot == -1) {
+    to_slot = AddNode(to_id, t);
+  }
+  if (part_node_[part_id] == to_slot) {
+    return;
+  }
+  const int version = part_version_[part_id];
+  Remove(part_node_[part_id], version, t);
+  Add(to_slot, version);
+  part_node_[part_id] = to_slot;
+}
+
+void VersionTracker::SetPartVersion(int part_id, int version, Timepoint t) {
+  CHECK_LT(part_id, part_version_.size());
+  CHECK_GE(version, 0);
+  CHECK_LE(version, max_version_);
+  const int slot = part_node_[part_id];
+  const int old_version = part_version_[part_id];
+  const int stride = max_version_ + 1;
+  counts_[slot * stride + old_version] -= 1;
+  counts_[slot * stride + version] += 1;
+  part_version_[part_id] = version;
+  part_time_[part_id] = t;
+  if (version < node_version_[slot]) {
+    node_version_[slot] = version;
+    node_time_[slot] = t;
+  } else if (old_version == node_version_[slot]) {
+    Advance(slot, t);
+  }
+}
+
+int VersionTracker::GetPartVersion(int part_id) const {
+  CHECK_LT(part_id, part_version_.size());
+  return part_version_[part_id];
+}
+
+VersionTracker::Timepoint VersionTracker::GetPartTime(int part_id) const {
+  CHECK_LT(part_id, part_time_.size());
+  return part_time_[part_id];
+}
+
+int VersionTracker::GetPartNode(int part_id) const {
+  CHECK_LT(part_id, part_node_.size());
+  return node_ids_[part_node_[part_id]];
+}
+
+int VersionTracker::GetNodeVersion(int node_id) const {
+  int slot = Slot(node_id);
+  CHECK_NE(slot, -1) << "unknown node: " << node_id;
+  return node_version_[slot];
+}
+
+VersionTracker::Timepoint VersionTracker::GetNodeTime(int node_id) const {
+  int slot = Slot(node_id);
+  CHECK_NE(slot, -1) << "unknown node: " << node_id;
+  return node_time_[slot];
+}
+
+int VersionTracker::GetNodeCount(int node_id) const {
+  int slot = Slot(node_id);
+  CHECK_NE(slot, -1) << "unknown node: " << node_id;
+  return counts_[slot * (max_version_ + 1) + node_version_[slot]];
+}
+
+int VersionTracker::GetMaxNodeVersion() const {
+  int ret = 0;
+  for (int v : node_version_) {
+    ret = std::max(ret, v);
+  }
+  return ret;
+}
+
+std::map<int, std::pair<int, VersionTracker::Timepoint>> VersionTracker::GetNodeVersions() const {
+  std::map<int, std::pair<int, Timepoint>> ret;
+  for (int slot = 0; slot < node_ids_.size(); ++ slot) {
+    ret[node_ids_[slot]] = {node_version_[slot], node_time_[slot]};
+  }
+  return ret;
+}
+
+std::string VersionTracker::DebugString() const {
+  std::stringstream ss;
+  ss << "part_versions: ";
+  for (int part_id = 0; part_id < part_version_.size(); ++ part_id) {
+    ss << part_id << ": " << part_version_[part_id] << ", ";
+  }
+  ss << "\nnode_versions: ";
+  for (int slot = 0; slot < node_ids_.size(); ++ slot) {
+    ss << node_ids_[slot] << ": " << node_version_[slot] << ", ";
+  }
+  ss << "\nnode_count: ";
+  for (int node_id : node_ids_) {
+    ss << node_id << ": " << GetNodeCount(node_id) << ", ";
+  }
+  return ss.str();
+}
+
+int VersionTracker::Slot(int node_id) const {
+  if (node_id < 0 || node_id >= node_slot_.size()) {
+    return -1;
+  }
+  return node_slot_[node_id];
+}
+
+int VersionTracker::AddNode(int node_id, Timepoint t) {
+  CHECK_GE(node_id, 0);
+  CHECK_EQ(Slot(node_id), -1) << "node " << node_id << " already exists";
+  if (node_id >= node_slot_.size()) {
+    node_slot_.resize(node_id + 1, -1);
+  }
+  const int slot = node_ids_.size();
+  node_slot_[node_id] = slot;
+  node_ids_.push_back(node_id);
+  node_version_.push_back(0);
+  node_time_.push_back(t);
+  node_num_parts_.push_back(0);
+  counts_.resize(counts_.size() + max_version_ + 1, 0);
+  return slot;
+}
+
+void VersionTracker::Add(int slot, int version) {
+  counts_[slot * (max_version_ + 1) + version] += 1;
+  node_num_parts_[slot] += 1;
+  if (node_num_parts_[slot] == 1 || version < node_version_[slot]) {
+    node_version_[slot] = version;
+  }
+}
+
+void VersionTracker::Remove(int slot, int version, Timepoint t) {
+  CHECK_GT(counts_[slot * (max_version_ + 1) + version], 0);
+  counts_[slot * (max_version_ + 1) + version] -= 1;
+  node_num_parts_[slot] -= 1;
+  if (version == node_version_[slot]) {
+    Advance(slot, t);
+  }
+}
+
+bool VersionTracker::Advance(int slot, Timepoint t) {
+  if (node_num_parts_[slot] == 0) {
+    return false;
+  }
+  const int* counts = &counts_[slot * (max_version_ + 1)];
+  int v = node_version_[slot];
+  while (v < max_version_ && counts[v] == 0) {
+    v += 1;
+  }
+  if (v == node_version_[slot]) {
+    return false;
+  }
+  node_version_[slot] = v;
+  node_time_[slot] = t;
+  return true;
+}
+
+}  // namespace xyz
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace xyz {
+
+/*
+ * The versions of the partitions of a collection in a plan and the min
+ * version of each node.
+ *
+ * Everything is kept in flat arrays indexed by part_id and node_id, with
+ * the # parts at each version of each node, so that a version bump of a
+ * part costs O(1) amortized instead of scanning all the parts of its node.
+ */
+class VersionTracker {
+ public:
+  using Timepoint = std::chrono::system_clock::time_point;
+
+  // all the parts start at version 0, max_version is the last version
+  void Init(const std::vector<int>& node_ids, const std::vector<int>& part_to_node,
+          int max_version, Timepoint start_time);
+
+  // part_id finishes version - 1, return true if the min version of its node advances
+  bool Update(int part_id, int version, Timepoint t);
+  // move part_id to node to_id (migration, recovery), keeping its version
+  void Move(int part_id, int to_id, Timepoint t);
+  // reset the version of part_id, e.g. to rerun it
+  void SetPartVersion(int part_id, int version, Timepoint t);
+
+  int GetNumParts() const { return part_version_.size(); }
+  int GetPartVersion(int part_id) const;
+  Timepoint GetPartTime(int part_id) const;
+  int GetPartNode(int part_id) const;
+
+  const std::vector<int>& GetNodeIds() const { return node_ids_; }
+  int GetNodeVersion(int node_id) const;
+  Timepoint GetNodeTime(int node_id) const;
+  // # parts of the node at its min version, 0 if the node has no part
+  int GetNodeCount(int node_id) const;
+  int GetMaxNodeVersion() const;
+  // node_id -> {version, time}
+  std::map<int, std::pair<int, Timepoint>> GetNodeVersions() const;
+
+  std::string DebugString() const;
+
+ private:
+  int Slot(int node_id) const;
+  int AddNode(int node_id, Timepoint t);
+  void Add(int slot, int version);
+  void Remove(int slot, int version, Timepoint t);
+  // advance the min version of the node to the min version of its parts
+  bool Advance(int slot, Timepoint t);
+
+  int max_version_ = 0;
+  // part_id ->
+  std::vector<int> part_version_;
+  std::vector<Timepoint> part_time_;
+  std::vector<int> part_node_;  // slot
+
+  // node_id -> slot, -1 if not tracked
+  std::vector<int> node_slot_;
+  // slot ->
+  std::vector<int> node_ids_;
+  std::vector<int> node_version_;
+  std::vector<Timepoint> node_time_;
+  std::vector<int> node_num_parts_;
+  // slot * (max_version_ + 1) + version -> # parts
+  std::vector<int> counts_;
+};
+
+}  // namespace xyz
@@ -0,0 +1,72 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/scheduler/version_tracker.hpp"
+
+namespace xyz {
+namespace {
+
+class TestVersionTracker : public testing::Test {};
+
+using Timepoint = VersionTracker::Timepoint;
+
+TEST_F(TestVersionTracker, Update) {
+  VersionTracker tracker;
+  // node 1: part 0, 2; node 2: part 1
+  tracker.Init({1, 2}, {1, 2, 1}, 3, Timepoint());
+  EXPECT_EQ(tracker.GetNumParts(), 3);
+  EXPECT_EQ(tracker.GetNodeCount(1), 2);
+  EXPECT_EQ(tracker.GetNodeCount(2), 1);
+
+  auto t = Timepoint() + std::chrono::seconds(1);
+  EXPECT_FALSE(tracker.Update(0, 1, t));
+  EXPECT_EQ(tracker.GetNodeVersion(1), 0);
+  EXPECT_EQ(tracker.GetNodeCount(1), 1);
+  EXPECT_FALSE(tracker.Update(0, 2, t));
+  // the min version of node 1 jumps to the version of part 2
+  EXPECT_TRUE(tracker.Update(2, 1, t));
+  EXPECT_EQ(tracker.GetNodeVersion(1), 1);
+  EXPECT_EQ(tracker.GetNodeCount(1), 1);
+  EXPECT_EQ(tracker.GetNodeTime(1), t);
+  EXPECT_EQ(tracker.GetPartVersion(0), 2);
+  EXPECT_EQ(tracker.GetPartTime(0), t);
+  EXPECT_EQ(tracker.GetMaxNodeVersion(), 1);
+}
+
+TEST_F(TestVersionTracker, Move) {
+  VersionTracker tracker;
+  tracker.Init({1, 2}, {1, 2, 1}, 3, Timepoint());
+  tracker.Update(0, 1, Timepoint());
+  // move the slow part away from node 1
+  tracker.Move(2, 2, Timepoint());
+  EXPECT_EQ(tracker.GetPartNode(2), 2);
+  EXPECT_EQ(tracker.GetNodeVersion(1), 1);
+  EXPECT_EQ(tracker.GetNodeCount(1), 1);
+  EXPECT_EQ(tracker.GetNodeVersion(2), 0);
+  EXPECT_EQ(tracker.GetNodeCount(2), 2);
+
+  // to a new node
+  tracker.Move(0, 3, Timepoint());
+  EXPECT_EQ(tracker.GetNodeCount(1), 0);
+  EXPECT_EQ(tracker.GetNodeVersion(3), 1);
+  EXPECT_EQ(tracker.GetNodeCount(3), 1);
+  EXPECT_EQ(tracker.GetNodeVersions().size(), 3);
+}
+
+TEST_F(TestVersionTracker, SetPartVersion) {
+  VersionTracker tracker;
+  tracker.Init({1}, {1, 1}, 3, Timepoint());
+  tracker.Update(0, 1, Timepoint());
+  EXPECT_TRUE(tracker.Update(1, 1, Timepoint()));
+  tracker.Update(0, 2, Timepoint());
+  EXPECT_EQ(tracker.GetNodeVersion(1), 1);
+  tracker.SetPartVersion(1, 0, Timepoint());
+  EXPECT_EQ(tracker.GetNodeVersion(1), 0);
+  EXPECT_EQ(tracker.GetNodeCount(1), 1);
+  tracker.SetPartVersion(1, 2, Timepoint());
+  EXPECT_EQ(tracker.GetNodeVersion(1), 2);
+  EXPECT_EQ(tracker.GetNodeCount(1), 2);
+}
+
+}  // namespace
+}  // namespace xyz
@@ -2,8 +2,11 @@
 #include "core/plan/collection_spec.hpp"
 #include "core/queue_node_map.hpp"
 #include "core/shuffle_meta.hpp"
+#include "core/scheduler/checkpoint_io.hpp"
 #include "io/meta.hpp"
 
+#include <algorithm>
+
 #include "core/plan/spec_wrapper.hpp"
 
 #include "core/partition/block_partition.hpp"
@@ -47,6 +50,10 @@ void Worker::Process(Message msg) {
     UpdateCollection(bin);
     break;
   }
+  case ScheduleFlag::kReleaseCollection: {
+    ReleaseCollection(bin);
+    break;
+  }
   case ScheduleFlag::kLoadBlock: {
     LoadBlock(bin);
     break;
@@ -92,6 +99,17 @@ void Worker::UpdateCollection(SArrayBinStream bin) {
   SendMsgToScheduler(ScheduleFlag::kUpdateCollectionReply, reply_bin);
 }
 
+void Worker::ReleaseCollection(SArrayBinStream bin) {
+  int collection_id;
+  bin >> collection_id;
+  auto parts = engine_elem_.partition_manager->Get(collection_id);
+  for (auto& part : parts) {
+    engine_elem_.partition_manager->Remove(collection_id, part->id);
+  }
+  LOG(INFO) << WorkerId() << "release collection " << collection_id
+      << ", " << parts.size() << " partitions removed";
+}
+
 void Worker::RunDummy() { LOG(INFO) << WorkerId() << "RunDummy"; }
 
 void Worker::LoadBlock(SArrayBinStream bin) {
@@ -181,43 +199,55 @@ void Worker::CheckPoint(SArrayBinStream bin) {
 
   engine_elem_.executor->Add([this, collection_id, part_id, dest_url]() {
     // 1. write
-    auto writer = io_wrapper_->GetWriter();
     CHECK(engine_elem_.partition_manager->Has(collection_id, part_id));
     auto part = engine_elem_.partition_manager->Get(collection_id, part_id);
 
     SArrayBinStream bin;
     part->ToBin(bin);
-    bool rc = writer->Write(dest_url, bin.GetPtr(), bin.Size());
-    CHECK_EQ(rc, 0);
-
-    // 2. reply
-    SArrayBinStream reply_bin;
-    reply_bin << Qid() << collection_id;
-    SendMsgToScheduler(ScheduleFlag::kFinishCheckpoint, reply_bin);
+    // 2. reply once it is in the shared store
+    CHECK_NOTNULL(engine_elem_.checkpoint_io);
+    engine_elem_.checkpoint_io->Write(dest_url, bin, [this, collection_id]() {
+      SArrayBinStream reply_bin;
+      reply_bin << Qid() << collection_id;
+      SendMsgToScheduler(ScheduleFlag::kFinishCheckpoint, reply_bin);
+    });
   });
 }
 
 void Worker::LoadCheckPoint(SArrayBinStream bin) {
   int collection_id, part_id;
   std::string dest_url;
-  bin >> collection_id >> part_id >> dest_url;
-
-  engine_elem_.executor->Add([this, collection_id, part_id, dest_url]() {
-    // 1. read
-    auto reader = io_wrapper_->GetReader();
-    reader->Init(dest_url);
-    size_t file_size = reader->GetFileSize();
-    CHECK_NE(file_size, 0);
-    // LOG(INFO) << "file_size: " << std::to_string(file_size);
-    
-    SArrayBinStream bin;
-    bin.Resize(file_size);
-    reader->Read(bin.GetBegin(), file_size);
-
-    // 2. construct partition and insert
+  std::vector<std::string> delta_urls;
+  // written by this node, may be read from the local copy
+  std::vector<std::string> local_urls;
+  bin >> collection_id >> part_id >> dest_url >> delta_urls >> local_urls;
+
+  engine_elem_.executor->Add([this, collection_id, part_id, dest_url, delta_urls, local_urls]() {
+    CHECK_NOTNULL(engine_elem_.checkpoint_io);
+    auto read = [this, &local_urls](std::string url) {
+      bool prefer_local = std::find(local_urls.begin(), local_urls.end(), url) != local_urls.end();
+      return engine_elem_.checkpoint_io->Read(url, prefer_local);
+    };
+    // 1. read and construct the partition
     auto get_func = engine_elem_.function_store->GetCreatePart(collection_id);
     auto p = get_func();
+    SArrayBinStream bin = read(dest_url);
+    CHECK_NE(bin.Size(), 0) << dest_url;
     p->FromBin(bin);
+
+    // 2. replay the deltas, each one may be a full image
+    // see PlanController::WriteCheckpoint
+    for (auto& delta_url : delta_urls) {
+      SArrayBinStream delta_bin = read(delta_url);
+      bool is_delta;
+      delta_bin >> is_delta;
+      if (is_delta) {
+        p->FromDeltaBin(delta_bin);
+      } else {
+        p = get_func();
+        p->FromBin(delta_bin);
+      }
+    }
     engine_elem_.partition_manager->Insert(collection_id, part_id, std::move(p));
 
     // 3. reply
@@ -257,6 +287,7 @@ void Worker::SendMsgToScheduler(ScheduleFlag flag, SArrayBinStream bin) {
   msg.meta.sender = GetWorkerQid(engine_elem_.node.id);
   msg.meta.recver = 0;
   msg.meta.flag = Flag::kOthers;
+  msg.meta.traffic_class = TrafficClass::kControl;
   SArrayBinStream ctrl_bin;
   ctrl_bin << flag;
   msg.AddData(ctrl_bin.ToSArray());
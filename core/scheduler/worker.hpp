@@ -51,6 +51,7 @@ public:
   void StartCluster();
 
   void UpdateCollection(SArrayBinStream bin);
+  void ReleaseCollection(SArrayBinStream bin);
 
   void RunDummy();
 
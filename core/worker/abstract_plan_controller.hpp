@@ -21,8 +21,20 @@ struct AbstractPlanController {
   virtual void FinishLoadWith(SArrayBinStream bin) = 0;
 
   virtual void ReassignMap(SArrayBinStream bin) = 0;
+  virtual void RecoverParts(SArrayBinStream bin) = 0;
+
+  virtual void ReceiveCredit(SArrayBinStream bin) = 0;
+
+  virtual void ReadyParts(SArrayBinStream bin) = 0;
+
+  // send the batched progress reports to the scheduler
+  virtual void FlushReports() = 0;
 
   virtual void DisplayTime() = 0;
+  // the join message bytes sent to this node and to the other nodes
+  virtual void DisplayShuffleBytes() = 0;
+  virtual size_t GetLocalShuffleBytes() = 0;
+  virtual size_t GetRemoteShuffleBytes() = 0;
 };
 
 }  // namespace xyz
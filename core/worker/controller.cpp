@@ -1,5 +1,8 @@
 #include "core/worker/controller.hpp"
 
+#include <algorithm>
+#include <sstream>
+
 #include "core/scheduler/control.hpp"
 
 #include "core/worker/plan_controller.hpp"
@@ -20,6 +23,13 @@ void Controller::Process(Message msg) {
   plan_bin >> plan_id;
 
   // LOG(INFO) << "flag: " << static_cast<int>(flag);
+  if (flag == ControllerFlag::kFlushReports) {
+    flush_queued_.store(false);
+    for (auto& kv : plan_controllers_) {
+      kv.second->FlushReports();
+    }
+    return;
+  }
   if (flag != ControllerFlag::kSetup) {
     // CHECK(plan_controllers_.find(plan_id) != plan_controllers_.end());
     if (plan_controllers_.find(plan_id) == plan_controllers_.end()) {
@@ -35,6 +45,25 @@ void Controller::Process(Message msg) {
     if (plan_timer_.find(plan_id) == plan_timer_.end()) {
       plan_timer_[plan_id].start_time = std::chrono::steady_clock::now();
     }
+    plan_timer_[plan_id].max_queue_depth = std::max(plan_timer_[plan_id].max_queue_depth,
+            GetWorkQueue()->Size());
+  }
+
+  if (!shards_.empty()) {
+    const int part_id = GetShardPartId(flag, msg);
+    if (part_id != -1) {
+      auto& shard = shards_[part_id % shards_.size()];
+      auto& depths = plan_timer_[plan_id].max_shard_queue_depths;
+      depths.resize(shards_.size(), 0);
+      depths[shard->GetShard()] = std::max(depths[shard->GetShard()], shard->GetQueueDepth() + 1);
+      shard->Add(std::move(msg));
+      return;
+    }
+    // the joins received before must be handled before the part is
+    // migrated or restarted, e.g. not buffered after its state is sent away
+    if (flag == ControllerFlag::kMigratePartition || flag == ControllerFlag::kRecoverParts) {
+      WaitShardsIdle();
+    }
   }
   auto start_time = std::chrono::steady_clock::now();
 
@@ -91,6 +120,18 @@ void Controller::Process(Message msg) {
     plan_controllers_[plan_id]->ReassignMap(bin);
     break;                                      
   }
+  case ControllerFlag::kRecoverParts: {
+    plan_controllers_[plan_id]->RecoverParts(bin);
+    break;
+  }
+  case ControllerFlag::kGrantCredit: {
+    plan_controllers_[plan_id]->ReceiveCredit(bin);
+    break;
+  }
+  case ControllerFlag::kReadyParts: {
+    plan_controllers_[plan_id]->ReadyParts(bin);
+    break;
+  }
   default: CHECK(false);
   }
 
@@ -102,18 +143,109 @@ void Controller::Process(Message msg) {
       plan_timer_[plan_id].plan_time += std::chrono::duration_cast<std::chrono::microseconds>(end_time - plan_timer_[plan_id].start_time);
       LOG(INFO) << "[Controller] plan " << plan_id 
         << " plan time(ms): " << plan_timer_[plan_id].plan_time.count()/1000
-        << " control time(ms): " << plan_timer_[plan_id].control_time.count()/1000;
+        << " control time(ms): " << plan_timer_[plan_id].control_time.count()/1000
+        << " max queue depth: " << plan_timer_[plan_id].max_queue_depth;
+      for (int i = 0; i < plan_timer_[plan_id].max_shard_queue_depths.size(); ++ i) {
+        LOG(INFO) << "[Controller] plan " << plan_id << " shard " << i
+          << " max queue depth: " << plan_timer_[plan_id].max_shard_queue_depths[i];
+      }
     }
   }
 }
 
+int Controller::GetShardPartId(ControllerFlag flag, const Message& msg) {
+  SArrayBinStream bin;
+  switch (flag) {
+  case ControllerFlag::kReceiveJoin: {
+    PlanController::VersionedShuffleMeta meta;
+    bin.FromSArray(msg.data[2]);
+    bin >> meta;
+    return meta.part_id;
+  }
+  case ControllerFlag::kFetchRequest: {
+    FetchMeta meta;
+    bin.FromSArray(msg.data[1]);
+    bin >> meta;
+    return meta.partition_id;
+  }
+  case ControllerFlag::kFinishJoin:
+  case ControllerFlag::kFinishFetch: {
+    int part_id;
+    bin.FromSArray(msg.data[2]);
+    bin >> part_id;
+    return part_id;
+  }
+  default: return -1;
+  }
+}
+
+void Controller::ProcessShard(Message msg) {
+  SArrayBinStream ctrl_bin, plan_bin, bin;
+  ctrl_bin.FromSArray(msg.data[0]);
+  plan_bin.FromSArray(msg.data[1]);
+  bin.FromSArray(msg.data[2]);
+  ControllerFlag flag;
+  ctrl_bin >> flag;
+  int plan_id;
+  plan_bin >> plan_id;
+
+  // the plan may be terminated after the message is forwarded
+  boost::shared_lock<boost::shared_mutex> lk(erase_mu_);
+  auto it = plan_controllers_.find(plan_id);
+  if (it == plan_controllers_.end()) {
+    LOG(INFO) << RED("[Controller::ProcessShard] Ignoring message ControllerFlag: " + 
+        ControllerFlagName[static_cast<int>(flag)] +
+        " for plan: " + std::to_string(plan_id))
+      << " meta: " << msg.meta.DebugString();
+    return;
+  }
+  switch (flag) {
+  case ControllerFlag::kFinishJoin: {
+    it->second->FinishJoin(bin);
+    break;
+  }
+  case ControllerFlag::kReceiveJoin: {
+    it->second->ReceiveJoin(msg);
+    break;
+  }
+  case ControllerFlag::kFetchRequest: {
+    it->second->ReceiveFetchRequest(msg);
+    break;
+  }
+  case ControllerFlag::kFinishFetch: {
+    it->second->FinishFetch(bin);
+    break;  
+  }
+  default: CHECK(false);
+  }
+}
+
+void Controller::WaitShardsIdle() {
+  for (auto& shard : shards_) {
+    while (!shard->IsIdle()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+}
+
+std::vector<int> Controller::GetShardQueueDepths() {
+  std::vector<int> depths;
+  for (auto& shard : shards_) {
+    depths.push_back(shard->GetQueueDepth());
+  }
+  return depths;
+}
+
 void Controller::Setup(SArrayBinStream bin) {
   SpecWrapper spec;
   bin >> spec;
 
   int plan_id = spec.id;
   auto plan_controller = std::make_shared<PlanController>(this);
-  plan_controllers_.insert({plan_id, plan_controller});
+  {
+    boost::unique_lock<boost::shared_mutex> lk(erase_mu_);
+    plan_controllers_.insert({plan_id, plan_controller});
+  }
   plan_controllers_[plan_id]->Setup(spec);
 }
 
@@ -128,6 +260,10 @@ void Controller::TerminatePlan(int plan_id) {
   erased[plan_id] = true;
   LOG(INFO) << "[Controller] Terminating plan " << plan_id << " on node: " << engine_elem_.node.id;
   // plan_controllers_[plan_id]->DisplayTime();
+  plan_controllers_[plan_id]->FlushReports();
+  plan_controllers_[plan_id]->DisplayShuffleBytes();
+  const size_t local_shuffle_bytes = plan_controllers_[plan_id]->GetLocalShuffleBytes();
+  const size_t remote_shuffle_bytes = plan_controllers_[plan_id]->GetRemoteShuffleBytes();
   plan_controllers_.erase(plan_id);
   LOG(INFO) << "[Controller] Done terminating plan " << plan_id << " on node: " << engine_elem_.node.id;
   /*
@@ -144,15 +280,66 @@ void Controller::TerminatePlan(int plan_id) {
   ctrl.version = -1;
   ctrl.node_id = engine_elem_.node.id;
   ctrl.plan_id = plan_id;
+  ctrl.local_shuffle_bytes = local_shuffle_bytes;
+  ctrl.remote_shuffle_bytes = remote_shuffle_bytes;
   bin << ctrl;
   SendMsgToScheduler(bin);
 }
 
+// Ask the controller thread to flush the partial report batches
+// as the batch may not fill up when few parts are running.
+// Nothing is pushed when no report is pending, e.g. no plan is running.
+void Controller::FlushTicker() {
+  while (!finished_.load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(engine_elem_.report_flush_ms));
+    if (num_pending_reports_.load() == 0 || flush_queued_.exchange(true)) {
+      continue;
+    }
+    Message msg;
+    msg.meta.sender = Qid();
+    msg.meta.recver = Qid();
+    msg.meta.flag = Flag::kOthers;
+    SArrayBinStream ctrl_bin, plan_bin, bin;
+    ctrl_bin << ControllerFlag::kFlushReports;
+    plan_bin << -1;
+    msg.AddData(ctrl_bin.ToSArray());
+    msg.AddData(plan_bin.ToSArray());
+    msg.AddData(bin.ToSArray());
+    GetWorkQueue()->Push(msg);
+  }
+}
+
+void ControllerShard::Add(Message msg) {
+  num_pending_ += 1;
+  GetWorkQueue()->Push(std::move(msg));
+}
+
+void ControllerShard::Process(Message msg) {
+  int depth = GetWorkQueue()->Size();
+  if (depth > max_queue_depth_.load()) {
+    max_queue_depth_.store(depth);
+  }
+  controller_->ProcessShard(std::move(msg));
+  num_processed_ += 1;
+  num_pending_ -= 1;
+}
+
+std::string ControllerShard::DebugString() {
+  std::stringstream ss;
+  ss << "{ shard: " << shard_;
+  ss << ", queue depth: " << GetQueueDepth();
+  ss << ", max queue depth: " << GetMaxQueueDepth();
+  ss << ", processed: " << GetNumProcessed();
+  ss << " }";
+  return ss.str();
+}
+
 void Controller::SendMsgToScheduler(SArrayBinStream bin) {
   Message msg;
   msg.meta.sender = Qid();
   msg.meta.recver = 0;
   msg.meta.flag = Flag::kOthers;
+  msg.meta.traffic_class = TrafficClass::kControl;
   SArrayBinStream ctrl_bin;
   ctrl_bin << ScheduleFlag::kControl;
   msg.AddData(ctrl_bin.ToSArray());
@@ -1,47 +1,133 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "base/actor.hpp"
 #include "core/worker/abstract_plan_controller.hpp"
 #include "core/engine_elem.hpp"
+#include "core/scheduler/control.hpp"
 #include "io/io_wrapper.hpp"
 
+#include "glog/logging.h"
+
 #include <boost/thread/locks.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
 namespace xyz {
 
+class Controller;
+
+/*
+ * Runs the join and fetch handlers of the plans (kReceiveJoin, kFinishJoin,
+ * kFetchRequest and kFinishFetch) of the parts with
+ * part_id % num_controller_shards == shard, so that the joins of
+ * different parts are dispatched in parallel. It has no queue in the
+ * mailbox, the Controller forwards the messages to it (see Controller::Process).
+ */
+class ControllerShard : public Actor {
+ public:
+  ControllerShard(int qid, int shard, Controller* controller)
+      : Actor(qid), shard_(shard), controller_(controller) {
+    Start();
+  }
+  virtual ~ControllerShard() override {
+    Stop();
+  }
+
+  virtual void Process(Message msg) override;
+
+  // called by the controller thread
+  void Add(Message msg);
+  // all the messages added are processed
+  bool IsIdle() const { return num_pending_.load() == 0; }
+
+  int GetShard() const { return shard_; }
+  int GetQueueDepth() { return GetWorkQueue()->Size(); }
+  int GetMaxQueueDepth() const { return max_queue_depth_.load(); }
+  int GetNumProcessed() const { return num_processed_.load(); }
+  std::string DebugString();
+
+ private:
+  int shard_;
+  Controller* controller_;
+  std::atomic<int> num_pending_{0};
+  std::atomic<int> max_queue_depth_{0};
+  std::atomic<int> num_processed_{0};
+};
+
 class Controller : public Actor {
  public:
   Controller(int qid, EngineElem engine_elem, std::shared_ptr<IOWrapper> io_wrapper)
       : Actor(qid), engine_elem_(engine_elem), 
       io_wrapper_(io_wrapper) {
+    CHECK_GT(engine_elem_.num_controller_shards, 0);
+    if (engine_elem_.num_controller_shards > 1) {
+      for (int i = 0; i < engine_elem_.num_controller_shards; ++ i) {
+        shards_.emplace_back(new ControllerShard(qid, i, this));
+      }
+    }
     Start();
+    if (engine_elem_.report_batch_size > 1) {
+      flush_thread_ = std::thread([this]() { FlushTicker(); });
+    }
   }
 
   virtual ~Controller() override {
+    finished_.store(true);
+    if (flush_thread_.joinable()) {
+      flush_thread_.join();
+    }
     Stop();
+    shards_.clear();
   }
 
   virtual void Process(Message msg) override;
+  // the join and fetch messages, in the controller shards
+  void ProcessShard(Message msg);
+  // the part of the messages run in the controller shards, -1 for the others
+  static int GetShardPartId(ControllerFlag flag, const Message& msg);
+  // wait until the controller shards process the messages forwarded to them
+  void WaitShardsIdle();
+
+  const std::vector<std::unique_ptr<ControllerShard>>& GetShards() const { return shards_; }
+  // the # messages waiting in each controller shard, empty if not sharded
+  std::vector<int> GetShardQueueDepths();
 
   void Setup(SArrayBinStream bin);
   void TerminatePlan(int plan_id);
   void SendMsgToScheduler(SArrayBinStream bin);
+  void FlushTicker();
 
   std::shared_ptr<IOWrapper> io_wrapper_;
   EngineElem engine_elem_;
   std::map<int, std::shared_ptr<AbstractPlanController>> plan_controllers_;
   std::map<int, bool> erased;
+  // the controller shards read plan_controllers_ with it locked shared
   boost::shared_mutex erase_mu_;
+  std::vector<std::unique_ptr<ControllerShard>> shards_;
 
   struct Timer {
     std::chrono::microseconds plan_time{0};
     std::chrono::microseconds control_time{0};
+    // the max # messages waiting in the controller queue
+    int max_queue_depth = 0;
+    // and in each controller shard
+    std::vector<int> max_shard_queue_depths;
     std::chrono::time_point<std::chrono::steady_clock> start_time;
   };
   std::map<int, Timer> plan_timer_;
+
+  std::thread flush_thread_;
+  std::atomic<bool> finished_{false};
+  // # reports buffered by the plan controllers, the ticker only runs when it is > 0
+  std::atomic<int> num_pending_reports_{0};
+  // at most one kFlushReports in the queue
+  std::atomic<bool> flush_queued_{false};
 };
 
 }  // namespace xyz
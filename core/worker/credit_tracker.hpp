@@ -0,0 +1,104 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+/*
+ * Sender side of the credit-based flow control between map producers and
+ * remote joiners.
+ *
+ * Every join message sent to a remote node consumes one credit of that
+ * node, and the receiving controller grants it back once the join has
+ * been applied. A node whose credits are used up is exhausted and the
+ * PlanController stops running maps ahead of the min version until it
+ * gets credits back, so that the outstanding join messages (and thus the
+ * memory in the receivers' queues) stay bounded.
+ *
+ * credits_per_node <= 0 disables the flow control.
+ *
+ * Consume is called from the combiner threads while the controller thread
+ * checks HasCredit, so it is thread-safe.
+ */
+class CreditTracker {
+ public:
+  explicit CreditTracker(int credits_per_node = 0)
+      : credits_per_node_(credits_per_node) {}
+
+  bool Enabled() const { return credits_per_node_ > 0; }
+
+  void Consume(int node_id) {
+    if (!Enabled()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lk(mu_);
+    int& outstanding = outstanding_[node_id];
+    outstanding += 1;
+    if (outstanding == credits_per_node_) {
+      num_exhausted_ += 1;
+    }
+  }
+
+  // A grant may be stale, e.g. sent by the receiver for a previous run of
+  // the plan and overtaking the other msgs on the control lane, it is
+  // clamped to the credits consumed.
+  void Grant(int node_id, int num_credits) {
+    if (!Enabled()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lk(mu_);
+    int& outstanding = outstanding_[node_id];
+    if (num_credits > outstanding) {
+      LOG(WARNING) << "node " << node_id << " grants " << num_credits
+          << " credits but only " << outstanding << " are consumed, a stale grant?";
+      num_credits = outstanding;
+    }
+    bool was_exhausted = outstanding >= credits_per_node_;
+    outstanding -= num_credits;
+    if (was_exhausted && outstanding < credits_per_node_) {
+      num_exhausted_ -= 1;
+    }
+  }
+
+  // the node is dead, its credits will not come back
+  void Remove(int node_id) {
+    if (!Enabled()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = outstanding_.find(node_id);
+    if (it == outstanding_.end()) {
+      return;
+    }
+    if (it->second >= credits_per_node_) {
+      num_exhausted_ -= 1;
+    }
+    outstanding_.erase(it);
+  }
+
+  // whether no node is exhausted
+  bool HasCredit() {
+    if (!Enabled()) {
+      return true;
+    }
+    std::lock_guard<std::mutex> lk(mu_);
+    return num_exhausted_ == 0;
+  }
+
+  int GetNumCredits(int node_id) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return credits_per_node_ - outstanding_[node_id];
+  }
+
+ private:
+  const int credits_per_node_;
+  std::mutex mu_;
+  // node_id -> # join messages sent but not yet granted back
+  std::unordered_map<int, int> outstanding_;
+  int num_exhausted_ = 0;
+};
+
+}  // namespace xyz
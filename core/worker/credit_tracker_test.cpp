@@ -0,0 +1,76 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/worker/credit_tracker.hpp"
+
+namespace xyz {
+namespace {
+
+class TestCreditTracker : public testing::Test {};
+
+TEST_F(TestCreditTracker, Disabled) {
+  CreditTracker tracker(0);
+  EXPECT_FALSE(tracker.Enabled());
+  for (int i = 0; i < 10; ++i) {
+    tracker.Consume(1);
+  }
+  EXPECT_TRUE(tracker.HasCredit());
+}
+
+TEST_F(TestCreditTracker, ConsumeGrant) {
+  CreditTracker tracker(2);
+  EXPECT_TRUE(tracker.Enabled());
+  EXPECT_EQ(tracker.GetNumCredits(1), 2);
+  tracker.Consume(1);
+  EXPECT_TRUE(tracker.HasCredit());
+  tracker.Consume(2);
+  tracker.Consume(1);
+  EXPECT_EQ(tracker.GetNumCredits(1), 0);
+  EXPECT_FALSE(tracker.HasCredit());
+  // consuming beyond the credits is allowed, the node stays exhausted
+  tracker.Consume(1);
+  tracker.Grant(1, 1);
+  EXPECT_FALSE(tracker.HasCredit());
+  tracker.Grant(1, 1);
+  EXPECT_TRUE(tracker.HasCredit());
+  EXPECT_EQ(tracker.GetNumCredits(1), 1);
+  EXPECT_EQ(tracker.GetNumCredits(2), 1);
+}
+
+TEST_F(TestCreditTracker, StaleGrant) {
+  CreditTracker tracker(1);
+  // from a previous run, nothing is consumed
+  tracker.Grant(1, 1);
+  EXPECT_EQ(tracker.GetNumCredits(1), 1);
+  tracker.Consume(1);
+  EXPECT_FALSE(tracker.HasCredit());
+  tracker.Grant(1, 2);
+  EXPECT_TRUE(tracker.HasCredit());
+  EXPECT_EQ(tracker.GetNumCredits(1), 1);
+}
+
+TEST_F(TestCreditTracker, MultipleNodesExhausted) {
+  CreditTracker tracker(1);
+  tracker.Consume(1);
+  tracker.Consume(2);
+  EXPECT_FALSE(tracker.HasCredit());
+  tracker.Grant(1, 1);
+  EXPECT_FALSE(tracker.HasCredit());
+  tracker.Grant(2, 1);
+  EXPECT_TRUE(tracker.HasCredit());
+}
+
+TEST_F(TestCreditTracker, RemoveDeadNode) {
+  CreditTracker tracker(1);
+  tracker.Consume(1);
+  tracker.Consume(2);
+  tracker.Remove(1);
+  EXPECT_FALSE(tracker.HasCredit());
+  tracker.Remove(2);
+  EXPECT_TRUE(tracker.HasCredit());
+  tracker.Remove(3);
+  EXPECT_TRUE(tracker.HasCredit());
+}
+
+} // namespace
+} // namespace xyz
@@ -5,9 +5,14 @@
 
 namespace xyz {
 
-DelayedCombiner::DelayedCombiner(PlanController* plan_controller, int combine_timeout)
-  : plan_controller_(plan_controller), combine_timeout_(combine_timeout) {
+DelayedCombiner::DelayedCombiner(PlanController* plan_controller, int combine_timeout,
+        int num_log_versions)
+  : plan_controller_(plan_controller), combine_timeout_(combine_timeout),
+    num_log_versions_(num_log_versions) {
   store_.resize(plan_controller_->num_update_part_);
+  if (num_log_versions_ > 0) {
+    message_log_.reset(new MessageLog());
+  }
   if (combine_timeout_ > 0 && combine_timeout_ <= kMaxCombineTimeout) {
     detect_thread_ = std::thread([this]() {
       PeriodicCombine();
@@ -111,6 +116,9 @@ void DelayedCombiner::PrepareMsgAndSend(int part_id, int version,
   // the whole sending part. 
   // Another way is to use something like double-checked locking.
   auto bin = stream->Serialize();
+  if (message_log_) {
+    message_log_->Add(part_id, version, upstream_part_ids, bin);
+  }
 
   std::lock_guard<std::mutex> lk(plan_controller_->migrate_mu_);
   // the below comment is to test whether the unnecessary serialization for
@@ -139,6 +147,14 @@ void DelayedCombiner::PrepareMsgAndSend(int part_id, int version,
   meta.part_id = part_id;
   meta.version = version;
   meta.local_mode = (msg.meta.recver == msg.meta.sender);
+  if (meta.local_mode) {
+    plan_controller_->local_shuffle_bytes_ += bin.Size();
+  } else {
+    plan_controller_->remote_shuffle_bytes_ += bin.Size();
+  }
+  // for the receiver to grant the credit back
+  meta.sender = msg.meta.sender;
+  meta.recver = msg.meta.recver;
 
   SArrayBinStream ctrl_bin, plan_bin, ctrl2_bin;
   ctrl_bin << ControllerFlag::kReceiveJoin;
@@ -156,8 +172,59 @@ void DelayedCombiner::PrepareMsgAndSend(int part_id, int version,
     plan_controller_->controller_->GetWorkQueue()->Push(msg);
   } else {
     msg.AddData(bin.ToSArray());
+    if (GetNodeId(msg.meta.recver) != plan_controller_->controller_->engine_elem_.node.id) {
+      plan_controller_->credit_tracker_->Consume(GetNodeId(msg.meta.recver));
+    }
+    plan_controller_->controller_->engine_elem_.intermediate_store->Add(msg);
+  }
+}
+
+void DelayedCombiner::TrimLog(int min_version) {
+  if (message_log_) {
+    message_log_->EraseBefore(min_version - num_log_versions_);
+  }
+}
+
+// The replayed messages are not in local mode (the stream_store_ does not
+// keep the streams), the receiver drops the ones joined already.
+int DelayedCombiner::ReplayLog(int part_id, int from_version) {
+  CHECK(message_log_) << "the message log is disabled";
+  CHECK_LE(message_log_->GetTrimVersion(), from_version)
+    << "the messages of version " << from_version << " are dropped";
+  auto entries = message_log_->Get(part_id, from_version);
+  std::lock_guard<std::mutex> lk(plan_controller_->migrate_mu_);
+  for (auto& e : entries) {
+    Message msg;
+    msg.meta.sender = plan_controller_->controller_->Qid();
+    msg.meta.recver = GetControllerActorQid(plan_controller_->controller_->engine_elem_.
+            collection_map->Lookup(plan_controller_->update_collection_id_, part_id));
+    msg.meta.flag = Flag::kOthers;
+
+    PlanController::VersionedShuffleMeta meta;
+    meta.plan_id = plan_controller_->plan_id_;
+    meta.collection_id = plan_controller_->update_collection_id_;
+    meta.upstream_part_id = -1;
+    meta.ext_upstream_part_ids = e.upstream_part_ids;
+    meta.part_id = part_id;
+    meta.version = e.version;
+    meta.local_mode = false;
+    meta.sender = msg.meta.sender;
+    meta.recver = msg.meta.recver;
+
+    SArrayBinStream ctrl_bin, plan_bin, ctrl2_bin;
+    ctrl_bin << ControllerFlag::kReceiveJoin;
+    plan_bin << plan_controller_->plan_id_;
+    ctrl2_bin << meta;
+    msg.AddData(ctrl_bin.ToSArray());
+    msg.AddData(plan_bin.ToSArray());
+    msg.AddData(ctrl2_bin.ToSArray());
+    msg.AddData(e.bin.ToSArray());
+    if (GetNodeId(msg.meta.recver) != plan_controller_->controller_->engine_elem_.node.id) {
+      plan_controller_->credit_tracker_->Consume(GetNodeId(msg.meta.recver));
+    }
     plan_controller_->controller_->engine_elem_.intermediate_store->Add(msg);
   }
+  return entries.size();
 }
 
 }  // namespace xyz
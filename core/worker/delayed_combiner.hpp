@@ -4,8 +4,10 @@
 #include <chrono>
 #include <mutex>
 #include <atomic>
+#include <memory>
 
 #include "core/worker/plan_controller.hpp"
+#include "core/worker/message_log.hpp"
 
 #include "core/map_output/map_output_stream.hpp"
 #include "core/map_output/partitioned_map_output.hpp"
@@ -17,7 +19,10 @@ class DelayedCombiner {
  public:
   using StreamPair = std::pair<int, std::shared_ptr<AbstractMapOutputStream>>;
 
-  DelayedCombiner(PlanController* plan_controller, int combine_timeout);
+  // num_log_versions: the messages sent in the last num_log_versions
+  // versions are kept to be replayed, 0 to disable
+  DelayedCombiner(PlanController* plan_controller, int combine_timeout,
+          int num_log_versions = 0);
 
   ~DelayedCombiner() {
     finished_.store(true);
@@ -36,6 +41,13 @@ class DelayedCombiner {
   void PrepareMsgAndSend(int part_id, int version, 
         std::vector<int> upstream_part_ids, std::shared_ptr<AbstractMapOutputStream> stream);
 
+  // message log
+  // drop the messages not needed once the min version is min_version
+  void TrimLog(int min_version);
+  // send the logged messages to part_id of version >= from_version again
+  // to its owner, return the # messages
+  int ReplayLog(int part_id, int from_version);
+
   void Detect();
  private:
   std::thread detect_thread_;
@@ -52,6 +64,9 @@ class DelayedCombiner {
   // >kMaxCombineTimeout: shuffle combine
   const int combine_timeout_ = 0;
   std::atomic<bool> finished_{false};
+
+  const int num_log_versions_ = 0;
+  std::unique_ptr<MessageLog> message_log_;
 };
 
 }  // namespace xyz
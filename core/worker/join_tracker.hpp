@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "base/sarray_binstream.hpp"
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+/*
+ * The upstream (map) parts joined into one update part, per version.
+ *
+ * Each version is a bitset of num_upstream bits with the # bits set, so
+ * finding a duplicated join is a bit test and the version is complete
+ * once the count reaches num_upstream. Only the versions between the min
+ * version and the part's own version are kept, Erase drops the old ones.
+ */
+class JoinTracker {
+ public:
+  JoinTracker() = default;
+  explicit JoinTracker(int num_upstream) : num_upstream_(num_upstream) {}
+
+  // return false if upstream_part_id has been joined in this version
+  bool Add(int version, int upstream_part_id) {
+    CHECK_GE(upstream_part_id, 0);
+    CHECK_LT(upstream_part_id, num_upstream_);
+    auto& bits = versions_[version];
+    if (bits.words.empty()) {
+      bits.words.resize((num_upstream_ + 63) / 64, 0);
+    }
+    uint64_t& word = bits.words[upstream_part_id / 64];
+    const uint64_t mask = uint64_t(1) << (upstream_part_id % 64);
+    if (word & mask) {
+      return false;
+    }
+    word |= mask;
+    bits.count += 1;
+    return true;
+  }
+
+  bool Has(int version, int upstream_part_id) const {
+    auto it = versions_.find(version);
+    if (it == versions_.end() || upstream_part_id < 0 || upstream_part_id >= num_upstream_) {
+      return false;
+    }
+    return (it->second.words[upstream_part_id / 64] >> (upstream_part_id % 64)) & 1;
+  }
+
+  int Count(int version) const {
+    auto it = versions_.find(version);
+    return it == versions_.end() ? 0 : it->second.count;
+  }
+
+  bool IsComplete(int version) const {
+    return Count(version) == num_upstream_;
+  }
+
+  void Erase(int version) {
+    versions_.erase(version);
+  }
+
+  // # joined upstream parts of all the versions kept
+  int Size() const {
+    int size = 0;
+    for (auto& kv : versions_) {
+      size += kv.second.count;
+    }
+    return size;
+  }
+
+  friend SArrayBinStream& operator<<(SArrayBinStream& stream, const JoinTracker& t) {
+    stream << t.num_upstream_ << static_cast<int>(t.versions_.size());
+    for (auto& kv : t.versions_) {
+      stream << kv.first << kv.second.count << kv.second.words;
+    }
+    return stream;
+  }
+
+  friend SArrayBinStream& operator>>(SArrayBinStream& stream, JoinTracker& t) {
+    int num_versions;
+    stream >> t.num_upstream_ >> num_versions;
+    t.versions_.clear();
+    for (int i = 0; i < num_versions; ++ i) {
+      int version;
+      stream >> version;
+      auto& bits = t.versions_[version];
+      stream >> bits.count >> bits.words;
+    }
+    return stream;
+  }
+
+ private:
+  struct Bits {
+    std::vector<uint64_t> words;
+    int count = 0;
+  };
+  int num_upstream_ = 0;
+  // version -> joined upstream parts, a few versions only (bounded by the staleness)
+  std::map<int, Bits> versions_;
+};
+
+}  // namespace xyz
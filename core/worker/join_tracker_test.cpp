@@ -0,0 +1,61 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/worker/join_tracker.hpp"
+
+namespace xyz {
+namespace {
+
+class TestJoinTracker : public testing::Test {};
+
+TEST_F(TestJoinTracker, AddHas) {
+  JoinTracker tracker(130);
+  EXPECT_FALSE(tracker.Has(0, 1));
+  EXPECT_TRUE(tracker.Add(0, 1));
+  EXPECT_TRUE(tracker.Add(0, 129));
+  EXPECT_TRUE(tracker.Has(0, 1));
+  EXPECT_TRUE(tracker.Has(0, 129));
+  EXPECT_FALSE(tracker.Has(0, 64));
+  EXPECT_FALSE(tracker.Has(1, 1));
+  // duplicated join
+  EXPECT_FALSE(tracker.Add(0, 1));
+  EXPECT_EQ(tracker.Count(0), 2);
+  EXPECT_TRUE(tracker.Add(1, 1));
+  EXPECT_EQ(tracker.Size(), 3);
+
+  tracker.Erase(0);
+  EXPECT_FALSE(tracker.Has(0, 1));
+  EXPECT_EQ(tracker.Count(0), 0);
+  EXPECT_EQ(tracker.Size(), 1);
+}
+
+TEST_F(TestJoinTracker, Complete) {
+  JoinTracker tracker(3);
+  tracker.Add(2, 0);
+  tracker.Add(2, 2);
+  EXPECT_FALSE(tracker.IsComplete(2));
+  tracker.Add(2, 2);
+  EXPECT_FALSE(tracker.IsComplete(2));
+  tracker.Add(2, 1);
+  EXPECT_TRUE(tracker.IsComplete(2));
+}
+
+TEST_F(TestJoinTracker, Serialize) {
+  JoinTracker tracker(70);
+  tracker.Add(0, 3);
+  tracker.Add(0, 69);
+  tracker.Add(1, 5);
+  SArrayBinStream bin;
+  bin << tracker;
+  JoinTracker new_tracker;
+  bin >> new_tracker;
+  EXPECT_TRUE(new_tracker.Has(0, 3));
+  EXPECT_TRUE(new_tracker.Has(0, 69));
+  EXPECT_TRUE(new_tracker.Has(1, 5));
+  EXPECT_EQ(new_tracker.Count(0), 2);
+  EXPECT_EQ(new_tracker.Size(), 3);
+  EXPECT_TRUE(new_tracker.Add(0, 4));
+}
+
+}  // namespace
+}  // namespace xyz
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "base/sarray_binstream.hpp"
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+/*
+ * The join messages sent by the local map parts, per update part and
+ * version, for the recovery without a global rollback.
+ *
+ * The partitions lost in a failure are reloaded from the last checkpoint
+ * and the senders replay the messages of the versions after it to them,
+ * the other partitions go on with their own state. Only the last few
+ * versions are kept, EraseBefore drops the old ones as the min version
+ * advances.
+ *
+ * Add is called from the combiner threads while the controller thread
+ * erases and replays, so it is thread-safe.
+ */
+class MessageLog {
+ public:
+  struct Entry {
+    int part_id;
+    int version;
+    std::vector<int> upstream_part_ids;
+    SArrayBinStream bin;
+  };
+
+  void Add(int part_id, int version, std::vector<int> upstream_part_ids,
+          SArrayBinStream bin) {
+    std::lock_guard<std::mutex> lk(mu_);
+    bytes_ += bin.Size();
+    entries_[version].push_back({part_id, version, std::move(upstream_part_ids), std::move(bin)});
+  }
+
+  // drop the versions before version
+  void EraseBefore(int version) {
+    std::lock_guard<std::mutex> lk(mu_);
+    trim_version_ = std::max(trim_version_, version);
+    auto end = entries_.lower_bound(version);
+    for (auto it = entries_.begin(); it != end; ++ it) {
+      for (auto& e : it->second) {
+        bytes_ -= e.bin.Size();
+      }
+    }
+    entries_.erase(entries_.begin(), end);
+  }
+
+  // the messages to part_id of version >= from_version, in version order,
+  // the bins share the buffers of the log
+  std::vector<Entry> Get(int part_id, int from_version) {
+    std::lock_guard<std::mutex> lk(mu_);
+    std::vector<Entry> ret;
+    for (auto it = entries_.lower_bound(from_version); it != entries_.end(); ++ it) {
+      for (auto& e : it->second) {
+        if (e.part_id == part_id) {
+          ret.push_back(e);
+        }
+      }
+    }
+    return ret;
+  }
+
+  // the first version kept, -1 if empty
+  int GetMinVersion() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return entries_.empty() ? -1 : entries_.begin()->first;
+  }
+
+  // the versions before it are dropped, the ones after it are complete
+  // even if nothing is logged (e.g. no map part here sent to the version)
+  int GetTrimVersion() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return trim_version_;
+  }
+
+  size_t GetBytes() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return bytes_;
+  }
+
+ private:
+  std::mutex mu_;
+  // version -> messages
+  std::map<int, std::vector<Entry>> entries_;
+  size_t bytes_ = 0;
+  int trim_version_ = 0;
+};
+
+}  // namespace xyz
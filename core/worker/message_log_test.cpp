@@ -0,0 +1,78 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/worker/message_log.hpp"
+
+namespace xyz {
+namespace {
+
+class TestMessageLog : public testing::Test {};
+
+SArrayBinStream MakeBin(int x) {
+  SArrayBinStream bin;
+  bin << x;
+  return bin;
+}
+
+TEST_F(TestMessageLog, AddGet) {
+  MessageLog log;
+  EXPECT_EQ(log.GetMinVersion(), -1);
+  log.Add(0, 1, {3}, MakeBin(10));
+  log.Add(1, 1, {3}, MakeBin(11));
+  log.Add(0, 0, {2, 3}, MakeBin(20));
+  log.Add(0, 2, {2}, MakeBin(30));
+  EXPECT_EQ(log.GetMinVersion(), 0);
+  EXPECT_EQ(log.GetBytes(), 4 * sizeof(int));
+
+  auto entries = log.Get(0, 1);
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_EQ(entries[0].version, 1);
+  EXPECT_EQ(entries[0].upstream_part_ids, std::vector<int>({3}));
+  EXPECT_EQ(entries[1].version, 2);
+  int x;
+  entries[1].bin >> x;
+  EXPECT_EQ(x, 30);
+  // the log keeps its copy
+  entries = log.Get(0, 0);
+  ASSERT_EQ(entries.size(), 3);
+  EXPECT_EQ(entries[0].upstream_part_ids, std::vector<int>({2, 3}));
+  entries[2].bin >> x;
+  EXPECT_EQ(x, 30);
+  EXPECT_EQ(log.Get(2, 0).size(), 0);
+}
+
+TEST_F(TestMessageLog, EraseBefore) {
+  MessageLog log;
+  for (int version = 0; version < 5; ++ version) {
+    log.Add(0, version, {0}, MakeBin(version));
+    log.Add(1, version, {0}, MakeBin(version));
+  }
+  log.EraseBefore(3);
+  EXPECT_EQ(log.GetMinVersion(), 3);
+  EXPECT_EQ(log.GetBytes(), 4 * sizeof(int));
+  auto entries = log.Get(1, 0);
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_EQ(entries[0].version, 3);
+  log.EraseBefore(10);
+  EXPECT_EQ(log.GetMinVersion(), -1);
+  EXPECT_EQ(log.GetBytes(), 0);
+}
+
+TEST_F(TestMessageLog, TrimVersion) {
+  MessageLog log;
+  EXPECT_EQ(log.GetTrimVersion(), 0);
+  // nothing sent in version 1 and 2
+  log.Add(0, 0, {0}, MakeBin(0));
+  log.Add(0, 3, {0}, MakeBin(3));
+  log.EraseBefore(1);
+  EXPECT_EQ(log.GetMinVersion(), 3);
+  // version 1 is still complete
+  EXPECT_EQ(log.GetTrimVersion(), 1);
+  log.EraseBefore(-1);
+  EXPECT_EQ(log.GetTrimVersion(), 1);
+  log.EraseBefore(5);
+  EXPECT_EQ(log.GetTrimVersion(), 5);
+}
+
+}  // namespace
+}  // namespace xyz
@@ -1,12 +1,12 @@
 #include "core/worker/plan_controller.hpp"
 #include "core/scheduler/control.hpp"
+#include "core/scheduler/checkpoint_io.hpp"
 #include "glog/logging.h"
 #include "base/color.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <stdlib.h>
-//core/scheduler/control_manager.cpp; core/worker/plan_controller.cpp
-#define BGCP false
 // #define CPULIMIT
 
 // for migrate update like pr, enable MIGRATE_JOIN and use stop_updateing_partitions_
@@ -16,18 +16,28 @@
 namespace xyz {
 
 PlanController::PlanController(Controller* controller)
-  : controller_(controller) {
+  : controller_(controller),
+    shard_mu_(controller->engine_elem_.num_controller_shards),
+    update_tracker_(NumShards()), pending_updates_(NumShards()),
+    running_updates_(NumShards()), running_fetches_(NumShards()),
+    waiting_updates_(NumShards()), buffered_requests_(NumShards()) {
+  update_tracker_size_.resize(NumShards());
   fetch_executor_ = std::make_shared<Executor>(controller_->engine_elem_.num_update_threads);
   map_executor_ = std::make_shared<Executor>(controller_->engine_elem_.num_local_threads);
+  checkpoint_executor_ = std::make_shared<Executor>(1);
   local_map_mode_ = true;
 }
 
 PlanController::~PlanController() {
+  if (direct_fetch_) {
+    controller_->engine_elem_.fetcher->RemoveDirectFetch(plan_id_, fetch_collection_id_);
+  }
   ShowJoinTrackerSize();
   LOG(INFO) << RED("~PlanController: " + std::to_string(plan_id_));
 }
  
 void PlanController::Setup(SpecWrapper spec) {
+  auto lks = LockAllShards();
   type_ = spec.type;
   CHECK(type_ == SpecWrapper::Type::kMapJoin
        || type_ == SpecWrapper::Type::kMapWithJoin);
@@ -40,6 +50,8 @@ void PlanController::Setup(SpecWrapper spec) {
   update_collection_id_ = p->update_collection_id;
   checkpoint_interval_ = p->checkpoint_interval;
   checkpoint_path_ = p->checkpoint_path;
+  num_delta_checkpoints_ = p->num_delta_checkpoints;
+  num_log_versions_ = p->num_log_versions;
   if (checkpoint_interval_ != 0) {
     CHECK(checkpoint_path_.size());
   }
@@ -54,11 +66,24 @@ void PlanController::Setup(SpecWrapper spec) {
   CHECK_NE(expected_num_iter_, 0);
   map_versions_.clear();
   update_versions_.clear();
-  update_tracker_.clear();
-  pending_updates_.clear();
-  waiting_updates_.clear();
+  update_tracker_.Clear();
+  joined_before_.clear();
+  pending_updates_.Clear();
+  waiting_updates_.Clear();
   int combine_timeout = p->combine_timeout;
-  delayed_combiner_ = std::make_shared<DelayedCombiner>(this, combine_timeout);
+  credit_tracker_ = std::make_shared<CreditTracker>(controller_->engine_elem_.num_credits_per_node);
+  gated_ = false;
+  ready_parts_.clear();
+  local_shuffle_bytes_ = 0;
+  remote_shuffle_bytes_ = 0;
+  delayed_combiner_ = std::make_shared<DelayedCombiner>(this, combine_timeout, num_log_versions_);
+  // the with collection is not updated in this plan, its objs are fetched
+  // from the FetchServers without going through the controllers
+  if (fetch_collection_id_ != -1 && fetch_collection_id_ != update_collection_id_
+          && controller_->engine_elem_.fetcher) {
+    controller_->engine_elem_.fetcher->AddDirectFetch(plan_id_, fetch_collection_id_);
+    direct_fetch_ = true;
+  }
 
   auto parts = controller_->engine_elem_.partition_manager->Get(map_collection_id_);
   for (auto& part : parts) {
@@ -80,6 +105,7 @@ void PlanController::Setup(SpecWrapper spec) {
 }
 
 void PlanController::StartPlan() {
+  auto lks = LockAllShards();
   TryRunSomeMaps();
 }
 
@@ -101,12 +127,23 @@ void PlanController::UpdateVersion(SArrayBinStream bin) {
   cpu_limit.detach();
 #endif
 
+  auto lks = LockAllShards();
   CHECK_LT(new_version, expected_num_iter_);
   CHECK_EQ(new_version, min_version_+1);
   min_version_ = new_version;
-  for (auto& part_version : update_tracker_) {
-    part_version.second.erase(new_version-1);  // erase old update_tracker content
+  for (int i = 0; i < NumShards(); ++ i) {
+    for (auto& part_tracker : update_tracker_.GetShard(i)) {
+      part_tracker.second.Erase(new_version-1);  // erase old update_tracker content
+    }
   }
+  for (auto it = joined_before_.begin(); it != joined_before_.end(); ) {
+    if (it->second <= min_version_) {
+      it = joined_before_.erase(it);
+    } else {
+      ++ it;
+    }
+  }
+  delayed_combiner_->TrimLog(min_version_);
   TryRunSomeMaps();
 }
 
@@ -114,6 +151,7 @@ void PlanController::FinishMap(SArrayBinStream bin) {
   int part_id;
   bool update_version;
   bin >> part_id >> update_version;
+  auto lks = LockAllShards();
   running_maps_.erase(part_id);
 
   {
@@ -179,7 +217,7 @@ bool PlanController::IsMapRunnable(int part_id) {
   }
   // 2. if mid == jid, check whether there is running update for this part
   if (map_collection_id_ == update_collection_id_
-          && running_updates_.find(part_id) != running_updates_.end()) {
+          && running_updates_.Has(part_id)) {
     return false;
   }
   // 3. if mid == jid, check whether this part is migrating
@@ -195,11 +233,20 @@ bool PlanController::IsMapRunnable(int part_id) {
   if (version == expected_num_iter_) {  // no need to run anymore
     return false;
   }
-  if (version <= min_version_ + staleness_) {
-    return true;
-  } else {
+  if (version > min_version_ + staleness_) {
+    return false;
+  }
+  // 5. flow control, hold back the maps ahead of the min version if some
+  // remote node has not consumed our join messages yet. Maps of the min
+  // version always run so that the slowest node can make progress.
+  if (version > min_version_ && !credit_tracker_->HasCredit()) {
     return false;
   }
+  // 6. pipelining, the upstream plan has not finished this part yet
+  if (gated_ && ready_parts_.find(part_id) == ready_parts_.end()) {
+    return false;
+  }
+  return true;
 }
 
 bool PlanController::TryRunWaitingJoins(int part_id) {
@@ -215,7 +262,7 @@ bool PlanController::TryRunWaitingJoins(int part_id) {
   }
 #endif
   
-  if (running_updates_.find(part_id) != running_updates_.end()) {
+  if (running_updates_.Has(part_id)) {
     // someone is updateing this part
     return false;
   }
@@ -251,20 +298,23 @@ void PlanController::FinishJoin(SArrayBinStream bin) {
   int part_id, version;
   std::vector<int> upstream_part_ids;
   bin >> part_id >> version >> upstream_part_ids;
+  auto lk = LockShard(part_id);
   // LOG(INFO) << "FinishJoin: partid, version: " << part_id << " " << version;
-  running_updates_.erase(part_id);
+  running_updates_.Erase(part_id);
 
+  auto& tracker = GetJoinTracker(part_id);
   for (auto upstream_part_id : upstream_part_ids) {
-    update_tracker_[part_id][version].insert(upstream_part_id);
+    tracker.Add(version, upstream_part_id);
   }
-  if (update_tracker_[part_id][version].size() == num_upstream_part_) {
-    CalcJoinTrackerSize();
-    update_tracker_[part_id][version].clear(); //
+  if (tracker.IsComplete(version)) {
+    CalcJoinTrackerSize(part_id);
+    // the bits of this version are kept until the min version passes it,
+    // so that a late duplicate (e.g. a speculative map) is still dropped
     update_versions_[part_id] += 1;
 
     bool runcp = TryCheckpoint(part_id);
     if (runcp) {
-      // if runcp, whether BGCP or not, ReportFinishPart after checkpoint
+      // the partition is being checkpointed, ReportFinishPart after checkpoint
       return;
     } else {
       ReportFinishPart(ControllerMsg::Flag::kJoin, part_id, update_versions_[part_id]);
@@ -281,40 +331,31 @@ bool PlanController::TryCheckpoint(int part_id) {
   }
   */
   if (checkpoint_interval_ != 0 && update_versions_[part_id] % checkpoint_interval_ == 0) {
-    int checkpoint_iter = update_versions_[part_id] / checkpoint_interval_;
+    const int version = update_versions_[part_id];
+    int checkpoint_iter = version / checkpoint_interval_;
     std::string dest_url = checkpoint_path_ + 
         "/cp-" + std::to_string(checkpoint_iter);
     dest_url = GetCheckpointUrl(dest_url, update_collection_id_, part_id);
+    const bool delta = IsDeltaCheckpoint(checkpoint_iter, num_delta_checkpoints_);
+
+    CHECK(controller_->engine_elem_.partition_manager->Has(update_collection_id_, part_id));
+    auto part = controller_->engine_elem_.partition_manager->Get(update_collection_id_, part_id);
+    auto snapshot = part->Snapshot();
+    if (snapshot) {
+      // the next delta starts from here
+      part->ResetDelta();
+      // the joins go on with the partition while the snapshot is written,
+      // in its own executor so that it does not wait for the fetches
+      checkpoint_executor_->Add([this, snapshot, dest_url, part_id, version, delta]() {
+        WriteCheckpoint(snapshot, dest_url, part_id, version, delta);
+      });
+      return false;
+    }
 
-    CHECK(running_updates_.find(part_id) == running_updates_.end());
-    running_updates_.insert({part_id, -1});
-    // TODO: is it ok to use the fetch_executor? can it be block due to other operations?
-    fetch_executor_->Add([this, part_id, dest_url]() {
-      CHECK(controller_->engine_elem_.partition_manager->Has(update_collection_id_, part_id));
-      auto part = controller_->engine_elem_.partition_manager->Get(update_collection_id_, part_id);
-
-      SArrayBinStream bin;
-      part->ToBin(bin);
-	  if (!BGCP) { //No Backgroud CP
-        auto writer = controller_->io_wrapper_->GetWriter();
-        bool rc = writer->Write(dest_url, bin.GetPtr(), bin.Size());
-        CHECK_EQ(rc, 0);
-        LOG(INFO) << "write checkpoint to " << dest_url;
-   	  } else {
-	    std::thread cp_write([this, bin, dest_url, part_id]() {
-	      boost::shared_lock<boost::shared_mutex> lk(controller_->erase_mu_);
-		  if (controller_->erased[plan_id_]) {
-		    LOG(INFO) << BLUE("Plan " + std::to_string(plan_id_) + " has been erased, stop cp write");
-		    return;
-		  }
-          auto writer = controller_->io_wrapper_->GetWriter();
-          bool rc = writer->Write(dest_url, bin.GetPtr(), bin.Size());
-          CHECK_EQ(rc, 0);
-          LOG(INFO) << "BGCP: writing checkpoint to " << dest_url << ", node: " << controller_->engine_elem_.node.id;
-  	      ReportFinishPart(ControllerMsg::Flag::kFinishCP, part_id, update_versions_[part_id]);
-		});
-		cp_write.detach();
-	  }
+    CHECK(!running_updates_.Has(part_id));
+    running_updates_.Insert(part_id, -1);
+    fetch_executor_->Add([this, part, dest_url, part_id, version, delta]() {
+      WriteCheckpoint(part, dest_url, part_id, version, delta);
 	  // Send finish checkpoint
       Message msg;
       msg.meta.sender = 0;
@@ -336,12 +377,49 @@ bool PlanController::TryCheckpoint(int part_id) {
   }
 }
 
+// Write the partition and tell the scheduler once it is in the shared
+// store, the scheduler adds the checkpoint once all the partitions of the
+// version are written.
+// A delta checkpoint starts with a bool: whether it is a delta or a full
+// image (e.g. the partition is sorted or migrated since the last one).
+// Runs in the fetch_executor_ or the checkpoint_executor_.
+void PlanController::WriteCheckpoint(std::shared_ptr<AbstractPartition> part,
+        std::string dest_url, int part_id, int version, bool delta) {
+  SArrayBinStream bin;
+  if (delta) {
+    bin << true;
+    if (!part->ToDeltaBin(bin)) {
+      bin = SArrayBinStream();
+      bin << false;
+      part->ToBin(bin);
+    }
+  } else {
+    part->ToBin(bin);
+  }
+  ControllerMsg ctrl;
+  ctrl.flag = ControllerMsg::Flag::kFinishCP;
+  ctrl.version = version;
+  ctrl.node_id = controller_->engine_elem_.node.id;
+  ctrl.plan_id = plan_id_;
+  ctrl.part_id = part_id;
+  // the plan may be terminated when it is replicated, do not use this
+  Controller* controller = controller_;
+  CHECK_NOTNULL(controller->engine_elem_.checkpoint_io);
+  controller->engine_elem_.checkpoint_io->Write(dest_url, bin, [controller, ctrl]() {
+    SArrayBinStream bin;
+    bin << ctrl;
+    controller->SendMsgToScheduler(bin);
+  });
+  LOG(INFO) << "write checkpoint to " << dest_url << ", node: " << controller_->engine_elem_.node.id;
+}
+
 void PlanController::FinishCheckpoint(SArrayBinStream bin) {
   int part_id;
   bin >> part_id;
   LOG(INFO) << "finish checkpoint: " << part_id;
-  CHECK(running_updates_.find(part_id) != running_updates_.end());
-  running_updates_.erase(part_id);
+  auto lks = LockAllShards();
+  CHECK(running_updates_.Has(part_id));
+  running_updates_.Erase(part_id);
   ReportFinishPart(ControllerMsg::Flag::kJoin, part_id, update_versions_[part_id]);
   TryRunWaitingJoins(part_id);
   TryRunSomeMaps();
@@ -356,8 +434,41 @@ void PlanController::ReportFinishPart(ControllerMsg::Flag flag,
   ctrl.node_id = controller_->engine_elem_.node.id;
   ctrl.plan_id = plan_id_;
   ctrl.part_id = part_id;
-  bin << ctrl;
-  controller_->SendMsgToScheduler(bin);
+  // for the cost model of the load balancing
+  int collection_id = (flag == ControllerMsg::Flag::kMap) ? map_collection_id_ : update_collection_id_;
+  if (controller_->engine_elem_.partition_manager->Has(collection_id, part_id)) {
+    ctrl.part_bytes = controller_->engine_elem_.partition_manager->Get(collection_id, part_id)->GetBytes();
+  }
+  const int batch_size = controller_->engine_elem_.report_batch_size;
+  if (batch_size <= 1) {
+    bin << ctrl;
+    controller_->SendMsgToScheduler(bin);
+    return;
+  }
+  std::lock_guard<std::mutex> lk(report_mu_);
+  report_bin_ << ctrl;
+  num_reports_ += 1;
+  controller_->num_pending_reports_ += 1;
+  // nothing else running may complete the batch, do not wait for the
+  // ticker, e.g. the last part of a version in a BSP plan
+  if (num_reports_ >= batch_size || (running_maps_.empty() && running_updates_.Empty())) {
+    FlushReportsLocked();
+  }
+}
+
+void PlanController::FlushReports() {
+  std::lock_guard<std::mutex> lk(report_mu_);
+  FlushReportsLocked();
+}
+
+void PlanController::FlushReportsLocked() {
+  if (num_reports_ == 0) {
+    return;
+  }
+  controller_->SendMsgToScheduler(report_bin_);
+  report_bin_ = SArrayBinStream();
+  controller_->num_pending_reports_ -= num_reports_;
+  num_reports_ = 0;
 }
 
 void PlanController::RunMap(int part_id, int version, 
@@ -454,6 +565,7 @@ void PlanController::ReceiveJoin(Message msg) {
   update_meta.meta = meta;
   update_meta.bin = bin;
 
+  auto lk = LockShard(meta.part_id);
   if (update_versions_.find(meta.part_id) == update_versions_.end()) {
     // if receive something that is not belong to here
     buffered_requests_[meta.part_id].push_back(update_meta);
@@ -464,11 +576,14 @@ void PlanController::ReceiveJoin(Message msg) {
   // if already updateed, omit it.
   // still need to check again in RunJoin as this upstream_part_id may be in waiting updates.
   if (IsJoinedBefore(meta)) {
+    DropJoin(meta);
     return;
   }
 
   if (map_collection_id_ == update_collection_id_) {
-    if (meta.version >= map_versions_[meta.part_id]) {
+    // map_versions_ is only written with all the shards locked
+    auto it = map_versions_.find(meta.part_id);
+    if (it != map_versions_.end() && meta.version >= it->second) {
       pending_updates_[meta.part_id][meta.version].push_back(update_meta);
       return;
     }
@@ -480,14 +595,23 @@ void PlanController::ReceiveJoin(Message msg) {
 
 // check whether this upstream_part_id is updateed already
 bool PlanController::IsJoinedBefore(const VersionedShuffleMeta& meta) {
+  // the update_tracker_ of the versions before min_version_ are erased,
+  // all joins of these versions are done (e.g. a late speculative map)
+  if (meta.version < min_version_) {
+    LOG(INFO) << "[PlanController::IsJoinedBefore] ignore update of old version: " << meta.DebugString();
+    return true;
+  }
+  auto it = joined_before_.find(meta.part_id);
+  if (it != joined_before_.end() && meta.version < it->second) {
+    LOG(INFO) << "[PlanController::IsJoinedBefore] ignore update before the recovery: " << meta.DebugString();
+    return true;
+  }
+  const auto& tracker = GetJoinTracker(meta.part_id);
   if (meta.upstream_part_id == -1) {
     CHECK_GT(meta.ext_upstream_part_ids.size(), 0);
-    bool result = update_tracker_[meta.part_id][meta.version].find(meta.ext_upstream_part_ids.at(0))
-      != update_tracker_[meta.part_id][meta.version].end();
+    bool result = tracker.Has(meta.version, meta.ext_upstream_part_ids.at(0));
     for (int i = 1; i < meta.ext_upstream_part_ids.size(); i++) {
-      CHECK_EQ(result, 
-          update_tracker_[meta.part_id][meta.version].find(meta.ext_upstream_part_ids.at(i))
-          != update_tracker_[meta.part_id][meta.version].end());
+      CHECK_EQ(result, tracker.Has(meta.version, meta.ext_upstream_part_ids.at(i)));
     }
     if (result) {
       LOG(INFO) << "[PlanController::IsJoinedBefore] (ext_upstream_part_ids)ignore update, already updateed: " << meta.DebugString();
@@ -495,8 +619,7 @@ bool PlanController::IsJoinedBefore(const VersionedShuffleMeta& meta) {
     return result;
   }
 
-  if (update_tracker_[meta.part_id][meta.version].find(meta.upstream_part_id)
-      != update_tracker_[meta.part_id][meta.version].end()) {
+  if (tracker.Has(meta.version, meta.upstream_part_id)) {
     LOG(INFO) << "[PlanController::IsJoinedBefore] ignore update, already updateed: " << meta.DebugString();
     return true;
   } else {
@@ -507,13 +630,14 @@ bool PlanController::IsJoinedBefore(const VersionedShuffleMeta& meta) {
 void PlanController::RunJoin(VersionedJoinMeta meta) {
   // LOG(INFO) << meta.meta.DebugString();
   if (IsJoinedBefore(meta.meta)) {
+    DropJoin(meta.meta);
     // Need to TryRunWaitingJoins
     TryRunWaitingJoins(meta.meta.part_id);
     return;
   }
   // LOG(INFO) << "RunJoin: " << meta.meta.DebugString();
-  CHECK(running_updates_.find(meta.meta.part_id) == running_updates_.end());
-  running_updates_.insert({meta.meta.part_id, meta.meta.upstream_part_id});
+  CHECK(!running_updates_.Has(meta.meta.part_id));
+  running_updates_.Insert(meta.meta.part_id, meta.meta.upstream_part_id);
   // use the fetch_executor to avoid the case:
   // map wait for fetch, fetch wait for update, update is in running_updates_
   // but it cannot run because map does not finish and occupy the threadpool
@@ -539,6 +663,7 @@ void PlanController::RunJoin(VersionedJoinMeta meta) {
       auto p = controller_->engine_elem_.partition_manager->Get(update_collection_id_, meta.meta.part_id);
       update_func(p, meta.bin);
     }
+    GrantCredit(meta.meta);
 
     Message msg;
     msg.meta.sender = 0;
@@ -570,6 +695,62 @@ void PlanController::RunJoin(VersionedJoinMeta meta) {
   });
 }
 
+// a duplicate join, e.g. from a speculative map, release what it holds
+void PlanController::DropJoin(const VersionedShuffleMeta& meta) {
+  if (local_map_mode_ && meta.local_mode) {
+    if (meta.ext_upstream_part_ids.empty()) {
+      stream_store_.Remove(std::make_tuple(meta.part_id, std::vector<int>{meta.upstream_part_id}, meta.version));
+    } else {
+      stream_store_.Remove(std::make_tuple(meta.part_id, meta.ext_upstream_part_ids, meta.version));
+    }
+  }
+  GrantCredit(meta);
+}
+
+// give the credit consumed by this join message back to its sender,
+// may be called in the fetch_executor_
+void PlanController::GrantCredit(const VersionedShuffleMeta& meta) {
+  // only the join messages sent to a remote node are charged
+  if (!credit_tracker_->Enabled() || meta.sender == -1
+          || GetNodeId(meta.sender) == GetNodeId(meta.recver)) {
+    return;
+  }
+  Message msg;
+  msg.meta.sender = controller_->Qid();
+  msg.meta.recver = meta.sender;
+  msg.meta.flag = Flag::kOthers;
+  msg.meta.traffic_class = TrafficClass::kControl;
+  SArrayBinStream ctrl_bin, plan_bin, bin;
+  ctrl_bin << ControllerFlag::kGrantCredit;
+  plan_bin << plan_id_;
+  // the node charged by the sender, the part may have been migrated here
+  bin << GetNodeId(meta.recver) << 1;
+  msg.AddData(ctrl_bin.ToSArray());
+  msg.AddData(plan_bin.ToSArray());
+  msg.AddData(bin.ToSArray());
+  controller_->engine_elem_.sender->Send(std::move(msg));
+}
+
+void PlanController::ReceiveCredit(SArrayBinStream bin) {
+  int node_id, num_credits;
+  bin >> node_id >> num_credits;
+  auto lks = LockAllShards();
+  bool had_credit = credit_tracker_->HasCredit();
+  credit_tracker_->Grant(node_id, num_credits);
+  if (!had_credit && credit_tracker_->HasCredit()) {
+    TryRunSomeMaps();
+  }
+}
+
+void PlanController::ReadyParts(SArrayBinStream bin) {
+  std::vector<int> part_ids;
+  bin >> part_ids;
+  auto lks = LockAllShards();
+  gated_ = true;
+  ready_parts_.insert(part_ids.begin(), part_ids.end());
+  TryRunSomeMaps();
+}
+
 void PlanController::ReceiveFetchRequest(Message msg) {
   CHECK_EQ(msg.data.size(), 3);
   SArrayBinStream ctrl2_bin, bin;
@@ -599,6 +780,7 @@ void PlanController::ReceiveFetchRequest(Message msg) {
 
   bool update_fetch = (fetch_meta.meta.collection_id == update_collection_id_);
 
+  auto lk = LockShard(fetch_meta.meta.part_id);
   if (!update_fetch) {
     RunFetchRequest(fetch_meta);
     return;
@@ -624,7 +806,7 @@ void PlanController::ReceiveFetchRequest(Message msg) {
   }
 #endif
 
-  if (running_updates_.find(fetch_meta.meta.part_id) != running_updates_.end()) {
+  if (running_updates_.Has(fetch_meta.meta.part_id)) {
     // if this part is updateing
     waiting_updates_[fetch_meta.meta.part_id].push_back(fetch_meta);
   } else {
@@ -725,12 +907,16 @@ void PlanController::FinishFetch(SArrayBinStream bin) {
   int part_id, upstream_part_id;
   bin >> part_id >> upstream_part_id;
   // LOG(INFO) << "FinishFetch: " << part_id << " " << upstream_part_id;
+  auto lk = LockShard(part_id);
   running_fetches_[part_id] -= 1;
   TryRunWaitingJoins(part_id);
 }
 
 void PlanController::MigratePartition(Message msg) {
   CHECK_GE(msg.data.size(), 3);
+  auto lks = LockAllShards();
+  // the scheduler must see the reports of the part before the ones from its new node
+  FlushReports();
   SArrayBinStream ctrl2_bin, bin;
   ctrl2_bin.FromSArray(msg.data[2]);
   MigrateMeta migrate_meta;
@@ -749,10 +935,12 @@ void PlanController::MigratePartition(Message msg) {
     MigratePartitionReceiveFlushAll(migrate_meta);
   } else if (migrate_meta.flag == MigrateMeta::MigrateFlag::kDest){
     MigratePartitionDest(msg);
-  } else if (migrate_meta.flag == MigrateMeta::MigrateFlag::kStartMigrateMapOnly){
-    MigratePartitionStartMigrateMapOnly(migrate_meta);
-  } else if (migrate_meta.flag == MigrateMeta::MigrateFlag::kReceiveMapOnly){
-    MigratePartitionReceiveMapOnly(msg);
+  } else if (migrate_meta.flag == MigrateMeta::MigrateFlag::kStartSpeculativeMap){
+    int version;
+    ctrl2_bin >> version;
+    StartSpeculativeMap(migrate_meta, version);
+  } else if (migrate_meta.flag == MigrateMeta::MigrateFlag::kReceiveSpeculativeMap){
+    ReceiveSpeculativeMap(msg);
   } else {
     CHECK(false);
   }
@@ -797,7 +985,7 @@ void PlanController::MigratePartitionReceiveFlushAll(MigrateMeta migrate_meta) {
   flush_all_count_[migrate_meta.partition_id] += 1;
   LOG(INFO) << "[Migrate] Received one Flush signal";
   if (flush_all_count_[migrate_meta.partition_id] == migrate_meta.num_nodes) {
-    if (running_updates_.find(migrate_meta.partition_id) != running_updates_.end()) {
+    if (running_updates_.Has(migrate_meta.partition_id)) {
       // if there is a update/fetch task for this part
       // push a msg to the msg queue to run this function again
       LOG(INFO) << "there is a update/fetch for part, try to migrate partition and msgs later " << migrate_meta.partition_id;
@@ -876,12 +1064,12 @@ void PlanController::MigratePartitionReceiveFlushAll(MigrateMeta migrate_meta) {
         serialize_from_stream_store(update_meta);
       }
     } 
-    data.update_tracker = std::move(update_tracker_[migrate_meta.partition_id]);
+    data.update_tracker = std::move(GetJoinTracker(migrate_meta.partition_id));
     update_versions_.erase(migrate_meta.partition_id);
     num_local_update_part_ -= 1;
-    pending_updates_.erase(migrate_meta.partition_id);
-    waiting_updates_.erase(migrate_meta.partition_id);
-    update_tracker_.erase(migrate_meta.partition_id);
+    pending_updates_.Erase(migrate_meta.partition_id);
+    waiting_updates_.Erase(migrate_meta.partition_id);
+    update_tracker_.Erase(migrate_meta.partition_id);
     Message msg;
     msg.meta.sender = controller_->engine_elem_.node.id;
     msg.meta.recver = GetControllerActorQid(migrate_meta.to_id);
@@ -964,9 +1152,9 @@ void PlanController::MigratePartitionDest(Message msg) {
     migrate_data.map_version = -1;
   }
   CHECK(update_versions_.find(migrate_meta.partition_id) == update_versions_.end());
-  CHECK(pending_updates_.find(migrate_meta.partition_id) == pending_updates_.end());
-  CHECK(waiting_updates_.find(migrate_meta.partition_id) == waiting_updates_.end());
-  CHECK(update_tracker_.find(migrate_meta.partition_id) == update_tracker_.end());
+  CHECK(!pending_updates_.Has(migrate_meta.partition_id));
+  CHECK(!waiting_updates_.Has(migrate_meta.partition_id));
+  CHECK(!update_tracker_.Has(migrate_meta.partition_id));
   update_versions_[migrate_meta.partition_id] = migrate_data.update_version;
   pending_updates_[migrate_meta.partition_id] = std::move(migrate_data.pending_updates);
   waiting_updates_[migrate_meta.partition_id] = std::move(migrate_data.waiting_updates);
@@ -985,7 +1173,7 @@ void PlanController::MigratePartitionDest(Message msg) {
       waiting_updates_[request.meta.part_id].push_back(request);
     }
   }
-  buffered_requests_[migrate_meta.partition_id].clear();
+  buffered_requests_.Erase(migrate_meta.partition_id);
 
   auto& func = controller_->engine_elem_.function_store
       ->GetCreatePart(migrate_meta.collection_id);
@@ -1014,6 +1202,7 @@ void PlanController::MigratePartitionDest(Message msg) {
 void PlanController::FinishLoadWith(SArrayBinStream bin) {
   std::tuple<int, int, int> submeta;
   bin >> submeta;
+  auto lks = LockAllShards();
   {
     load_finished_[std::get<2>(submeta)] = true;
     LOG(INFO) << "[PlanController::FinishLoadWith] from_id: " << 
@@ -1022,27 +1211,26 @@ void PlanController::FinishLoadWith(SArrayBinStream bin) {
   }
 }
 
-void PlanController::MigratePartitionStartMigrateMapOnly(MigrateMeta migrate_meta) {
-  LOG(INFO) << "[Migrate] migrating start: " << migrate_meta.DebugString();
-  // std::thread th([this, migrate_meta]() mutable {
-  CHECK_EQ(migrate_meta.collection_id, map_collection_id_) << "only consider map_collection first";
-  CHECK_NE(migrate_meta.collection_id, update_collection_id_) << "only consider map_collection first";
-  CHECK(map_versions_.find(migrate_meta.partition_id) != map_versions_.end());
-
-  // stop the running map
-  {
-    std::lock_guard<std::mutex> lk(stop_updateing_partitions_mu_);
-    CHECK(stop_updateing_partitions_.find(migrate_meta.partition_id) == stop_updateing_partitions_.end());
-    // insert the migrate partition into stop_updateing_partitions_
-    stop_updateing_partitions_[migrate_meta.partition_id] = true;
+// Speculative execution: the owner ships a copy of a straggling map
+// partition to another node and keeps running its own map. Whichever
+// finishes first wins, the joiners drop the later output in IsJoinedBefore.
+// Only for immutable map collections (map_collection_id_ != update_collection_id_).
+void PlanController::StartSpeculativeMap(MigrateMeta migrate_meta, int version) {
+  CHECK_EQ(migrate_meta.collection_id, map_collection_id_);
+  CHECK_NE(migrate_meta.collection_id, update_collection_id_) << "only speculate on immutable map collections";
+  if (map_versions_.find(migrate_meta.partition_id) == map_versions_.end()
+          || map_versions_[migrate_meta.partition_id] != version) {
+    LOG(INFO) << "[PlanController::StartSpeculativeMap] map already finished, ignore: "
+      << migrate_meta.DebugString() << ", version: " << version;
+    return;
   }
-  
+
   // version
-  int map_version = map_versions_[migrate_meta.partition_id];
   SArrayBinStream bin1;
-  bin1 << map_version;
+  bin1 << version;
 
-  // partition
+  // partition, the map collection is read-only so it is safe to serialize
+  // while the local map is running
   CHECK(controller_->engine_elem_.partition_manager->Has(
     migrate_meta.collection_id, migrate_meta.partition_id)) << migrate_meta.collection_id << " " <<  migrate_meta.partition_id;
   auto part = controller_->engine_elem_.partition_manager->Get(
@@ -1051,7 +1239,7 @@ void PlanController::MigratePartitionStartMigrateMapOnly(MigrateMeta migrate_met
   part->ToBin(bin2);  // serialize
 
   // reset the flag
-  migrate_meta.flag = MigrateMeta::MigrateFlag::kReceiveMapOnly;
+  migrate_meta.flag = MigrateMeta::MigrateFlag::kReceiveSpeculativeMap;
 
   // send
   Message msg;
@@ -1068,15 +1256,14 @@ void PlanController::MigratePartitionStartMigrateMapOnly(MigrateMeta migrate_met
   msg.AddData(bin1.ToSArray());
   msg.AddData(bin2.ToSArray());
   controller_->engine_elem_.sender->Send(std::move(msg));
-  LOG(INFO) << "[Migrate] migrating: " << migrate_meta.DebugString();
-  // });
-  // th.detach();
+  LOG(INFO) << "[PlanController::StartSpeculativeMap] send: " << migrate_meta.DebugString() << ", version: " << version;
 }
 
 void PlanController::ReassignMap(SArrayBinStream bin) {
   // to_id, part_id, version_id
   std::vector<std::tuple<int,int,int>> reassignments;
   bin >> reassignments;
+  auto lks = LockAllShards();
   for (auto t : reassignments) {
     // LOG(INFO) << "A: " << std::get<0>(t) << ", " << std::get<1>(t)
     //   << ", " << std::get<2>(t);
@@ -1094,8 +1281,80 @@ void PlanController::ReassignMap(SArrayBinStream bin) {
   TryRunSomeMaps();
 }
 
-void PlanController::MigratePartitionReceiveMapOnly(Message msg) {
-  LOG(INFO) << "MigratePartitionReceiveMapOnly start";
+// The update parts on the dead nodes are reloaded from the checkpoint of
+// version on their new owners, they restart from there while the parts
+// here keep their state: the min version goes back to version and the
+// joins of the versions before the old min version are dropped for them
+// (e.g. the output of a lost map part run again).
+// Each node then replays the joins it logged since version to the lost parts.
+void PlanController::RecoverParts(SArrayBinStream bin) {
+  int version;
+  std::set<int> dead_nodes;
+  // part_id, to_id
+  std::vector<std::pair<int, int>> update_parts, map_parts;
+  bin >> version >> dead_nodes >> update_parts >> map_parts;
+  auto lks = LockAllShards();
+  CHECK_LE(version, min_version_);
+  for (int node_id : dead_nodes) {
+    credit_tracker_->Remove(node_id);
+  }
+  for (auto& kv : update_versions_) {
+    joined_before_[kv.first] = std::max(joined_before_[kv.first], min_version_);
+  }
+  min_version_ = version;
+
+  const int node_id = controller_->engine_elem_.node.id;
+  for (auto& p : map_parts) {
+    if (p.second != node_id) {
+      continue;
+    }
+    CHECK(controller_->engine_elem_.partition_manager->Has(map_collection_id_, p.first));
+    CHECK(map_versions_.find(p.first) == map_versions_.end());
+    map_versions_[p.first] = version;
+    num_local_map_part_ += 1;
+  }
+  std::vector<int> local_update_parts;
+  for (auto& p : update_parts) {
+    if (p.second != node_id) {
+      continue;
+    }
+    const int part_id = p.first;
+    CHECK(controller_->engine_elem_.partition_manager->Has(update_collection_id_, part_id));
+    CHECK(update_versions_.find(part_id) == update_versions_.end());
+    update_versions_[part_id] = version;
+    update_tracker_.Erase(part_id);
+    pending_updates_.Erase(part_id);
+    waiting_updates_.Erase(part_id);
+    num_local_update_part_ += 1;
+    local_update_parts.push_back(part_id);
+    // the joins (or replays) received before
+    for (auto& request : buffered_requests_[part_id]) {
+      if (map_collection_id_ == update_collection_id_
+          && request.meta.version >= map_versions_[part_id]) {
+        pending_updates_[part_id][request.meta.version].push_back(request);
+      } else {
+        waiting_updates_[part_id].push_back(request);
+      }
+    }
+    buffered_requests_.Erase(part_id);
+  }
+  CHECK_EQ(num_local_map_part_, controller_->engine_elem_.partition_manager->GetNumLocalParts(map_collection_id_));
+  CHECK_EQ(num_local_update_part_, controller_->engine_elem_.partition_manager->GetNumLocalParts(update_collection_id_));
+
+  int num_replayed = 0;
+  for (auto& p : update_parts) {
+    num_replayed += delayed_combiner_->ReplayLog(p.first, version);
+  }
+  LOG(INFO) << "[PlanController::RecoverParts] node " << node_id << " restarts " << local_update_parts.size()
+    << " update parts from version " << version << ", replayed " << num_replayed << " joins";
+
+  TryRunSomeMaps();
+  for (int part_id : local_update_parts) {
+    TryRunWaitingJoins(part_id);
+  }
+}
+
+void PlanController::ReceiveSpeculativeMap(Message msg) {
   CHECK_EQ(msg.data.size(), 5);
   SArrayBinStream ctrl2_bin, bin1, bin2;
   ctrl2_bin.FromSArray(msg.data[2]);
@@ -1108,13 +1367,19 @@ void PlanController::MigratePartitionReceiveMapOnly(Message msg) {
   int map_version;
   bin1 >> map_version;
 
+  if (running_maps_.find(migrate_meta.partition_id) != running_maps_.end()) {
+    LOG(INFO) << "[PlanController::ReceiveSpeculativeMap] still running the last copy, ignore: "
+      << migrate_meta.DebugString();
+    return;
+  }
   auto& func = controller_->engine_elem_.function_store
       ->GetCreatePart(migrate_meta.collection_id);
   auto p = func();
   p->id = migrate_meta.partition_id;
   p->FromBin(bin2);  // now I serialize in the controller thread
 
-  LOG(INFO) << "MigratePartitionReceiveMapOnly";
+  LOG(INFO) << "[PlanController::ReceiveSpeculativeMap] run: " << migrate_meta.DebugString() << ", version: " << map_version;
+  // the part is not local, FinishMap will not report it
   RunMap(migrate_meta.partition_id, map_version, p);
 }
 
@@ -1143,14 +1408,40 @@ void PlanController::DisplayTime() {
   LOG(INFO) << "avg map time: " << avg_map_time << " ,avg map serialization time: " << avg_map_stime << " ,avg update time: " << avg_update_time;
 } 
 
-void PlanController::CalcJoinTrackerSize() {
+void PlanController::DisplayShuffleBytes() {
+  size_t local = local_shuffle_bytes_;
+  size_t remote = remote_shuffle_bytes_;
+  double ratio = (local + remote) == 0 ? 0 : static_cast<double>(local) / (local + remote);
+  LOG(INFO) << "[PlanController] plan " << plan_id_ << " on node " << controller_->engine_elem_.node.id
+      << ", local shuffle bytes: " << local << ", remote shuffle bytes: " << remote
+      << ", local ratio: " << ratio;
+}
+
+std::unique_lock<std::mutex> PlanController::LockShard(int part_id) {
+  return std::unique_lock<std::mutex>(shard_mu_[part_id % NumShards()]);
+}
+
+// in the shard order, a shard handler only holds the lock of its own shard
+std::vector<std::unique_lock<std::mutex>> PlanController::LockAllShards() {
+  std::vector<std::unique_lock<std::mutex>> lks;
+  for (auto& mu : shard_mu_) {
+    lks.emplace_back(mu);
+  }
+  return lks;
+}
+
+JoinTracker& PlanController::GetJoinTracker(int part_id) {
+  return update_tracker_.Insert(part_id, JoinTracker(num_upstream_part_));
+}
+
+// the trackers of the shard of part_id, the other shards may be in use
+void PlanController::CalcJoinTrackerSize(int part_id) {
+  const int shard = update_tracker_.ShardOf(part_id);
   int size = 0;
-  for (const auto& part: update_tracker_) {
-    for (const auto& v: part.second) {
-      size += v.second.size();
-    }
+  for (const auto& part: update_tracker_.GetShard(shard)) {
+    size += part.second.Size();
   }
-  update_tracker_size_.push_back(size);
+  update_tracker_size_[shard].push_back(size);
 }
 
 void PlanController::ShowJoinTrackerSize() {
@@ -1158,13 +1449,17 @@ void PlanController::ShowJoinTrackerSize() {
   int mini = INT_MAX;
   int maxi = INT_MIN;
   int sum = 0;
-  for (auto s : update_tracker_size_) {
-    ss << s << " ";
-    if (s > maxi) maxi = s;
-    if (s < mini) mini = s;
-    sum += s;
+  int num = 0;
+  for (const auto& shard_sizes : update_tracker_size_) {
+    for (auto s : shard_sizes) {
+      ss << s << " ";
+      if (s > maxi) maxi = s;
+      if (s < mini) mini = s;
+      sum += s;
+      num += 1;
+    }
   }
-  float avg = update_tracker_size_.empty() ? -1:sum*1./update_tracker_size_.size();
+  float avg = num == 0 ? -1:sum*1./num;
   LOG(INFO) << "trackersize: min: " << mini << " max: " << maxi << " avg: " << avg << " all: " << ss.str();
 }
 
@@ -10,6 +10,9 @@
 #include "base/message.hpp"
 #include "core/map_output/map_output_stream_store.hpp"
 #include "core/worker/delayed_combiner.hpp"
+#include "core/worker/credit_tracker.hpp"
+#include "core/worker/join_tracker.hpp"
+#include "core/worker/sharded_map.hpp"
 
 namespace xyz {
 
@@ -83,9 +86,30 @@ class PlanController : public AbstractPlanController {
   virtual void FinishFetch(SArrayBinStream bin) override;
   virtual void FinishCheckpoint(SArrayBinStream bin) override;
   virtual void DisplayTime() override;
+  virtual void DisplayShuffleBytes() override;
+  virtual size_t GetLocalShuffleBytes() override { return local_shuffle_bytes_; }
+  virtual size_t GetRemoteShuffleBytes() override { return remote_shuffle_bytes_; }
 
   virtual void MigratePartition(Message msg) override;
   virtual void ReassignMap(SArrayBinStream bin) override;
+  // recovery with the message log
+  virtual void RecoverParts(SArrayBinStream bin) override;
+
+  // flow control
+  virtual void ReceiveCredit(SArrayBinStream bin) override;
+  void GrantCredit(const VersionedShuffleMeta& meta);
+
+  // pipelining, the plan is gated once it receives the ready parts
+  virtual void ReadyParts(SArrayBinStream bin) override;
+
+  virtual void FlushReports() override;
+
+  // the join and fetch handlers (ReceiveJoin, FinishJoin, ReceiveFetchRequest
+  // and FinishFetch) lock the shard of their part and may run in the
+  // controller shards at the same time, the others lock all the shards
+  int NumShards() const { return shard_mu_.size(); }
+  std::unique_lock<std::mutex> LockShard(int part_id);
+  std::vector<std::unique_lock<std::mutex>> LockAllShards();
 
   void TryRunSomeMaps();
 
@@ -93,6 +117,7 @@ class PlanController : public AbstractPlanController {
   bool TryRunWaitingJoins(int part_id);
 
   void ReportFinishPart(ControllerMsg::Flag flag, int part_id, int version);
+  void FlushReportsLocked();
 
   void RunMap(int part_id, int version, std::shared_ptr<AbstractPartition>);
   void RunJoin(VersionedJoinMeta meta);
@@ -101,8 +126,11 @@ class PlanController : public AbstractPlanController {
 
   // checkpoint
   bool TryCheckpoint(int part_id);
+  void WriteCheckpoint(std::shared_ptr<AbstractPartition> part,
+          std::string dest_url, int part_id, int version, bool delta);
 
   bool IsJoinedBefore(const VersionedShuffleMeta& meta);
+  void DropJoin(const VersionedShuffleMeta& meta);
 
   // for migration
   void MigratePartitionStartMigrate(MigrateMeta);
@@ -111,8 +139,8 @@ class PlanController : public AbstractPlanController {
   void FinishLoadWith(SArrayBinStream bin) override;//for load cp in migration
 
   // for speculative execution
-  void MigratePartitionStartMigrateMapOnly(MigrateMeta);
-  void MigratePartitionReceiveMapOnly(Message);
+  void StartSpeculativeMap(MigrateMeta, int version);
+  void ReceiveSpeculativeMap(Message);
  private:
   Controller* controller_;
 
@@ -128,6 +156,8 @@ class PlanController : public AbstractPlanController {
   SpecWrapper::Type type_;
   int checkpoint_interval_;
   std::string checkpoint_path_;
+  int num_delta_checkpoints_ = 0;
+  int num_log_versions_ = 0;
 
   int min_version_;
   int staleness_;
@@ -136,27 +166,37 @@ class PlanController : public AbstractPlanController {
   // part -> version
   std::unordered_map<int, int> map_versions_;
 
-  // part -> version
+  // the locks of the per-part state below, one for each controller shard
+  std::vector<std::mutex> shard_mu_;
+
+  // part -> version, the parts are only added or removed with all the shards locked
   std::unordered_map<int, int> update_versions_;
   // part -> version -> upstream_id (finished)
-  std::unordered_map<int, std::unordered_map<int, std::set<int>>> update_tracker_;
-  std::vector<int> update_tracker_size_;
-  void CalcJoinTrackerSize();
+  ShardedMap<JoinTracker> update_tracker_;
+  // part -> version, the joins before it are done, for the parts here when
+  // the min version goes back in a recovery (RecoverParts)
+  std::unordered_map<int, int> joined_before_;
+  JoinTracker& GetJoinTracker(int part_id);
+  // shard -> the sizes of its trackers
+  std::vector<std::vector<int>> update_tracker_size_;
+  void CalcJoinTrackerSize(int part_id);
   void ShowJoinTrackerSize();
 
   // for map_collection_id_ == update_collection_id_ only?
   // part, version
-  std::unordered_map<int, std::unordered_map<int, std::deque<VersionedJoinMeta>>> pending_updates_;
+  ShardedMap<std::unordered_map<int, std::deque<VersionedJoinMeta>>> pending_updates_;
 
   std::set<int> running_maps_;
-  std::unordered_map<int, int> running_updates_;  // part_id -> upstream_id
+  ShardedMap<int> running_updates_;  // part_id -> upstream_id
   // std::map<int, std::set<int>> running_fetches_;// part_id, <upstream_part_id>
-  std::unordered_map<int, int> running_fetches_;  // part_id, count
+  ShardedMap<int> running_fetches_;  // part_id, count
   // part -> update, some updates are waiting as there is a update writing that part
-  std::unordered_map<int, std::deque<VersionedJoinMeta>> waiting_updates_;
+  ShardedMap<std::deque<VersionedJoinMeta>> waiting_updates_;
 
   std::shared_ptr<Executor> fetch_executor_;
   std::shared_ptr<Executor> map_executor_;
+  // writes the snapshots in the background
+  std::shared_ptr<Executor> checkpoint_executor_;
 
   std::mutex time_mu_;  
   std::map<int, std::tuple<std::chrono::system_clock::time_point, std::chrono::system_clock::time_point, std::chrono::system_clock::time_point>> map_time_;//part id
@@ -176,7 +216,7 @@ class PlanController : public AbstractPlanController {
     int update_version;
     std::unordered_map<int, std::deque<VersionedJoinMeta>> pending_updates;
     std::deque<VersionedJoinMeta> waiting_updates;
-    std::unordered_map<int, std::set<int>> update_tracker;
+    JoinTracker update_tracker;
 
     friend SArrayBinStream& operator<<(xyz::SArrayBinStream& stream, const MigrateData& d) {
       stream << d.map_version << d.update_version << d.pending_updates << d.waiting_updates << d.update_tracker;
@@ -192,13 +232,27 @@ class PlanController : public AbstractPlanController {
       ss << ", update_version: " << update_version;
       ss << ", pending_update size: " << pending_updates.size();
       ss << ", waiting_updates size: " << waiting_updates.size();
-      ss << ", update_tracker size: " << update_tracker.size();
+      ss << ", update_tracker size: " << update_tracker.Size();
       return ss.str();
     }
   };
-  std::map<int, std::vector<VersionedJoinMeta>> buffered_requests_; //part_id -> requests
+  ShardedMap<std::vector<VersionedJoinMeta>> buffered_requests_; //part_id -> requests
   friend class DelayedCombiner;
   std::shared_ptr<DelayedCombiner> delayed_combiner_;
+  // credits of the remote nodes the join messages are sent to
+  std::shared_ptr<CreditTracker> credit_tracker_;
+  // pipelining, only the ready parts of the map collection are mapped when gated
+  bool gated_ = false;
+  std::set<int> ready_parts_;
+  // join message bytes, to see how much copartitioning helps
+  std::atomic<size_t> local_shuffle_bytes_{0};
+  std::atomic<size_t> remote_shuffle_bytes_{0};
+  // the kMap/kJoin reports not sent to the scheduler yet
+  std::mutex report_mu_;
+  SArrayBinStream report_bin_;
+  int num_reports_ = 0;
+  // the fetch-object requests of fetch_collection_id_ go to the FetchServers
+  bool direct_fetch_ = false;
 
   std::mutex migrate_mu_;
 };
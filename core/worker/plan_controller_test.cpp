@@ -3,14 +3,137 @@
 
 #include "core/worker/plan_controller.hpp"
 #include "core/worker/controller.hpp"
+#include "core/worker/delayed_combiner.hpp"
+#include "core/partition/seq_partition.hpp"
+#include "core/map_output/map_output_stream.hpp"
+#include "core/queue_node_map.hpp"
+#include "comm/simple_sender.hpp"
 #include "io/fake_reader.hpp"
 #include "io/fake_writer.hpp"
 
+#include <mutex>
+#include <thread>
+
 namespace xyz {
 namespace {
 
 class TestPlanController : public testing::Test {};
 
+// records the threads FinishJoin and FinishMap run in
+struct FakePlanController : public AbstractPlanController {
+  virtual void Setup(SpecWrapper spec) override {}
+  virtual void StartPlan() override {}
+  virtual void FinishMap(SArrayBinStream bin) override { Record(bin, &map_threads); }
+  virtual void FinishJoin(SArrayBinStream bin) override { Record(bin, &join_threads); }
+  virtual void UpdateVersion(SArrayBinStream bin) override {}
+  virtual void ReceiveJoin(Message msg) override {}
+  virtual void ReceiveFetchRequest(Message msg) override {}
+  virtual void FinishFetch(SArrayBinStream bin) override {}
+  virtual void FinishCheckpoint(SArrayBinStream bin) override {}
+  virtual void MigratePartition(Message msg) override {}
+  virtual void FinishLoadWith(SArrayBinStream bin) override {}
+  virtual void ReassignMap(SArrayBinStream bin) override {}
+  virtual void RecoverParts(SArrayBinStream bin) override {}
+  virtual void ReceiveCredit(SArrayBinStream bin) override {}
+  virtual void ReadyParts(SArrayBinStream bin) override {}
+  virtual void FlushReports() override {}
+  virtual void DisplayTime() override {}
+  virtual void DisplayShuffleBytes() override {}
+  virtual size_t GetLocalShuffleBytes() override { return 0; }
+  virtual size_t GetRemoteShuffleBytes() override { return 0; }
+
+  void Record(SArrayBinStream bin, std::map<int, std::thread::id>* threads) {
+    int part_id;
+    bin >> part_id;
+    std::lock_guard<std::mutex> lk(mu);
+    (*threads)[part_id] = std::this_thread::get_id();
+  }
+  int NumRecorded() {
+    std::lock_guard<std::mutex> lk(mu);
+    return map_threads.size() + join_threads.size();
+  }
+
+  std::mutex mu;
+  std::map<int, std::thread::id> map_threads;
+  std::map<int, std::thread::id> join_threads;
+};
+
+// node 1, map collection 0 with parts {0, 1} on node 1,
+// update collection 1 with part 0 on node 1 and part 1 on the dead node 2
+const int kPlanId = 0;
+const int kNodeId = 1;
+EngineElem MakeRecoverElem() {
+  EngineElem elem;
+  elem.node.id = kNodeId;
+  elem.num_local_threads = 1;
+  elem.num_update_threads = 1;
+  elem.num_combine_threads = 1;
+  elem.report_batch_size = 1;
+  elem.sender = std::make_shared<SimpleSender>();
+  elem.intermediate_store = std::make_shared<SimpleIntermediateStore>();
+  elem.function_store = std::make_shared<FunctionStore>();
+  elem.partition_manager = std::make_shared<PartitionManager>();
+  elem.collection_map = std::make_shared<CollectionMap>();
+  for (int collection_id : {0, 1}) {
+    CollectionView cv;
+    cv.collection_id = collection_id;
+    cv.mapper = SimplePartToNodeMapper(collection_id == 0 ? std::vector<int>{1, 1} : std::vector<int>{1, 2});
+    cv.num_partition = cv.mapper.GetNumParts();
+    elem.collection_map->Insert(cv);
+  }
+  elem.partition_manager->Insert(0, 0, std::make_shared<SeqPartition<int>>());
+  elem.partition_manager->Insert(0, 1, std::make_shared<SeqPartition<int>>());
+  elem.partition_manager->Insert(1, 0, std::make_shared<SeqPartition<int>>());
+  return elem;
+}
+
+SpecWrapper MakeRecoverSpec() {
+  SpecWrapper spec;
+  spec.SetSpec<MapJoinSpec>(kPlanId, SpecWrapper::Type::kMapJoin, 0, 1, -1, 10, 0, 0, "", "");
+  spec.GetMapJoinSpec()->num_log_versions = 2;
+  return spec;
+}
+
+std::shared_ptr<AbstractMapOutputStream> MakeStream(int key, int value) {
+  auto stream = std::make_shared<MapOutputStream<int, int>>();
+  stream->Add({key, value});
+  return stream;
+}
+
+// a join of version from upstream part 0, the version is the payload
+Message MakeJoinMsg(int part_id, int version) {
+  PlanController::VersionedShuffleMeta meta;
+  meta.plan_id = kPlanId;
+  meta.collection_id = 1;
+  meta.part_id = part_id;
+  meta.upstream_part_id = 0;
+  meta.version = version;
+  Message msg;
+  SArrayBinStream ctrl_bin, plan_bin, ctrl2_bin, bin;
+  ctrl_bin << ControllerFlag::kReceiveJoin;
+  plan_bin << kPlanId;
+  ctrl2_bin << meta;
+  bin << version;
+  msg.AddData(ctrl_bin.ToSArray());
+  msg.AddData(plan_bin.ToSArray());
+  msg.AddData(ctrl2_bin.ToSArray());
+  msg.AddData(bin.ToSArray());
+  return msg;
+}
+
+Message MakeControllerMsg(ControllerFlag flag, int plan_id, int part_id) {
+  Message msg;
+  msg.meta.flag = Flag::kOthers;
+  SArrayBinStream ctrl_bin, plan_bin, bin;
+  ctrl_bin << flag;
+  plan_bin << plan_id;
+  bin << part_id;
+  msg.AddData(ctrl_bin.ToSArray());
+  msg.AddData(plan_bin.ToSArray());
+  msg.AddData(bin.ToSArray());
+  return msg;
+}
+
 TEST_F(TestPlanController, Create) {
   int qid = 0;
   EngineElem elem;
@@ -23,5 +146,116 @@ TEST_F(TestPlanController, Create) {
   PlanController plan_controller(&controller);
 }
 
+TEST_F(TestPlanController, ControllerShards) {
+  EngineElem elem;
+  elem.num_controller_shards = 2;
+  elem.report_batch_size = 1;
+  auto io_wrapper = std::make_shared<IOWrapper>(
+      []() { return std::make_shared<FakeReader>(); },
+      []() { return std::make_shared<FakeWriter>(); });
+  Controller controller(0, elem, io_wrapper);
+  ASSERT_EQ(controller.GetShards().size(), 2);
+  auto plan_controller = std::make_shared<FakePlanController>();
+  controller.plan_controllers_[0] = plan_controller;
+
+  for (int part_id = 0; part_id < 4; ++ part_id) {
+    controller.GetWorkQueue()->Push(MakeControllerMsg(ControllerFlag::kFinishJoin, 0, part_id));
+  }
+  controller.GetWorkQueue()->Push(MakeControllerMsg(ControllerFlag::kFinishMap, 0, 0));
+  while (plan_controller->NumRecorded() < 5) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  controller.WaitShardsIdle();
+
+  // the joins run in the shard of their part, the map in the controller thread
+  auto& joins = plan_controller->join_threads;
+  EXPECT_EQ(joins[0], joins[2]);
+  EXPECT_EQ(joins[1], joins[3]);
+  EXPECT_NE(joins[0], joins[1]);
+  EXPECT_NE(plan_controller->map_threads[0], joins[0]);
+  EXPECT_NE(plan_controller->map_threads[0], joins[1]);
+  EXPECT_EQ(controller.GetShardQueueDepths(), std::vector<int>({0, 0}));
+  EXPECT_EQ(controller.GetShards()[0]->GetNumProcessed(), 2);
+  EXPECT_EQ(controller.GetShards()[1]->GetNumProcessed(), 2);
+}
+
+TEST_F(TestPlanController, ReplayLog) {
+  auto elem = MakeRecoverElem();
+  auto io_wrapper = std::make_shared<IOWrapper>(
+      []() { return std::make_shared<FakeReader>(); },
+      []() { return std::make_shared<FakeWriter>(); });
+  Controller controller(GetControllerActorQid(kNodeId), elem, io_wrapper);
+  PlanController plan_controller(&controller);
+  plan_controller.Setup(MakeRecoverSpec());
+
+  DelayedCombiner combiner(&plan_controller, -1, 2);
+  // nothing is sent to part 1 in version 1 and 2
+  combiner.AddStream(0, 0, 1, MakeStream(1, 0));
+  combiner.AddStream(0, 3, 1, MakeStream(1, 3));
+  combiner.TrimLog(3);
+  // the log is trimmed to version 1 while the first entry is of version 3
+  EXPECT_EQ(combiner.ReplayLog(1, 1), 1);
+
+  auto msgs = static_cast<SimpleIntermediateStore*>(elem.intermediate_store.get())->Get();
+  ASSERT_EQ(msgs.size(), 3);
+  EXPECT_EQ(msgs[2].meta.recver, GetControllerActorQid(2));
+  SArrayBinStream ctrl2_bin;
+  ctrl2_bin.FromSArray(msgs[2].data[2]);
+  PlanController::VersionedShuffleMeta meta;
+  ctrl2_bin >> meta;
+  EXPECT_EQ(meta.part_id, 1);
+  EXPECT_EQ(meta.version, 3);
+  EXPECT_EQ(meta.ext_upstream_part_ids, std::vector<int>({0}));
+  EXPECT_FALSE(meta.local_mode);
+}
+
+TEST_F(TestPlanController, RecoverParts) {
+  auto elem = MakeRecoverElem();
+  std::mutex mu;
+  // part_id, version
+  std::vector<std::pair<int, int>> joins;
+  elem.function_store->AddJoin(kPlanId, [&mu, &joins](std::shared_ptr<AbstractPartition> p, SArrayBinStream bin) {
+    int version;
+    bin >> version;
+    std::lock_guard<std::mutex> lk(mu);
+    joins.push_back({p->id, version});
+  });
+  auto io_wrapper = std::make_shared<IOWrapper>(
+      []() { return std::make_shared<FakeReader>(); },
+      []() { return std::make_shared<FakeWriter>(); });
+  Controller controller(GetControllerActorQid(kNodeId), elem, io_wrapper);
+  PlanController plan_controller(&controller);
+  plan_controller.Setup(MakeRecoverSpec());
+  // gated without ready parts, so that no map runs
+  SArrayBinStream ready_bin;
+  ready_bin << std::vector<int>();
+  plan_controller.ReadyParts(ready_bin);
+  for (int version : {1, 2}) {
+    SArrayBinStream bin;
+    bin << version;
+    plan_controller.UpdateVersion(bin);
+  }
+
+  // node 2 fails, its update part 1 restarts here from version 1
+  elem.partition_manager->Insert(1, 1, std::make_shared<SeqPartition<int>>());
+  SArrayBinStream recover_bin;
+  recover_bin << 1 << std::set<int>{2}
+    << std::vector<std::pair<int, int>>{{1, kNodeId}} << std::vector<std::pair<int, int>>();
+  plan_controller.RecoverParts(recover_bin);
+
+  // part 0 has joined version 1 before the recovery, drop it
+  plan_controller.ReceiveJoin(MakeJoinMsg(0, 1));
+  plan_controller.ReceiveJoin(MakeJoinMsg(1, 1));
+  plan_controller.ReceiveJoin(MakeJoinMsg(0, 2));
+  while (true) {
+    std::lock_guard<std::mutex> lk(mu);
+    if (joins.size() == 2) {
+      break;
+    }
+  }
+  std::sort(joins.begin(), joins.end());
+  EXPECT_EQ(joins, (std::vector<std::pair<int, int>>{{0, 2}, {1, 1}}));
+}
+
 } // namespace
 } // namespace xyz
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace xyz {
+
+/*
+ * A part_id -> V map split into num_shards unordered_maps by part_id % num_shards.
+ *
+ * The parts of different shards can be touched by different threads at the
+ * same time, each one holding the lock of its shard (see PlanController).
+ * Only the total size is shared, it is atomic so that Empty() can be
+ * called from any shard.
+ */
+template <typename V>
+class ShardedMap {
+ public:
+  using Map = std::unordered_map<int, V>;
+
+  explicit ShardedMap(int num_shards = 1) : shards_(num_shards) {
+    CHECK_GT(num_shards, 0);
+  }
+
+  int NumShards() const { return shards_.size(); }
+  int ShardOf(int part_id) const { return part_id % shards_.size(); }
+  Map& GetShard(int shard) { return shards_[shard]; }
+
+  V& operator[](int part_id) {
+    auto& m = shards_[ShardOf(part_id)];
+    const size_t size = m.size();
+    V& v = m[part_id];
+    size_ += m.size() - size;
+    return v;
+  }
+  // insert v if part_id is not there, like emplace
+  V& Insert(int part_id, V v) {
+    auto& m = shards_[ShardOf(part_id)];
+    auto ret = m.emplace(part_id, std::move(v));
+    if (ret.second) {
+      size_ += 1;
+    }
+    return ret.first->second;
+  }
+  bool Has(int part_id) const {
+    const auto& m = shards_[ShardOf(part_id)];
+    return m.find(part_id) != m.end();
+  }
+  void Erase(int part_id) {
+    size_ -= shards_[ShardOf(part_id)].erase(part_id);
+  }
+  void Clear() {
+    for (auto& m : shards_) {
+      m.clear();
+    }
+    size_ = 0;
+  }
+  size_t Size() const { return size_.load(); }
+  bool Empty() const { return size_.load() == 0; }
+
+ private:
+  std::vector<Map> shards_;
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace xyz
@@ -0,0 +1,47 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "core/worker/sharded_map.hpp"
+
+namespace xyz {
+namespace {
+
+class TestShardedMap : public testing::Test {};
+
+TEST_F(TestShardedMap, Shard) {
+  ShardedMap<int> m(3);
+  EXPECT_EQ(m.NumShards(), 3);
+  EXPECT_TRUE(m.Empty());
+  m[1] = 10;
+  m[4] += 1;
+  m[2] = 20;
+  EXPECT_EQ(m.Size(), 3);
+  EXPECT_TRUE(m.Has(4));
+  EXPECT_FALSE(m.Has(0));
+  // part 1 and part 4 are in shard 1
+  EXPECT_EQ(m.ShardOf(4), 1);
+  EXPECT_EQ(m.GetShard(1).size(), 2);
+  EXPECT_EQ(m.GetShard(2).size(), 1);
+  EXPECT_EQ(m.GetShard(0).size(), 0);
+  EXPECT_EQ(m[4], 1);
+  EXPECT_EQ(m.Size(), 3);
+}
+
+TEST_F(TestShardedMap, InsertErase) {
+  ShardedMap<int> m(2);
+  EXPECT_EQ(m.Insert(3, 1), 1);
+  // already there
+  EXPECT_EQ(m.Insert(3, 2), 1);
+  EXPECT_EQ(m.Size(), 1);
+  m.Erase(3);
+  m.Erase(5);
+  EXPECT_TRUE(m.Empty());
+  m[0] = 1;
+  m[1] = 1;
+  m.Clear();
+  EXPECT_TRUE(m.Empty());
+  EXPECT_FALSE(m.Has(0));
+}
+
+}  // namespace
+}  // namespace xyz
@@ -5,7 +5,7 @@
 #include <tuple>
 
 #include "base/color.hpp"
-#include "boost/tokenizer.hpp"
+#include "base/tokenizer.hpp"
 #include "core/index/hash_key_to_part_mapper.hpp"
 #include "core/plan/runner.hpp"
 #include "gflags/gflags.h"
@@ -266,6 +266,26 @@ struct Matcher {
   }
 };
 
+// Skip the whitespace and take the first char of the next token as the label,
+// *s is advanced past the token.
+static bool NextLabel(boost::string_ref *s, char *label) {
+  size_t i = 0;
+  while (i < s->size() && ((*s)[i] == ' ' || (*s)[i] == '\t' ||
+                           (*s)[i] == '\r' || (*s)[i] == '\n')) {
+    ++i;
+  }
+  if (i == s->size()) {
+    return false;
+  }
+  *label = (*s)[i];
+  while (i < s->size() && (*s)[i] != ' ' && (*s)[i] != '\t' &&
+         (*s)[i] != '\r' && (*s)[i] != '\n') {
+    ++i;
+  }
+  s->remove_prefix(i);
+  return true;
+}
+
 int main(int argc, char **argv) {
   Runner::Init(argc, argv);
   const int num_graph_parts = FLAGS_num_graph_parts;
@@ -289,21 +309,15 @@ int main(int argc, char **argv) {
   CHECK_EQ(pattern.GetRound(2).size(), 1);
   CHECK_EQ(pattern.GetRound(3).size(), 1);
 
-  // dataset from file
-  auto dataset = Context::load(FLAGS_url, [](std::string s) {
-                   boost::char_separator<char> sep(" \t");
-                   boost::tokenizer<boost::char_separator<char>> tok(s, sep);
-                   boost::tokenizer<boost::char_separator<char>>::iterator it =
-                       tok.begin();
-
-                   int id = std::stoi(*(it++));
-                   char label = *(it->begin());
-                   it++;
+  // dataset from file, "id label id label ..."
+  auto dataset = Context::load(FLAGS_url, [](boost::string_ref s) {
+                   int id;
+                   char label;
+                   CHECK(NextInt(&s, &id));
+                   CHECK(NextLabel(&s, &label));
                    Vertex obj(id, label);
-                   while (it != tok.end()) {
-                     id = std::stoi(*(it++));
-                     label = *(it->begin());
-                     it++;
+                   while (NextInt(&s, &id)) {
+                     CHECK(NextLabel(&s, &label));
                      obj.outlinks.push_back(Vertex(id, label));
                    }
                    return obj;
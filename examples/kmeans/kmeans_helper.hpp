@@ -1,5 +1,5 @@
 #include "base/color.hpp"
-#include "boost/tokenizer.hpp"
+#include "base/tokenizer.hpp"
 #include "core/plan/runner.hpp"
 
 #include <cmath>
@@ -84,29 +84,13 @@ struct Param {
 
 static auto *load_data() {
   return Context::load(FLAGS_url,
-                       [](std::string s) {
+                       [](boost::string_ref s) {
                          Point point;
-                         char *pos;
-                         char *tok = strtok_r(&s[0], " \t:", &pos);
-                         int i = -1;
-                         int idx;
-                         float val;
-                         while (tok != NULL) {
-                           if (i == 0) {
-                             idx = std::atoi(tok) - 1;
-                             i = 1;
-                           } else if (i == 1) {
-                             val = std::atof(tok);
-                             point.x.push_back(std::make_pair(idx, val));
-                             i = 0;
-                           } else {
-                             point.y = std::atof(tok);
-                             i = 0;
-                           }
-                           // Next key/value pair
-                           tok = strtok_r(NULL, " \t:", &pos);
+                         point.y = ParseLibsvm(s, &point.x);
+                         // the features are 1-based
+                         for (auto &fea_val : point.x) {
+                           fea_val.first -= 1;
                          }
-
                          return point;
                        },
                        FLAGS_max_lines_per_part)
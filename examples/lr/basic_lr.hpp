@@ -1,5 +1,5 @@
 #include "base/color.hpp"
-#include "boost/tokenizer.hpp"
+#include "base/tokenizer.hpp"
 #include "core/plan/runner.hpp"
 
 #include "core/index/range_key_to_part_mapper.hpp"
@@ -110,51 +110,13 @@ struct DenseRow {
 
 static auto *load_data() {
   return Context::load(FLAGS_url,
-                       [](std::string s) {
+                       [](boost::string_ref s) {
                          Point point;
-                         /*
-                         boost::char_separator<char> sep(" \t");
-                         boost::tokenizer<boost::char_separator<char>> tok(s,
-                         sep);
-                         boost::tokenizer<boost::char_separator<char>>::iterator
-                         it = tok.begin();
-
-                         point.y = std::stoi(*it);
-                         it ++;
-                         for (; it != tok.end(); ++it) {
-                           std::vector<std::string> fea_val;
-                           std::istringstream ss2(*it);
-                           std::string token;
-                           while (std::getline(ss2, token, ':')) {
-                             fea_val.push_back(token);
-                           }
-                           CHECK_EQ(fea_val.size(), 2);
-                           int fea = std::stoi(fea_val[0]);
-                           float val = std::stof(fea_val[1]);
-                           point.x.push_back(std::make_pair(fea, val));
-                         }
-                         */
-                         char *pos;
-                         char *tok = strtok_r(&s[0], " \t:", &pos);
-                         int i = -1;
-                         int idx;
-                         float val;
-                         while (tok != NULL) {
-                           if (i == 0) {
-                             idx = std::atoi(tok) - 1;
-                             i = 1;
-                           } else if (i == 1) {
-                             val = std::atof(tok);
-                             point.x.push_back(std::make_pair(idx, val));
-                             i = 0;
-                           } else {
-                             point.y = std::atof(tok);
-                             i = 0;
-                           }
-                           // Next key/value pair
-                           tok = strtok_r(NULL, " \t:", &pos);
+                         point.y = ParseLibsvm(s, &point.x);
+                         // the features are 1-based
+                         for (auto &fea_val : point.x) {
+                           fea_val.first -= 1;
                          }
-
                          return point;
                        },
                        FLAGS_max_lines_per_part)
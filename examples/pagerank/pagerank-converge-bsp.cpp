@@ -1,4 +1,4 @@
-#include "boost/tokenizer.hpp"
+#include "base/tokenizer.hpp"
 #include "core/plan/runner.hpp"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
@@ -68,19 +68,12 @@ int main(int argc, char **argv) {
   }
 
   auto loaded_dataset =
-      Context::load(FLAGS_url, [](std::string s) {
+      Context::load(FLAGS_url, [](boost::string_ref s) {
         Vertex v;
-        boost::char_separator<char> sep(" \t");
-        boost::tokenizer<boost::char_separator<char>> tok(s, sep);
-        boost::tokenizer<boost::char_separator<char>>::iterator it =
-            tok.begin();
-
-        v.vertex = std::stoi(*it++);
-        it++;
-        while (it != tok.end()) {
-          v.outlinks.push_back(std::stoi(*it++));
-        }
-
+        int num_outlinks;
+        CHECK(NextInt(&s, &v.vertex));
+        CHECK(NextInt(&s, &num_outlinks));
+        ParseInts(s, &v.outlinks);
         return v;
       })->SetName("dataset");
 
@@ -5,6 +5,7 @@
 #include "comm/sender.hpp"
 #include "core/scheduler/scheduler.hpp"
 #include "io/assigner.hpp"
+#include "io/browser_wrapper.hpp"
 #include "io/hdfs_browser.hpp"
 
 DEFINE_int32(num_worker, -1, "The number of workers");
@@ -12,8 +13,20 @@ DEFINE_string(scheduler, "proj10", "The host of scheduler");
 DEFINE_int32(scheduler_port, -1, "The port of scheduler");
 DEFINE_string(hdfs_namenode, "proj10", "The namenode of hdfs");
 DEFINE_int32(hdfs_port, 9000, "The port of hdfs");
+DEFINE_int32(num_io_threads, 1, "# zmq io threads");
+DEFINE_int32(num_sender_threads, 1, "# sender threads");
+DEFINE_int32(num_recv_sockets, 1, "# receive sockets, must be the same as the workers'");
+DEFINE_bool(separate_bulk_sockets, false, "send bulk traffic through its own sockets");
+DEFINE_bool(use_ipc, false, "use ipc:// for the nodes on the same host, must be the same as the workers'");
 
-DEFINE_string(dag_runner_type, "sequential", "");
+DEFINE_string(dag_runner_type, "sequential", "sequential, wide, pipelined");
+DEFINE_string(lb_policy, "none", "load balancing policy: none, straggler");
+DEFINE_double(speculation_factor, 0, "re-run a map partition elsewhere if it runs this times longer than the median, <=0 to disable");
+DEFINE_bool(spread_recovery, true, "spread the partitions of a dead node over the live nodes, otherwise move them together to one node");
+DEFINE_double(heartbeat_phi_threshold, 8, "a worker is dead once the phi of its heartbeats reaches this");
+DEFINE_double(heartbeat_min_std_dev, 0.5, "lower bound (s) of the std dev of the heartbeat intervals");
+DEFINE_double(heartbeat_acceptable_pause, 3, "pause (s) of the heartbeats tolerated on top of their intervals");
+DEFINE_int32(heartbeat_check_interval, 0, "check for dead workers every this many seconds, <=0 to only check when a worker registers");
 
 namespace xyz {
 
@@ -21,20 +34,30 @@ void RunScheduler() {
   Node scheduler_node{0, FLAGS_scheduler, FLAGS_scheduler_port, false};
 
   // create mailbox and sender
-  auto scheduler_mailbox =
-      std::make_shared<SchedulerMailbox>(scheduler_node, FLAGS_num_worker);
-  auto sender = std::make_shared<Sender>(-1, scheduler_mailbox.get());
+  PhiAccrualFailureDetector::Config detector_config;
+  detector_config.threshold = FLAGS_heartbeat_phi_threshold;
+  detector_config.min_std_dev = FLAGS_heartbeat_min_std_dev;
+  detector_config.acceptable_pause = FLAGS_heartbeat_acceptable_pause;
+  auto scheduler_mailbox = std::make_shared<SchedulerMailbox>(
+      scheduler_node, FLAGS_num_worker, FLAGS_num_io_threads,
+      FLAGS_num_recv_sockets, FLAGS_separate_bulk_sockets, FLAGS_use_ipc,
+      detector_config, FLAGS_heartbeat_check_interval);
+  auto sender = std::make_shared<Sender>(-1, scheduler_mailbox.get(),
+                                         FLAGS_num_sender_threads);
 
   // create scheduler and register queue
   const int id = 0;
   const std::string namenode = FLAGS_hdfs_namenode;
   const int port = FLAGS_hdfs_port;
   auto assigner_builder = [sender, namenode, port]() {
-    auto browser = std::make_shared<HDFSBrowser>(namenode, port);
+    auto browser = std::make_shared<BrowserWrapper>([namenode, port]() {
+      return std::make_shared<HDFSBrowser>(namenode, port);
+    });
     auto assigner = std::make_shared<Assigner>(sender, browser);
     return assigner;
   };
-  Scheduler scheduler(id, sender, assigner_builder, FLAGS_dag_runner_type);
+  Scheduler scheduler(id, sender, assigner_builder, FLAGS_dag_runner_type,
+                      FLAGS_lb_policy, FLAGS_speculation_factor, FLAGS_spread_recovery);
   scheduler_mailbox->RegisterQueue(id, scheduler.GetWorkQueue());
 
   // start mailbox
@@ -1,4 +1,4 @@
-#include "boost/tokenizer.hpp"
+#include "base/tokenizer.hpp"
 #include "core/plan/runner.hpp"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
@@ -53,19 +53,12 @@ int main(int argc, char **argv) {
   }
 
   auto loaded_dataset =
-      Context::load(FLAGS_url, [](std::string s) {
+      Context::load(FLAGS_url, [](boost::string_ref s) {
         Vertex v;
-        boost::char_separator<char> sep(" \t");
-        boost::tokenizer<boost::char_separator<char>> tok(s, sep);
-        boost::tokenizer<boost::char_separator<char>>::iterator it =
-            tok.begin();
-
-        v.id = std::stoi(*it++);
-        it++;
-        while (it != tok.end()) {
-          v.outlinks.push_back(std::stoi(*it++));
-        }
-
+        int num_outlinks;
+        CHECK(NextInt(&s, &v.id));
+        CHECK(NextInt(&s, &num_outlinks));
+        ParseInts(s, &v.outlinks);
         return v;
       })->SetName("dataset");
 
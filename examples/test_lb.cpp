@@ -32,6 +32,9 @@ void mr() {
   }
   auto c1 = Context::distribute(seed, num_map_part);
   auto c2 = Context::placeholder<ObjT>(num_update_part);
+  // part i of c2 is on the node of part i of c1, see the local shuffle
+  // bytes logged by the scheduler
+  Context::copartition(c2, c1);
 
   // mapupdate
   Context::mapupdate(
@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 
+#include "boost/utility/string_ref.hpp"
+
 namespace xyz {
 
 class AbstractBlockReader {
@@ -27,6 +29,8 @@ public:
   // Iterator based api.
   virtual bool HasLine() = 0;
   virtual std::string GetLine() = 0;
+  // the line without copying it, valid until the next HasLine
+  virtual boost::string_ref GetLineView() = 0;
   virtual int GetNumLineRead() = 0;
 };
 
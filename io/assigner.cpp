@@ -135,6 +135,7 @@ bool Assigner::Assign(int collection_id, std::pair<std::string, int> slave) {
   msg.meta.sender = 0;
   msg.meta.recver = GetWorkerQid(slave.second);
   msg.meta.flag = Flag::kOthers;
+  msg.meta.traffic_class = TrafficClass::kControl;
   msg.AddData(ctrl_bin.ToSArray());
   msg.AddData(bin.ToSArray());
   sender_->Send(std::move(msg));
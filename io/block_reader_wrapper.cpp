@@ -0,0 +1,45 @@
+#include "io/block_reader_wrapper.hpp"
+
+#include "glog/logging.h"
+
+#include "io/local_block_reader.hpp"
+#include "io/local_url.hpp"
+
+namespace xyz {
+
+void BlockReaderWrapper::Init(std::string url, size_t offset) {
+  if (IsLocalUrl(url)) {
+    block_reader_ = std::make_shared<LocalBlockReader>();
+  } else {
+    CHECK(hdfs_block_reader_getter_) << "no block reader for url: " << url;
+    block_reader_ = hdfs_block_reader_getter_();
+  }
+  block_reader_->Init(url, offset);
+}
+
+std::vector<std::string> BlockReaderWrapper::ReadBlock() {
+  CHECK(block_reader_) << "call Init first";
+  return block_reader_->ReadBlock();
+}
+
+bool BlockReaderWrapper::HasLine() {
+  CHECK(block_reader_) << "call Init first";
+  return block_reader_->HasLine();
+}
+
+std::string BlockReaderWrapper::GetLine() {
+  CHECK(block_reader_) << "call Init first";
+  return block_reader_->GetLine();
+}
+
+boost::string_ref BlockReaderWrapper::GetLineView() {
+  CHECK(block_reader_) << "call Init first";
+  return block_reader_->GetLineView();
+}
+
+int BlockReaderWrapper::GetNumLineRead() {
+  CHECK(block_reader_) << "call Init first";
+  return block_reader_->GetNumLineRead();
+}
+
+} // namespace xyz
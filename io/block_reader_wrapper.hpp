@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "io/abstract_block_reader.hpp"
+
+namespace xyz {
+
+// Read a block of a file:// url with the LocalBlockReader and the others
+// with the block reader from hdfs_block_reader_getter.
+class BlockReaderWrapper : public AbstractBlockReader {
+public:
+  BlockReaderWrapper(
+      std::function<std::shared_ptr<AbstractBlockReader>()> hdfs_block_reader_getter)
+      : hdfs_block_reader_getter_(hdfs_block_reader_getter) {}
+
+  virtual void Init(std::string url, size_t offset) override;
+  virtual std::vector<std::string> ReadBlock() override;
+
+  virtual bool HasLine() override;
+  virtual std::string GetLine() override;
+  virtual boost::string_ref GetLineView() override;
+  virtual int GetNumLineRead() override;
+
+private:
+  std::function<std::shared_ptr<AbstractBlockReader>()> hdfs_block_reader_getter_;
+  std::shared_ptr<AbstractBlockReader> block_reader_;
+};
+
+} // namespace xyz
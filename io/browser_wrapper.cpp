@@ -0,0 +1,21 @@
+#include "io/browser_wrapper.hpp"
+
+#include "glog/logging.h"
+
+#include "io/local_browser.hpp"
+#include "io/local_url.hpp"
+
+namespace xyz {
+
+std::vector<BlockInfo> BrowserWrapper::Browse(std::string url) {
+  if (IsLocalUrl(url)) {
+    return LocalBrowser().Browse(url);
+  }
+  if (!hdfs_browser_) {
+    CHECK(hdfs_browser_getter_) << "no browser for url: " << url;
+    hdfs_browser_ = hdfs_browser_getter_();
+  }
+  return hdfs_browser_->Browse(url);
+}
+
+} // namespace xyz
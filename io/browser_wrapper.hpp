@@ -0,0 +1,24 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "io/abstract_browser.hpp"
+
+namespace xyz {
+
+// Browse a file:// url with the LocalBrowser and the others with the
+// browser from hdfs_browser_getter, which is created only if needed, so a
+// job with local files only does not connect to hdfs.
+class BrowserWrapper : public AbstractBrowser {
+public:
+  BrowserWrapper(std::function<std::shared_ptr<AbstractBrowser>()> hdfs_browser_getter)
+      : hdfs_browser_getter_(hdfs_browser_getter) {}
+  virtual std::vector<BlockInfo> Browse(std::string url) override;
+
+private:
+  std::function<std::shared_ptr<AbstractBrowser>()> hdfs_browser_getter_;
+  std::shared_ptr<AbstractBrowser> hdfs_browser_;
+};
+
+} // namespace xyz
@@ -14,6 +14,7 @@ public:
   virtual void Init(std::string url, size_t offset) {}
   virtual bool HasLine() {}
   virtual std::string GetLine() {}
+  virtual boost::string_ref GetLineView() { return {}; }
   virtual int GetNumLineRead() {}
 };
 
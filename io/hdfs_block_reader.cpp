@@ -22,6 +22,12 @@ std::string HdfsBlockReader::GetLine() {
   }
   return tmp_line_.to_string();
 }
+boost::string_ref HdfsBlockReader::GetLineView() {
+  // tmp_line_ points into data_ or last_part_, which are only changed by
+  // the next HasLine
+  tmp_line_count_ += 1;
+  return tmp_line_;
+}
 int HdfsBlockReader::GetNumLineRead() { return tmp_line_count_; }
 
 std::vector<std::string> HdfsBlockReader::ReadBlock() {
@@ -23,6 +23,7 @@ public:
   virtual void Init(std::string url, size_t offset) override;
   virtual bool HasLine() override;
   virtual std::string GetLine() override;
+  virtual boost::string_ref GetLineView() override;
   virtual int GetNumLineRead() override;
 
 private:
@@ -0,0 +1,95 @@
+#include "io/local_block_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+
+#include "io/local_url.hpp"
+
+namespace xyz {
+
+const size_t LocalBlockReader::kDefaultBlockSize;
+
+LocalBlockReader::~LocalBlockReader() {
+  if (map_) {
+    munmap(map_, map_size_);
+  }
+}
+
+void LocalBlockReader::Init(std::string url, size_t offset) {
+  CHECK(map_ == nullptr) << "Init twice";
+  std::string path = GetLocalPath(url);
+  int fd = open(path.c_str(), O_RDONLY);
+  CHECK_GE(fd, 0) << "cannot open file: " << path;
+  struct stat st;
+  CHECK_EQ(fstat(fd, &st), 0) << "cannot stat file: " << path;
+  const size_t file_size = st.st_size;
+  CHECK_LE(offset, file_size) << path;
+  if (offset == file_size) {
+    close(fd);
+    return;
+  }
+
+  // mmap from the page of the offset to the end of the file, the last line
+  // may cross the end of the block
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t map_offset = offset / page_size * page_size;
+  map_size_ = file_size - map_offset;
+  void *addr = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, map_offset);
+  close(fd);
+  CHECK(addr != MAP_FAILED) << "cannot mmap file: " << path;
+  map_ = static_cast<char *>(addr);
+  madvise(map_, map_size_, MADV_SEQUENTIAL);
+  madvise(map_, std::min(map_size_, offset - map_offset + block_size_),
+          MADV_WILLNEED);
+
+  data_ = map_ + (offset - map_offset);
+  size_ = file_size - offset;
+  pos_ = 0;
+  if (offset > 0) {
+    // the first line belongs to the previous block
+    auto nl = static_cast<const char *>(memchr(data_, '\n', size_));
+    pos_ = nl ? nl - data_ + 1 : size_;
+  }
+}
+
+bool LocalBlockReader::HasLine() {
+  // the line starting right at the end of the block is still ours, the
+  // next block skips it
+  if (pos_ >= size_ || pos_ > block_size_) {
+    return false;
+  }
+  auto nl = static_cast<const char *>(memchr(data_ + pos_, '\n', size_ - pos_));
+  size_t end = nl ? nl - data_ : size_;
+  line_ = boost::string_ref(data_ + pos_, end - pos_);
+  pos_ = end + 1;
+  return true;
+}
+
+std::string LocalBlockReader::GetLine() {
+  num_line_read_ += 1;
+  return line_.to_string();
+}
+
+boost::string_ref LocalBlockReader::GetLineView() {
+  num_line_read_ += 1;
+  return line_;
+}
+
+int LocalBlockReader::GetNumLineRead() { return num_line_read_; }
+
+std::vector<std::string> LocalBlockReader::ReadBlock() {
+  std::vector<std::string> ret;
+  while (HasLine()) {
+    ret.push_back(GetLine());
+  }
+  LOG(INFO) << ret.size() << " lines read.";
+  return ret;
+}
+
+} // namespace xyz
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "io/abstract_block_reader.hpp"
+
+#include "boost/utility/string_ref.hpp"
+
+namespace xyz {
+
+/*
+ * Read the lines of a block of a local file.
+ *
+ * The file is mmap-ed from the block on and the lines point into the
+ * mapping, GetLineView copies nothing. Like the hdfs blocks, a block
+ * at offset > 0 skips its first (partial) line and reads the line
+ * crossing its end, so every line is read by exactly one block.
+ *
+ * The block size must be the same as the LocalBrowser's.
+ */
+class LocalBlockReader : public AbstractBlockReader {
+public:
+  static const size_t kDefaultBlockSize = 64 << 20;
+
+  explicit LocalBlockReader(size_t block_size = kDefaultBlockSize)
+      : block_size_(block_size) {}
+  ~LocalBlockReader();
+
+  virtual void Init(std::string url, size_t offset) override;
+  virtual std::vector<std::string> ReadBlock() override;
+
+  virtual bool HasLine() override;
+  virtual std::string GetLine() override;
+  virtual boost::string_ref GetLineView() override;
+  virtual int GetNumLineRead() override;
+
+private:
+  const size_t block_size_;
+
+  char *map_ = nullptr;
+  size_t map_size_ = 0;
+  // the block in the mapping, to the end of the file
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  // the start of the next line in data_
+  size_t pos_ = 0;
+
+  boost::string_ref line_;
+  int num_line_read_ = 0;
+};
+
+} // namespace xyz
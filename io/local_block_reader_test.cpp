@@ -0,0 +1,76 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <unistd.h>
+
+#include "io/local_block_reader.hpp"
+#include "io/local_browser.hpp"
+#include "io/local_writer.hpp"
+
+namespace xyz {
+namespace {
+
+class TestLocalBlockReader : public testing::Test {};
+
+// read all the blocks of the url
+std::vector<std::string> ReadAll(std::string url, size_t block_size, int* num_blocks) {
+  LocalBrowser browser(block_size);
+  auto blocks = browser.Browse(url);
+  *num_blocks = blocks.size();
+  std::vector<std::string> lines;
+  for (auto& block : blocks) {
+    LocalBlockReader reader(block_size);
+    reader.Init(block.filename, block.offset);
+    while (reader.HasLine()) {
+      lines.push_back(reader.GetLine());
+    }
+  }
+  return lines;
+}
+
+std::string MakeUrl(std::string name) {
+  return "file:///tmp/xyz_local_block_reader_test_" + std::to_string(getpid()) + "/" + name;
+}
+
+TEST_F(TestLocalBlockReader, Lines) {
+  // the 2nd line starts right at offset 10
+  std::vector<std::string> expected{"123456789", "a", "", "bcdefghijklmnopqrstuvwxyz", "", "last"};
+  std::string content;
+  for (auto& line : expected) {
+    content += line + "\n";
+  }
+  content.pop_back();  // no trailing newline
+  auto url = MakeUrl("lines");
+  LocalWriter().Write(url, content.data(), content.size());
+
+  for (size_t block_size : {1, 2, 3, 5, 10, 11, 100}) {
+    int num_blocks;
+    EXPECT_EQ(ReadAll(url, block_size, &num_blocks), expected) << block_size;
+    EXPECT_EQ(num_blocks, (content.size() + block_size - 1) / block_size);
+  }
+  remove(url.substr(7).c_str());
+}
+
+TEST_F(TestLocalBlockReader, Directory) {
+  auto url = MakeUrl("dir");
+  LocalWriter().Write(url + "/b", "3\n4\n", 4);
+  LocalWriter().Write(url + "/a", "1\n2\n", 4);
+  LocalWriter().Write(url + "/empty", "", 0);
+  int num_blocks;
+  EXPECT_EQ(ReadAll(url, 3, &num_blocks), std::vector<std::string>({"1", "2", "3", "4"}));
+  EXPECT_EQ(num_blocks, 4);
+
+  LocalBlockReader reader;
+  reader.Init(url + "/a", 0);
+  EXPECT_EQ(reader.ReadBlock(), std::vector<std::string>({"1", "2"}));
+  LocalBlockReader empty_reader;
+  empty_reader.Init(url + "/empty", 0);
+  EXPECT_FALSE(empty_reader.HasLine());
+  for (auto name : {"/a", "/b", "/empty", ""}) {
+    remove((url + name).substr(7).c_str());
+  }
+}
+
+} // namespace
+} // namespace xyz
@@ -0,0 +1,55 @@
+#include "io/local_browser.hpp"
+
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+
+#include "io/local_url.hpp"
+
+namespace xyz {
+
+LocalBrowser::LocalBrowser(size_t block_size) : block_size_(block_size) {
+  CHECK_GT(block_size_, 0);
+  char hostname[256];
+  CHECK_EQ(gethostname(hostname, sizeof(hostname)), 0);
+  hostname[sizeof(hostname) - 1] = '\0';
+  hostname_ = hostname;
+}
+
+std::vector<BlockInfo> LocalBrowser::Browse(std::string url) {
+  const std::string path = GetLocalPath(url);
+  struct stat st;
+  CHECK_EQ(stat(path.c_str(), &st), 0) << "url: " << url << " does not exist";
+
+  // file name -> size
+  std::vector<std::pair<std::string, size_t>> files;
+  if (S_ISREG(st.st_mode)) {
+    files.push_back({path, st.st_size});
+  } else {
+    CHECK(S_ISDIR(st.st_mode)) << "not a file or directory: " << url;
+    DIR *dir = opendir(path.c_str());
+    CHECK(dir) << "cannot open directory: " << url;
+    while (struct dirent *entry = readdir(dir)) {
+      std::string name = path + "/" + entry->d_name;
+      struct stat file_st;
+      if (stat(name.c_str(), &file_st) == 0 && S_ISREG(file_st.st_mode)) {
+        files.push_back({name, file_st.st_size});
+      }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+  }
+
+  std::vector<BlockInfo> rets;
+  for (auto &file : files) {
+    for (size_t k = 0; k < file.second; k += block_size_) {
+      rets.push_back(BlockInfo{kLocalScheme + file.first, k, hostname_});
+    }
+  }
+  return rets;
+}
+
+} // namespace xyz
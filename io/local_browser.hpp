@@ -0,0 +1,21 @@
+#pragma once
+
+#include "io/abstract_browser.hpp"
+#include "io/local_block_reader.hpp"
+
+namespace xyz {
+
+// Split a local file, or the files in a local directory, into blocks.
+// The blocks are on this host, a shared disk has no locality anyway.
+class LocalBrowser : public AbstractBrowser {
+public:
+  explicit LocalBrowser(size_t block_size = LocalBlockReader::kDefaultBlockSize);
+  virtual ~LocalBrowser() {}
+  virtual std::vector<BlockInfo> Browse(std::string url) override;
+
+private:
+  const size_t block_size_;
+  std::string hostname_;
+};
+
+} // namespace xyz
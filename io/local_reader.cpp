@@ -0,0 +1,41 @@
+#include "io/local_reader.hpp"
+
+#include <cstdio>
+#include <sys/stat.h>
+
+#include "glog/logging.h"
+
+#include "io/local_url.hpp"
+
+namespace xyz {
+
+void LocalReader::Init(std::string url) {
+  url = GetLocalPath(url);
+  url_ = url;
+  struct stat st;
+  CHECK_EQ(stat(url.c_str(), &st), 0) << "cannot stat file: " << url;
+  CHECK(S_ISREG(st.st_mode)) << "not a file: " << url;
+  file_size_ = st.st_size;
+}
+
+size_t LocalReader::GetFileSize() {
+  return file_size_;
+}
+
+int LocalReader::Read(void *buffer, size_t len) {
+  CHECK_LE(len, file_size_);
+  FILE* file = fopen(url_.c_str(), "rb");
+  CHECK(file) << "cannot open file: " << url_;
+  size_t num_read = fread(buffer, 1, len, file);
+  CHECK_EQ(num_read, len);
+  fclose(file);
+  return 0;
+}
+
+bool LocalReader::Exists(std::string url) {
+  url = GetLocalPath(url);
+  struct stat st;
+  return stat(url.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+} // namespace xyz
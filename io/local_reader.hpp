@@ -0,0 +1,21 @@
+#pragma once
+
+#include "io/abstract_reader.hpp"
+
+namespace xyz {
+
+// Read a local file, the url is a path or a file:// url.
+class LocalReader : public AbstractReader {
+public:
+  virtual void Init(std::string url) override;
+  virtual size_t GetFileSize() override;
+  virtual int Read(void *buffer, size_t len) override;
+
+  static bool Exists(std::string url);
+
+private:
+  std::string url_;
+  size_t file_size_ = 0;
+};
+
+} // namespace xyz
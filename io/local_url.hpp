@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace xyz {
+
+// the urls with this scheme are on the local filesystem, or on a shared
+// disk mounted at the same path on every node, the others are on hdfs
+const char kLocalScheme[] = "file://";
+
+inline bool IsLocalUrl(const std::string &url) {
+  return url.compare(0, sizeof(kLocalScheme) - 1, kLocalScheme) == 0;
+}
+
+// the path of a local url, a url without the scheme is a path already
+inline std::string GetLocalPath(const std::string &url) {
+  return IsLocalUrl(url) ? url.substr(sizeof(kLocalScheme) - 1) : url;
+}
+
+} // namespace xyz
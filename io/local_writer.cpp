@@ -0,0 +1,50 @@
+#include "io/local_writer.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <sys/stat.h>
+
+#include "glog/logging.h"
+
+#include "io/local_url.hpp"
+
+namespace xyz {
+
+namespace {
+
+// mkdir -p
+void CreateDirectories(std::string dir) {
+  for (size_t pos = dir.find('/', 1); ; pos = dir.find('/', pos + 1)) {
+    std::string sub = dir.substr(0, pos);
+    int rc = mkdir(sub.c_str(), 0755);
+    CHECK(rc == 0 || errno == EEXIST) << "cannot create directory: " << sub;
+    if (pos == std::string::npos) {
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+int LocalWriter::Write(std::string dest_url, const void *buffer, size_t len) {
+  dest_url = GetLocalPath(dest_url);
+  auto pos = dest_url.find_last_of("/");
+  if (pos != std::string::npos && pos != 0) {
+    CreateDirectories(dest_url.substr(0, pos));
+  }
+  // write to a tmp file and rename, a file is either complete or absent
+  std::string tmp_url = dest_url + ".tmp";
+  FILE* file = fopen(tmp_url.c_str(), "wb");
+  CHECK(file) << "cannot open file: " << tmp_url;
+  if (len > 0) {
+    size_t num_written = fwrite(buffer, 1, len, file);
+    CHECK_EQ(num_written, len);
+  }
+  int rc = fclose(file);
+  CHECK_EQ(rc, 0);
+  rc = rename(tmp_url.c_str(), dest_url.c_str());
+  CHECK_EQ(rc, 0) << "cannot rename " << tmp_url << " to " << dest_url;
+  return 0;
+}
+
+} // namespace xyz
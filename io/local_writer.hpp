@@ -0,0 +1,15 @@
+#pragma once
+
+#include "io/abstract_writer.hpp"
+
+namespace xyz {
+
+// Write to a local file, the url is a path or a file:// url, the
+// directories are created if needed.
+class LocalWriter : public AbstractWriter {
+public:
+  virtual int Write(std::string dest_url, const void *buffer,
+                    size_t len) override;
+};
+
+} // namespace xyz
@@ -0,0 +1,30 @@
+#include "io/reader_wrapper.hpp"
+
+#include "glog/logging.h"
+
+#include "io/local_reader.hpp"
+#include "io/local_url.hpp"
+
+namespace xyz {
+
+void ReaderWrapper::Init(std::string url) {
+  if (IsLocalUrl(url)) {
+    reader_ = std::make_shared<LocalReader>();
+  } else {
+    CHECK(hdfs_reader_getter_) << "no reader for url: " << url;
+    reader_ = hdfs_reader_getter_();
+  }
+  reader_->Init(url);
+}
+
+size_t ReaderWrapper::GetFileSize() {
+  CHECK(reader_) << "call Init first";
+  return reader_->GetFileSize();
+}
+
+int ReaderWrapper::Read(void *buffer, size_t len) {
+  CHECK(reader_) << "call Init first";
+  return reader_->Read(buffer, len);
+}
+
+} // namespace xyz
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "io/abstract_reader.hpp"
+
+namespace xyz {
+
+// Read a file:// url with the LocalReader and the others with the reader
+// from hdfs_reader_getter, which is created only if needed.
+class ReaderWrapper : public AbstractReader {
+public:
+  ReaderWrapper(std::function<std::shared_ptr<AbstractReader>()> hdfs_reader_getter)
+      : hdfs_reader_getter_(hdfs_reader_getter) {}
+  virtual void Init(std::string url) override;
+  virtual size_t GetFileSize() override;
+  virtual int Read(void *buffer, size_t len) override;
+
+private:
+  std::function<std::shared_ptr<AbstractReader>()> hdfs_reader_getter_;
+  std::shared_ptr<AbstractReader> reader_;
+};
+
+} // namespace xyz
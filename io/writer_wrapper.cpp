@@ -0,0 +1,21 @@
+#include "io/writer_wrapper.hpp"
+
+#include "glog/logging.h"
+
+#include "io/local_url.hpp"
+#include "io/local_writer.hpp"
+
+namespace xyz {
+
+int WriterWrapper::Write(std::string dest_url, const void *buffer, size_t len) {
+  if (IsLocalUrl(dest_url)) {
+    return LocalWriter().Write(dest_url, buffer, len);
+  }
+  if (!hdfs_writer_) {
+    CHECK(hdfs_writer_getter_) << "no writer for url: " << dest_url;
+    hdfs_writer_ = hdfs_writer_getter_();
+  }
+  return hdfs_writer_->Write(dest_url, buffer, len);
+}
+
+} // namespace xyz
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "io/abstract_writer.hpp"
+
+namespace xyz {
+
+// Write a file:// url with the LocalWriter and the others with the writer
+// from hdfs_writer_getter, which is created only if needed.
+class WriterWrapper : public AbstractWriter {
+public:
+  WriterWrapper(std::function<std::shared_ptr<AbstractWriter>()> hdfs_writer_getter)
+      : hdfs_writer_getter_(hdfs_writer_getter) {}
+  virtual int Write(std::string dest_url, const void *buffer,
+                    size_t len) override;
+
+private:
+  std::function<std::shared_ptr<AbstractWriter>()> hdfs_writer_getter_;
+  std::shared_ptr<AbstractWriter> hdfs_writer_;
+};
+
+} // namespace xyz